@@ -4,6 +4,7 @@
 
 pub mod circuit_data;
 pub mod lcd_display_impl;
+pub mod telemetry;
 pub mod uart;
 
 pub use circuit_data::Circuit_Data;
@@ -1,6 +1,7 @@
 mod circuit_data;
 mod database;
 mod lcd_display_impl;
+mod telemetry;
 mod uart;
 mod web_server;
 
@@ -76,8 +77,11 @@ fn main() {
 
 	// UART
 	let uart_port_name: String = "/dev/ttyS4".to_string();
-	let uart_baud_rate: u32 = 9600;
-	let uart_port = UART_Port::new(&uart_port_name, uart_baud_rate);
+	// SCI_FREQ of the firmware build (peripheral_Setup.h): rate at power-up and after a fallback
+	let uart_baud_rate: u32 = if cfg!(feature = "waveform_stream") { 230400 } else { 9600 };
+	let uart_max_baud_rate: u32 = 921600;
+	let uart_port = UART_Port::new(&uart_port_name, uart_baud_rate)
+		.with_max_baud_rate(uart_max_baud_rate);
 	uart_port.start(Arc::clone(&shared_data));
 
 
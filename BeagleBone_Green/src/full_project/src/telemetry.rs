@@ -0,0 +1,540 @@
+/*
+	telemetry.rs
+
+	Decoder of the binary telemetry frames of the F28379D
+	(TELEMETRY_FORMAT == TELEMETRY_BINARY, see telemetry.h):
+
+		COBS( header | payload | CRC16-CCITT ) 0x00
+
+		header: version << 4 | type, sequence (u8)
+		multi-byte fields are little-endian
+
+	Status frames carry the low 16 bits of the firmware tick count (ms),
+	extended to 32 bits from the previous frame: the count wraps every
+	65.5 s, far longer than the status period. Info frames carry the full
+	count and re-anchor the extension after a gap longer than a wrap
+*/
+
+pub const TELEMETRY_VERSION: u8 = 2;
+
+const HEADER_SIZE: usize = 2;
+const CRC_SIZE: usize = 2;
+const MAX_FRAME: usize = 256;
+
+const FRAME_INFO: u8 = 0;
+const FRAME_STATUS: u8 = 1;
+pub const FRAME_LINK_REQUEST: u8 = 3;
+const FRAME_LINK_ACK: u8 = 4;
+const FRAME_LINK_TEST: u8 = 5;
+pub const FRAME_LINK_CONFIRM: u8 = 6;
+
+const INFO_SIZE: usize = 22;
+const STATUS_SIZE: usize = 10;
+const LINK_ACK_SIZE: usize = 5;
+const LINK_PATTERN_SIZE: usize = 48;
+
+/*
+	Scale factors of the ADC codes and the firmware time
+	Defaults are the firmware constants, replaced by every Info frame
+*/
+#[allow(non_camel_case_types)]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Telemetry_Info {
+	pub setpoint_scale: f32,
+	pub voltage_scale: f32,
+	pub current_scale: f32,
+	pub input_scale: f32,
+	pub pwm_period: u16,
+	pub tick_ms: u32
+}
+
+impl Default for Telemetry_Info {
+	fn default() -> Self {
+		Telemetry_Info {
+			setpoint_scale: 10.0 / 4095.0,
+			voltage_scale: 0.0060,
+			current_scale: 0.6300,
+			input_scale: 0.0045,
+			pwm_period: 2500,
+			tick_ms: 0
+		}
+	}
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Telemetry_Status {
+	pub sequence: u8,
+	pub tick_ms: u32,			// Firmware tick count, extended to 32 bits
+
+	pub setpoint_code: u16,
+	pub voltage_code: u16,
+	pub current_code: u16,
+	pub input_code: u16,
+	pub cmpa: u16,
+	pub system_on: bool,
+	pub controller: u8,
+
+	pub setpoint: f64,
+	pub voltage: f64,
+	pub current: f64,
+	pub input: f64,
+	pub duty_cycle: f64
+}
+
+impl Telemetry_Status {
+	// Uptime of the firmware as HH:MM:SS
+	pub fn uptime(&self) -> String {
+		let seconds = self.tick_ms / 1000;
+		format!("{:02}:{:02}:{:02}", seconds / 3600, (seconds / 60) % 60, seconds % 60)
+	}
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Telemetry_Frame {
+	Info(Telemetry_Info),
+	Status(Telemetry_Status),
+	LinkAck { baud: u32, accepted: bool },
+	LinkTest { valid: bool }
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct Telemetry_Stats {
+	pub frames: u64,
+	pub crc_errors: u64,
+	pub framing_errors: u64,	// Bad COBS, length, version or type
+	pub lost: u64				// Frames missing from the sequence numbers
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug, Default)]
+pub struct Telemetry_Decoder {
+	buffer: Vec<u8>,
+	overflow: bool,
+	last_sequence: Option<u8>,
+	tick_ms: Option<u32>,		// Tick count of the last Info or Status frame
+	pub info: Telemetry_Info,
+	pub stats: Telemetry_Stats
+}
+
+pub fn crc16(data: &[u8]) -> u16 {
+	let mut crc: u16 = 0xFFFF;
+	for &byte in data {
+		crc ^= (byte as u16) << 8;
+		for _ in 0..8 {
+			crc = if crc & 0x8000 != 0 { (crc << 1) ^ 0x1021 } else { crc << 1 };
+		}
+	}
+	crc
+}
+
+pub fn cobs_encode(data: &[u8]) -> Vec<u8> {
+	let mut output = Vec::with_capacity(data.len() + data.len() / 254 + 2);
+	// Each run of non-zero bytes between zeros, split in chunks of 254:
+	// a code below 0xFF stands for the zero after its chunk
+	for block in data.split(|&byte| byte == 0) {
+		for chunk in block.chunks(254) {
+			output.push(chunk.len() as u8 + 1);
+			output.extend_from_slice(chunk);
+		}
+		if block.len() % 254 == 0 {
+			output.push(1);
+		}
+	}
+	output
+}
+
+pub fn cobs_decode(data: &[u8]) -> Option<Vec<u8>> {
+	let mut output = Vec::with_capacity(data.len());
+	let mut index = 0;
+
+	while index < data.len() {
+		let code = data[index] as usize;
+		if code == 0 || index + code > data.len() {
+			return None;
+		}
+		output.extend_from_slice(&data[index + 1..index + code]);
+		index += code;
+		if code < 0xFF && index < data.len() {
+			output.push(0);
+		}
+	}
+	Some(output)
+}
+
+// Test pattern of the baud rate negotiation (uart_link_pattern() in uart_link.h)
+pub fn link_pattern(index: usize) -> u8 {
+	const HEAD: [u8; 4] = [0x00, 0xFF, 0x55, 0xAA];
+	if index < 4 { HEAD[index] } else { ((index * 167 + 13) & 0xFF) as u8 }
+}
+
+// Frame to the firmware, COBS encoded with the 0x00 delimiter
+pub fn encode_frame(frame_type: u8, sequence: u8, payload: &[u8]) -> Vec<u8> {
+	let mut frame = Vec::with_capacity(HEADER_SIZE + payload.len() + CRC_SIZE);
+	frame.push((TELEMETRY_VERSION << 4) | (frame_type & 0x0F));
+	frame.push(sequence);
+	frame.extend_from_slice(payload);
+	let crc = crc16(&frame);
+	frame.extend_from_slice(&crc.to_le_bytes());
+
+	let mut encoded = cobs_encode(&frame);
+	encoded.push(0);
+	encoded
+}
+
+fn read_u16(data: &[u8]) -> u16 {
+	u16::from_le_bytes([data[0], data[1]])
+}
+
+fn read_u32(data: &[u8]) -> u32 {
+	u32::from_le_bytes([data[0], data[1], data[2], data[3]])
+}
+
+fn read_f32(data: &[u8]) -> f32 {
+	f32::from_bits(read_u32(data))
+}
+
+impl Telemetry_Decoder {
+	pub fn new() -> Self {
+		Telemetry_Decoder::default()
+	}
+
+	// Drop a partial frame, e.g. bytes received at the previous rate
+	pub fn resync(&mut self) {
+		self.buffer.clear();
+		self.overflow = false;
+	}
+
+	/*
+		Feed one received byte, returns a frame on every valid delimiter
+		Corrupted frames are counted and dropped: decoding restarts at
+		the next 0x00
+	*/
+	pub fn push(&mut self, byte: u8) -> Option<Telemetry_Frame> {
+		if byte != 0 {
+			if self.buffer.len() < MAX_FRAME {
+				self.buffer.push(byte);
+			}
+			else {
+				self.overflow = true;
+			}
+			return None;
+		}
+
+		let encoded = std::mem::take(&mut self.buffer);
+		let overflow = std::mem::replace(&mut self.overflow, false);
+		if encoded.is_empty() {
+			return None;
+		}
+		if overflow {
+			self.stats.framing_errors += 1;
+			return None;
+		}
+
+		let frame = match cobs_decode(&encoded) {
+			Some(frame) if frame.len() >= HEADER_SIZE + CRC_SIZE => frame,
+			_ => {
+				self.stats.framing_errors += 1;
+				return None;
+			}
+		};
+
+		let (body, crc) = frame.split_at(frame.len() - CRC_SIZE);
+		if crc16(body) != read_u16(crc) {
+			self.stats.crc_errors += 1;
+			return None;
+		}
+
+		if body[0] >> 4 != TELEMETRY_VERSION {
+			self.stats.framing_errors += 1;
+			return None;
+		}
+
+		let sequence = body[1];
+		let payload = &body[HEADER_SIZE..];
+
+		if let Some(last) = self.last_sequence {
+			self.stats.lost += sequence.wrapping_sub(last).wrapping_sub(1) as u64;
+		}
+		self.last_sequence = Some(sequence);
+		self.stats.frames += 1;
+
+		let decoded = match (body[0] & 0x0F, payload.len()) {
+			(FRAME_INFO, INFO_SIZE) => {
+				self.info = Telemetry_Info {
+					setpoint_scale: read_f32(&payload[0..]),
+					voltage_scale: read_f32(&payload[4..]),
+					current_scale: read_f32(&payload[8..]),
+					input_scale: read_f32(&payload[12..]),
+					pwm_period: read_u16(&payload[16..]),
+					tick_ms: read_u32(&payload[18..])
+				};
+				self.tick_ms = Some(self.info.tick_ms);
+				Telemetry_Frame::Info(self.info)
+			}
+			(FRAME_STATUS, STATUS_SIZE) => {
+				let mut bytes = [0u8; 8];
+				bytes.copy_from_slice(&payload[..8]);
+				let bits = u64::from_le_bytes(bytes);
+				let field = |shift: u32| ((bits >> shift) & 0x0FFF) as u16;
+
+				let setpoint_code = field(0);
+				let voltage_code = field(12);
+				let current_code = field(24);
+				let input_code = field(36);
+				let cmpa = field(48);
+
+				let tick = read_u16(&payload[8..]);
+				let tick_ms = match self.tick_ms {
+					Some(last) => last.wrapping_add(tick.wrapping_sub(last as u16) as u32),
+					None => tick as u32
+				};
+				self.tick_ms = Some(tick_ms);
+
+				Telemetry_Frame::Status(Telemetry_Status {
+					sequence,
+					tick_ms,
+					setpoint_code,
+					voltage_code,
+					current_code,
+					input_code,
+					cmpa,
+					system_on: (bits >> 60) & 0x1 != 0,
+					controller: ((bits >> 61) & 0x7) as u8,
+					setpoint: setpoint_code as f64 * self.info.setpoint_scale as f64,
+					voltage: voltage_code as f64 * self.info.voltage_scale as f64,
+					current: current_code as f64 * self.info.current_scale as f64,
+					input: input_code as f64 * self.info.input_scale as f64,
+					duty_cycle: if self.info.pwm_period > 0 {
+						cmpa as f64 / self.info.pwm_period as f64
+					}
+					else {
+						0.0
+					}
+				})
+			}
+			(FRAME_LINK_ACK, LINK_ACK_SIZE) => Telemetry_Frame::LinkAck {
+				baud: read_u32(payload),
+				accepted: payload[4] != 0
+			},
+			(FRAME_LINK_TEST, _) => Telemetry_Frame::LinkTest {
+				valid: payload.len() == LINK_PATTERN_SIZE &&
+					payload.iter().enumerate().all(|(index, &byte)| byte == link_pattern(index))
+			},
+			(FRAME_INFO, _) | (FRAME_STATUS, _) | (FRAME_LINK_ACK, _) => {
+				self.stats.framing_errors += 1;
+				return None;
+			}
+			// Waveform blocks (tools/waveform_decode.py) and newer frame types
+			_ => return None
+		};
+
+		Some(decoded)
+	}
+}
+
+#[cfg(test)]
+mod tests {
+	use super::*;
+
+	fn status_payload(bits: u64, tick: u16) -> [u8; STATUS_SIZE] {
+		let mut payload = [0u8; STATUS_SIZE];
+		payload[..8].copy_from_slice(&bits.to_le_bytes());
+		payload[8..].copy_from_slice(&tick.to_le_bytes());
+		payload
+	}
+
+	fn status_ticks(decoder: &mut Telemetry_Decoder, frames: &[Vec<u8>]) -> Vec<u32> {
+		frames.iter().flat_map(|frame| feed(decoder, frame)).filter_map(|frame| match frame {
+			Telemetry_Frame::Status(status) => Some(status.tick_ms),
+			_ => None
+		}).collect()
+	}
+
+	fn info_payload(tick_ms: u32) -> Vec<u8> {
+		let mut payload = Vec::new();
+		for scale in [0.001f32, 0.002, 0.003, 0.004] {
+			payload.extend_from_slice(&scale.to_le_bytes());
+		}
+		payload.extend_from_slice(&1000u16.to_le_bytes());
+		payload.extend_from_slice(&tick_ms.to_le_bytes());
+		payload
+	}
+
+	fn feed(decoder: &mut Telemetry_Decoder, bytes: &[u8]) -> Vec<Telemetry_Frame> {
+		bytes.iter().filter_map(|&byte| decoder.push(byte)).collect()
+	}
+
+	#[test]
+	fn cobs_round_trip() {
+		let mut long_run = vec![0x11u8; 600];
+		long_run[300] = 0;
+		let cases: Vec<Vec<u8>> = vec![
+			vec![],
+			vec![0],
+			vec![0, 0],
+			vec![1, 2, 3],
+			vec![0, 1, 0, 2, 0],
+			vec![0x22; 254],
+			vec![0x33; 255],
+			long_run
+		];
+
+		for data in cases {
+			let encoded = cobs_encode(&data);
+			assert!(!encoded.contains(&0), "zero in the encoding of {:?}", data);
+			assert_eq!(cobs_decode(&encoded), Some(data));
+		}
+	}
+
+	#[test]
+	fn crc16_check_value() {
+		// CRC-16/CCITT-FALSE of "123456789"
+		assert_eq!(crc16(b"123456789"), 0x29B1);
+	}
+
+	#[test]
+	fn status_round_trip() {
+		let mut decoder = Telemetry_Decoder::new();
+		let bits: u64 = 0x123 | (0x456 << 12) | (0x789 << 24) | (0xABC << 36) | (500 << 48) | (1 << 60) | (2 << 61);
+
+		let mut bytes = encode_frame(FRAME_INFO, 0, &info_payload(3_600_000));
+		bytes.extend(encode_frame(FRAME_STATUS, 1, &status_payload(bits, (3_600_250u32 & 0xFFFF) as u16)));
+		let frames = feed(&mut decoder, &bytes);
+
+		assert_eq!(frames.len(), 2);
+		assert!(matches!(frames[0], Telemetry_Frame::Info(info) if info.pwm_period == 1000));
+		match frames[1] {
+			Telemetry_Frame::Status(status) => {
+				assert_eq!(status.sequence, 1);
+				assert_eq!(status.setpoint_code, 0x123);
+				assert_eq!(status.voltage_code, 0x456);
+				assert_eq!(status.current_code, 0x789);
+				assert_eq!(status.input_code, 0xABC);
+				assert_eq!(status.cmpa, 500);
+				assert!(status.system_on);
+				assert_eq!(status.controller, 2);
+				assert!((status.duty_cycle - 0.5).abs() < 1e-9);
+				assert!((status.voltage - 0x456 as f64 * 0.002).abs() < 1e-6);
+				assert_eq!(status.tick_ms, 3_600_250);
+				assert_eq!(status.uptime(), "01:00:00");
+			}
+			other => panic!("expected a status frame, got {:?}", other)
+		}
+		assert_eq!(decoder.stats.frames, 2);
+		assert_eq!(decoder.stats.crc_errors, 0);
+		assert_eq!(decoder.stats.framing_errors, 0);
+		assert_eq!(decoder.stats.lost, 0);
+	}
+
+	#[test]
+	fn status_frame_size() {
+		// Header, 10 payload bytes and CRC, one COBS code byte and the delimiter
+		let frame = encode_frame(FRAME_STATUS, 1, &status_payload(0x0102_0304_0506_0708, 1234));
+		assert_eq!(frame.len(), HEADER_SIZE + STATUS_SIZE + CRC_SIZE + 2);
+	}
+
+	#[test]
+	fn tick_extension() {
+		let mut decoder = Telemetry_Decoder::new();
+		let status = |sequence: u8, tick: u32| encode_frame(FRAME_STATUS, sequence, &status_payload(0, tick as u16));
+
+		// Before any Info frame the count starts from the low 16 bits
+		assert_eq!(status_ticks(&mut decoder, &[status(0, 65_000), status(1, 66_036)]), vec![65_000, 66_036]);
+
+		// Info re-anchors, the status frames then cross the wrap of their 16 bits
+		let frames = [
+			encode_frame(FRAME_INFO, 2, &info_payload(0x0002_FF00)),
+			status(3, 0x0002_FF00),
+			status(4, 0x0003_0010),
+			status(5, 0x0003_4000)
+		];
+		assert_eq!(status_ticks(&mut decoder, &frames), vec![0x0002_FF00, 0x0003_0010, 0x0003_4000]);
+	}
+
+	#[test]
+	fn tick_without_info() {
+		let mut decoder = Telemetry_Decoder::new();
+		let mut frames = vec![encode_frame(FRAME_INFO, 0, &info_payload(10_000_000))];
+		// Info frames lost: the status frames keep the firmware count over
+		// several wraps, 4 s apart
+		for n in 1..=40u32 {
+			frames.push(encode_frame(FRAME_STATUS, n as u8, &status_payload(0, (10_000_000 + n * 4000) as u16)));
+		}
+
+		let ticks = status_ticks(&mut decoder, &frames);
+		assert_eq!(ticks.len(), 40);
+		assert_eq!(ticks[39], 10_160_000);
+		assert!(ticks.windows(2).all(|pair| pair[1] - pair[0] == 4000));
+	}
+
+	#[test]
+	fn corrupted_crc() {
+		let mut decoder = Telemetry_Decoder::new();
+		let mut bytes = encode_frame(FRAME_STATUS, 0, &status_payload(0x0123_4567_89AB_CDEF, 1234));
+		// Flip a payload bit, keeping the byte non-zero so the framing holds
+		bytes[5] ^= 0x01;
+		if bytes[5] == 0 {
+			bytes[5] = 0x80;
+		}
+
+		assert!(feed(&mut decoder, &bytes).is_empty());
+		assert_eq!(decoder.stats.crc_errors, 1);
+		assert_eq!(decoder.stats.frames, 0);
+
+		// The next frame decodes after the delimiter
+		let frames = feed(&mut decoder, &encode_frame(FRAME_STATUS, 1, &status_payload(0x0FFF, 1234)));
+		assert_eq!(frames.len(), 1);
+		assert_eq!(decoder.stats.frames, 1);
+	}
+
+	#[test]
+	fn truncated_frame() {
+		let mut decoder = Telemetry_Decoder::new();
+		let full = encode_frame(FRAME_STATUS, 0, &status_payload(0x0123_4567_89AB_CDEF, 1234));
+
+		// Bytes lost before the delimiter: the COBS code points past the end
+		let mut truncated = full[..full.len() - 4].to_vec();
+		truncated.push(0);
+		assert!(feed(&mut decoder, &truncated).is_empty());
+		assert_eq!(decoder.stats.framing_errors, 1);
+
+		// Shorter than a header and a CRC
+		assert!(feed(&mut decoder, &[0x03, 0x21, 0x01, 0x00]).is_empty());
+		assert_eq!(decoder.stats.framing_errors, 2);
+
+		// A valid frame with a short payload for its type
+		let short = encode_frame(FRAME_STATUS, 1, &[1, 2, 3]);
+		assert!(feed(&mut decoder, &short).is_empty());
+		assert_eq!(decoder.stats.framing_errors, 3);
+		assert_eq!(decoder.stats.crc_errors, 0);
+	}
+
+	#[test]
+	fn lost_frames_across_wrap() {
+		let mut decoder = Telemetry_Decoder::new();
+		let payload = status_payload(0, 1234);
+		let mut bytes = encode_frame(FRAME_STATUS, 254, &payload);
+		bytes.extend(encode_frame(FRAME_STATUS, 255, &payload));
+		bytes.extend(encode_frame(FRAME_STATUS, 2, &payload));
+
+		assert_eq!(feed(&mut decoder, &bytes).len(), 3);
+		assert_eq!(decoder.stats.lost, 2);
+	}
+
+	#[test]
+	fn wrong_version() {
+		let mut decoder = Telemetry_Decoder::new();
+		let mut frame = vec![((TELEMETRY_VERSION + 1) << 4) | FRAME_STATUS, 0];
+		frame.extend_from_slice(&status_payload(0x0FFF, 1234));
+		let crc = crc16(&frame);
+		frame.extend_from_slice(&crc.to_le_bytes());
+		let mut bytes = cobs_encode(&frame);
+		bytes.push(0);
+
+		assert!(feed(&mut decoder, &bytes).is_empty());
+		assert_eq!(decoder.stats.framing_errors, 1);
+	}
+}
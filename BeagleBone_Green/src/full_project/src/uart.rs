@@ -3,6 +3,13 @@
 */
 
 use crate::Circuit_Data;
+use crate::telemetry::{
+	FRAME_LINK_CONFIRM,
+	FRAME_LINK_REQUEST,
+	Telemetry_Decoder,
+	Telemetry_Frame,
+	encode_frame
+};
 
 use std::sync::{
 	Arc,
@@ -11,94 +18,225 @@ use std::sync::{
 
 use chrono::Local;
 
+use serialport::{
+	ClearBuffer,
+	SerialPort
+};
+
 use std::io::Read;
 
-use std::time::Duration;
+use std::time::{
+	Duration,
+	Instant
+};
+
+// Rates tried by the negotiation, fastest first (see uart_link.h on the F28379D)
+const LINK_RATES: [u32; 5] = [921600, 460800, 230400, 115200, 57600];
+
+const LINK_ANSWER_TIMEOUT: Duration = Duration::from_millis(1000);
+const LINK_REVERT_DELAY: Duration = Duration::from_millis(600);		// Firmware UART_LINK_CONFIRM_TIMEOUT and margin
+const LINK_KEEPALIVE: Duration = Duration::from_secs(1);
+const LINK_TIMEOUT: Duration = Duration::from_secs(10);				// No valid frame: back to the base rate
+const LINK_RETRY: Duration = Duration::from_secs(30);				// At the base rate: negotiate again
 
 #[allow(non_camel_case_types)]
 #[derive(Debug)]
 pub struct UART_Port {
 	port_name: String,
-	baud_rate: u32
+	baud_rate: u32,
+	max_baud_rate: u32
+}
+
+// Link frame to the firmware: the rate, little-endian. A leading
+// delimiter ends whatever the firmware received before (noise, a
+// frame cut by a rate change)
+fn send_link_frame(uart_port: &mut dyn SerialPort, frame_type: u8, sequence: &mut u8, baud_rate: u32) {
+	let mut frame = vec![0u8];
+	frame.extend(encode_frame(frame_type, *sequence, &baud_rate.to_le_bytes()));
+	*sequence = sequence.wrapping_add(1);
+
+	if let Err(error) = uart_port.write_all(&frame) {
+		println!("[WARN] UART write failed: {}", error);
+	}
+}
+
+// Read until a frame gives an answer or the timeout expires
+fn wait_for<T>(
+	uart_port: &mut dyn SerialPort,
+	decoder: &mut Telemetry_Decoder,
+	answer: impl Fn(&Telemetry_Frame) -> Option<T>
+) -> Option<T> {
+	let deadline = Instant::now() + LINK_ANSWER_TIMEOUT;
+	let mut buffer = [0u8; 256];
+
+	while Instant::now() < deadline {
+		if let Ok(size) = uart_port.read(&mut buffer) {
+			for &byte in &buffer[..size] {
+				if let Some(result) = decoder.push(byte).as_ref().and_then(&answer) {
+					return Some(result);
+				}
+			}
+		}
+	}
+	None
 }
 
 impl UART_Port {
 	pub fn new(port_name: &str, baud_rate: u32) -> Self {
 		UART_Port {
 			port_name: port_name.to_string(),
-			baud_rate
+			baud_rate,
+			max_baud_rate: baud_rate
 		}
 	}
 
+	// Negotiate up to max_baud_rate with the firmware, baud_rate stays the fallback
+	pub fn with_max_baud_rate(mut self, max_baud_rate: u32) -> Self {
+		self.max_baud_rate = max_baud_rate;
+		self
+	}
+
+	/*
+		Try the rates from the fastest: request, switch on the
+		acknowledge, confirm a valid test pattern. Returns the rate the
+		port is left at
+	*/
+	fn negotiate(&self, uart_port: &mut dyn SerialPort, decoder: &mut Telemetry_Decoder, sequence: &mut u8) -> u32 {
+		let rates = LINK_RATES.iter().filter(|&&rate| rate <= self.max_baud_rate && rate > self.baud_rate);
+
+		for &rate in rates {
+			send_link_frame(uart_port, FRAME_LINK_REQUEST, sequence, rate);
+
+			let accepted = wait_for(uart_port, decoder, |frame| match *frame {
+				Telemetry_Frame::LinkAck { baud, accepted } if baud == rate => Some(accepted),
+				_ => None
+			});
+
+			match accepted {
+				Some(true) => {}
+				Some(false) => continue,
+				None => {
+					println!("[WARN] No answer to the rate request, staying at {} baud", self.baud_rate);
+					return self.baud_rate;
+				}
+			}
+
+			if uart_port.set_baud_rate(rate).is_ok() {
+				let _ = uart_port.clear(ClearBuffer::Input);
+				decoder.resync();
+
+				let valid = wait_for(uart_port, decoder, |frame| match *frame {
+					Telemetry_Frame::LinkTest { valid } => Some(valid),
+					_ => None
+				});
+
+				if valid == Some(true) {
+					send_link_frame(uart_port, FRAME_LINK_CONFIRM, sequence, rate);
+					println!("[INFO] UART link negotiated at '{}' baud!", rate);
+					return rate;
+				}
+			}
+
+			// The firmware returns to the base rate without a confirmation
+			println!("[WARN] UART test at {} baud failed", rate);
+			let _ = uart_port.set_baud_rate(self.baud_rate);
+			std::thread::sleep(LINK_REVERT_DELAY);
+			let _ = uart_port.clear(ClearBuffer::Input);
+			decoder.resync();
+		}
+
+		self.baud_rate
+	}
+
 	pub fn start(self, shared_data: Arc<Mutex<Circuit_Data>>) {
 		std::thread::spawn(move || {
 			let mut uart_port = serialport::new(&self.port_name, self.baud_rate)
-				.timeout(Duration::from_secs(1))
+				.timeout(Duration::from_millis(100))
 				.open()
 				.expect("Could not open UART port!");
 
 			println!("[INFO] UART '{}' initialized at '{}' baud!", self.port_name, self.baud_rate);
 
-			let mut buffer = [0u8; 32];
+			// NOTE: the firmware must be built with
+			// TELEMETRY_FORMAT == TELEMETRY_BINARY:
+			// COBS framed status frames, see telemetry.rs
+			let mut decoder = Telemetry_Decoder::new();
+			let mut sequence: u8 = 0;
+			let mut baud_rate = self.baud_rate;
+
+			let mut last_attempt: Option<Instant> = None;
+			let mut last_frame = Instant::now();
+			let mut last_keepalive = Instant::now();
+
+			let mut buffer = [0u8; 256];
 			loop {
+				// At the base rate: negotiate a faster one
+				if baud_rate == self.baud_rate &&
+					self.max_baud_rate > self.baud_rate &&
+					last_attempt.is_none_or(|attempt| attempt.elapsed() >= LINK_RETRY) {
+					baud_rate = self.negotiate(&mut *uart_port, &mut decoder, &mut sequence);
+					last_attempt = Some(Instant::now());
+					last_frame = Instant::now();
+					last_keepalive = Instant::now();
+				}
+
 				match uart_port.read(&mut buffer) {
 					Ok(size) if size > 0 => {
-						// NOTE: this code assumes that the
-						// UART will receive data as follows:
-						// 12.5,12.7,108.5,472
-						// <expected_voltage>,
-						// <circuit_voltage>
-						// <circuit_current>
-						// <circuit_uptime_secs>
-						if let Ok(message) = std::str::from_utf8(&buffer[..size]) {
-							let parts: Vec<&str> = message.trim().split(",").collect();
-							if parts.len() == 2 {
-								let (
-									Ok(_),
-									Ok(message_circuit_uptime)
-								) = (
-									parts[0].parse::<String>(),
-									parts[1].parse::<String>()
-								);
-								let mut data = shared_data.lock().unwrap();
-								data.circuit_state = "OFF".to_string();
-								data.expected_voltage = 0.0;
-								data.circuit_voltage = 0.0;
-								data.circuit_current = 0.0;
-								data.circuit_uptime = message_circuit_uptime;
-								data.received_timestamp = Local::now().format("%Y-%m-%d_%H:%M:%S").to_string();
-								data.insertion_timestamp = Local::now().format("%Y-%m-%d_%H:%M:%S").to_string();
-							}
-							else if parts.len() == 4 {
-								if let (
-									Ok(message_expected_voltage),
-									Ok(message_circuit_voltage),
-									Ok(message_circuit_current),
-									Ok(message_circuit_uptime)
-								) = (
-									parts[0].parse::<f64>(),
-									parts[1].parse::<f64>(),
-									parts[2].parse::<f64>(),
-									parts[3].parse::<String>()
-								) {
+						for &byte in &buffer[..size] {
+							let frame = match decoder.push(byte) {
+								Some(frame) => frame,
+								None => continue
+							};
+							last_frame = Instant::now();
+
+							match frame {
+								Telemetry_Frame::Status(status) => {
 									let mut data = shared_data.lock().unwrap();
-									data.circuit_state = "ON".to_string();
-									data.expected_voltage = message_expected_voltage;
-									data.circuit_voltage = message_circuit_voltage;
-									data.circuit_current = message_circuit_current;
-									data.circuit_uptime = message_circuit_uptime.to_string();
+									if status.system_on {
+										data.circuit_state = "ON".to_string();
+										data.expected_voltage = status.setpoint;
+										data.circuit_voltage = status.voltage;
+										data.circuit_current = status.current;
+									}
+									else {
+										data.circuit_state = "OFF".to_string();
+										data.expected_voltage = 0.0;
+										data.circuit_voltage = 0.0;
+										data.circuit_current = 0.0;
+									}
+									data.circuit_uptime = status.uptime();
 									data.received_timestamp = Local::now().format("%Y-%m-%d_%H:%M:%S").to_string();
 									data.insertion_timestamp = Local::now().format("%Y-%m-%d_%H:%M:%S").to_string();
 								}
+								Telemetry_Frame::Info(info) => {
+									println!("[INFO] Telemetry scales: {:?}, {:?}", info, decoder.stats);
+								}
+								_ => {
+									//
+								}
 							}
-							println!("[INFO] Message received: {}", message);
 						}
 					}
 					_ => {
 						//
 					}
 				}
-				buffer = [0u8; 32];
+
+				// Above the base rate: keep the firmware there, or fall back
+				if baud_rate != self.baud_rate {
+					if last_keepalive.elapsed() >= LINK_KEEPALIVE {
+						send_link_frame(&mut *uart_port, FRAME_LINK_CONFIRM, &mut sequence, baud_rate);
+						last_keepalive = Instant::now();
+					}
+
+					if last_frame.elapsed() >= LINK_TIMEOUT {
+						println!("[WARN] UART link lost at {} baud, back to {} baud", baud_rate, self.baud_rate);
+						let _ = uart_port.set_baud_rate(self.baud_rate);
+						decoder.resync();
+						baud_rate = self.baud_rate;
+						last_attempt = None;
+					}
+				}
 			}
 		});
 	}
@@ -0,0 +1,55 @@
+/* CPU2 RAM linker command file (main_cpu2.c)
+ * Local RAM only, the global shared RAM is left to CPU1. The NN_IPC
+ * regions must match 2837xD_RAM_lnk_cpu1.cmd */
+
+MEMORY
+{
+PAGE 0 :
+   /* BEGIN is used for the "boot to SARAM" bootloader mode   */
+
+   BEGIN            : origin = 0x000000, length = 0x000002
+   RAMM0            : origin = 0x000123, length = 0x0002DD
+   RAMD0            : origin = 0x00B000, length = 0x000800
+   RAMLS0_2         : origin = 0x008000, length = 0x001800
+   RESET            : origin = 0x3FFFC0, length = 0x000002
+
+PAGE 1 :
+
+   BOOT_RSVD        : origin = 0x000002, length = 0x000121     /* Part of M0, BOOT rom will use this for stack */
+   RAMM1            : origin = 0x000400, length = 0x0003F8     /* on-chip RAM block M1 */
+   RAMD1            : origin = 0x00B800, length = 0x000800
+   RAMLS3_5         : origin = 0x009800, length = 0x001800
+
+   CPU2TOCPU1RAM     : origin = 0x03F800, length = 0x000200
+   NN_IPC_CPU2TOCPU1 : origin = 0x03FA00, length = 0x000200    /* nn_ipc_status */
+   CPU1TOCPU2RAM     : origin = 0x03FC00, length = 0x000200
+   NN_IPC_CPU1TOCPU2 : origin = 0x03FE00, length = 0x000200    /* nn_ipc_command */
+}
+
+
+SECTIONS
+{
+   codestart        : > BEGIN,                        PAGE = 0
+   .text            : >> RAMLS0_2 | RAMD0,            PAGE = 0
+   .cinit           : > RAMM0,                        PAGE = 0
+   .switch          : > RAMM0,                        PAGE = 0
+   .reset           : > RESET,                        PAGE = 0, TYPE = DSECT /* not used, */
+   .stack           : > RAMM1,                        PAGE = 1
+
+#if defined(__TI_EABI__)
+   .bss             : > RAMLS3_5,                     PAGE = 1
+   .init_array      : > RAMM0,                        PAGE = 0
+   .const           : > RAMLS3_5,                     PAGE = 1
+   .data            : > RAMLS3_5,                     PAGE = 1
+   .sysmem          : > RAMD1,                        PAGE = 1
+#else
+   .pinit           : > RAMM0,                        PAGE = 0
+   .ebss            : > RAMLS3_5,                     PAGE = 1
+   .econst          : > RAMLS3_5,                     PAGE = 1
+   .esysmem         : > RAMD1,                        PAGE = 1
+#endif
+
+   /* Neural Network training link (nn_ipc.c), written by the other core */
+   NNIpcCpu1ToCpu2  : > NN_IPC_CPU1TOCPU2,            PAGE = 1, type = NOINIT
+   NNIpcCpu2ToCpu1  : > NN_IPC_CPU2TOCPU1,            PAGE = 1, type = NOINIT
+}
@@ -0,0 +1,43 @@
+/**
+ * @file main_cpu2.c
+ * @brief CPU2 application: Neural Network training (NN_TRAINING_CPU2)
+ *
+ * CPU1 runs the control loop and the inference, and queues the training
+ * samples in the IPC message RAM; this image trains its own copy of the
+ * network on them and posts the weights back (nn_ipc.h).
+ *
+ * Built with ../F28379D_Project/nn_ipc.c, the F28379D_Project
+ * firmware_GlobalVariableDefs.c, 2837xD_RAM_lnk_cpu2.cmd and
+ * F2837xD_Headers_nonBIOS_cpu2.cmd, with CPU2 defined (see README).
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "nn_ipc.h"
+
+/**
+ * @brief Weights trained by CPU2, loaded by CPU1 through the message RAM
+ */
+static NeuralNetwork network;
+
+/**
+ * @brief CPU2 entry point
+ *        Waits for CPU1 to post the initial weights, then trains for as
+ *        long as samples are queued
+ */
+void main(void) {
+    // The CPU2 watchdog is enabled at reset (DisableDog)
+    EALLOW;
+    WdRegs.WDCR.all = 0x0068;
+    EDIS;
+
+    // Wait for nn_ipc_init on CPU1
+    while (!(IpcRegs.IPCSTS.all & NN_IPC_FLAG));
+
+    nn_ipc_cpu2_init();
+    IpcRegs.IPCACK.all = NN_IPC_FLAG;
+
+    for (;;)
+        nn_ipc_train(&network);
+}
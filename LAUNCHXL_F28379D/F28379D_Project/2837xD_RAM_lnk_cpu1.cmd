@@ -1,4 +1,9 @@
 
+/* CLA C compiler scratchpad (local variables and arguments of the CLA tasks) */
+CLA_SCRATCHPAD_SIZE = 0x100;
+--undef_sym=__cla_scratchpad_end
+--undef_sym=__cla_scratchpad_start
+
 MEMORY
 {
 PAGE 0 :
@@ -12,8 +17,8 @@ PAGE 0 :
    //RAMLS1           : origin = 0x008800, length = 0x000800
    //RAMLS2           : origin = 0x009000, length = 0x000800
    //RAMLS3           : origin = 0x009800, length = 0x000800
-   //RAMLS4           : origin = 0x00A000, length = 0x000800
-   RAMLS0_4         : origin = 0x008000, length = 0x002800
+   RAMLS0_2         : origin = 0x008000, length = 0x001800
+   RAMLS4           : origin = 0x00A000, length = 0x000800     /* CLA program (cla_init) */
 
 
    RESET            : origin = 0x3FFFC0, length = 0x000002
@@ -31,8 +36,8 @@ PAGE 0 :
    FLASHJ           : origin = 0x0B0000, length = 0x008000	/* on-chip Flash */
    FLASHK           : origin = 0x0B8000, length = 0x002000	/* on-chip Flash */
    FLASHL           : origin = 0x0BA000, length = 0x002000	/* on-chip Flash */
-   FLASHM           : origin = 0x0BC000, length = 0x002000	/* on-chip Flash */
-   FLASHN           : origin = 0x0BE000, length = 0x001FF0	/* on-chip Flash */
+   FLASHM           : origin = 0x0BC000, length = 0x002000	/* on-chip Flash, reserved for NN weight snapshots (nn_snapshot.h) */
+   FLASHN           : origin = 0x0BE000, length = 0x001FF0	/* on-chip Flash, reserved for NN weight snapshots (nn_snapshot.h) */
 
 //   FLASHN_RSVD     : origin = 0x0BFFF0, length = 0x000010    /* Reserve and do not use for code as per the errata advisory "Memory: Prefetching Beyond Valid Memory" */
 
@@ -40,9 +45,12 @@ PAGE 1 :
 
    BOOT_RSVD       : origin = 0x000002, length = 0x000121     /* Part of M0, BOOT rom will use this for stack */
    RAMM1           : origin = 0x000400, length = 0x0003F8     /* on-chip RAM block M1 */
+   CLA1_MSGRAMLOW  : origin = 0x001480, length = 0x000080     /* CLA1 to CPU message RAM */
+   CLA1_MSGRAMHIGH : origin = 0x001500, length = 0x000080     /* CPU to CLA1 message RAM */
 //   RAMM1_RSVD      : origin = 0x0007F8, length = 0x000008     /* Reserve and do not use for code as per the errata advisory "Memory: Prefetching Beyond Valid Memory" */
 
 
+   RAMLS3      : origin = 0x009800, length = 0x000800     /* CLA data (cla_init) */
    RAMLS5      : origin = 0x00A800, length = 0x000800
 
    RAMGS0      : origin = 0x00C000, length = 0x001000
@@ -70,8 +78,10 @@ PAGE 1 :
 //   RAMGS15_RSVD : origin = 0x01BFF8, length = 0x000008    /* Reserve and do not use for code as per the errata advisory "Memory: Prefetching Beyond Valid Memory" */
                                                             /* Only on F28379D, F28377D, F28375D devices. Remove line on other devices. */
 
-   CPU2TOCPU1RAM   : origin = 0x03F800, length = 0x000400
-   CPU1TOCPU2RAM   : origin = 0x03FC00, length = 0x000400
+   CPU2TOCPU1RAM   : origin = 0x03F800, length = 0x000200
+   NN_IPC_CPU2TOCPU1 : origin = 0x03FA00, length = 0x000200   /* NN training status (nn_ipc.h), same in 2837xD_RAM_lnk_cpu2.cmd */
+   CPU1TOCPU2RAM   : origin = 0x03FC00, length = 0x000200
+   NN_IPC_CPU1TOCPU2 : origin = 0x03FE00, length = 0x000200   /* NN training samples (nn_ipc.h), same in 2837xD_RAM_lnk_cpu2.cmd */
 
    CANA_MSG_RAM     : origin = 0x049000, length = 0x000800
    CANB_MSG_RAM     : origin = 0x04B000, length = 0x000800
@@ -142,6 +152,25 @@ SECTIONS
    MSGRAM_CPU1_TO_CPU2 > CPU1TOCPU2RAM, type = NOINIT
    MSGRAM_CPU2_TO_CPU1 > CPU2TOCPU1RAM, type = NOINIT
 
+   /* NN training on CPU2 (nn_ipc.h) */
+   NNIpcCpu1ToCpu2  : > NN_IPC_CPU1TOCPU2,            PAGE = 1, type = NOINIT
+   NNIpcCpu2ToCpu1  : > NN_IPC_CPU2TOCPU1,            PAGE = 1, type = NOINIT
+
+   /* CLA program, data and message RAMs (cla_control.h) */
+   Cla1Prog         : > RAMLS4,                       PAGE = 0
+   CLADataLS        : > RAMLS3,                       PAGE = 1
+   Cla1ToCpuMsgRAM  : > CLA1_MSGRAMLOW,               PAGE = 1
+   CpuToCla1MsgRAM  : > CLA1_MSGRAMHIGH,              PAGE = 1
+
+   /* CLA C compiler sections, in memory the CLA can write */
+   CLAscratch       :
+                     { *.obj(CLAscratch)
+                     . += CLA_SCRATCHPAD_SIZE;
+                     *.obj(CLAscratch_end) } > RAMLS3,  PAGE = 1
+   .scratchpad      : > RAMLS3,                       PAGE = 1
+   .bss_cla         : > RAMLS3,                       PAGE = 1
+   .const_cla       : > RAMLS3,                       PAGE = 1
+
 }
 
 /*
@@ -45,13 +45,21 @@
 #define configMINIMAL_STACK_SIZE            ( ( unsigned short ) 128 )
 #define configTOTAL_HEAP_SIZE               ( ( size_t ) ( 17 * 1024 ) )
 #define configMAX_TASK_NAME_LEN             ( 8 )
-#define configUSE_TRACE_FACILITY            0
+#define configUSE_TRACE_FACILITY            1
 #define configUSE_16_BIT_TICKS              0
 #define configIDLE_SHOULD_YIELD             0
 #define configCHECK_FOR_STACK_OVERFLOW      2
 #define configSUPPORT_STATIC_ALLOCATION     1
 #define configSUPPORT_DYNAMIC_ALLOCATION    0
 
+// Run time statistics (uxTaskGetSystemState) counted on the CPU Timer1
+// timebase, 1 us resolution. Timer1 is started by interrupt_init, before
+// the scheduler. The counters wrap with the timebase, every ~71.6 minutes.
+#define configGENERATE_RUN_TIME_STATS       1
+extern uint32_t timebase_run_time(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()    timebase_run_time()
+
 // Set the following definitions to 1 to include the API function, or zero
 // to exclude the API function.
 #define INCLUDE_uxTaskGetStackHighWaterMark 1
@@ -60,7 +68,7 @@
 #define INCLUDE_vTaskDelete                 0
 #define INCLUDE_vTaskCleanUpResources       0
 #define INCLUDE_vTaskSuspend                0
-#define INCLUDE_vTaskDelayUntil             0
+#define INCLUDE_vTaskDelayUntil             1
 #define INCLUDE_vTaskDelay                  1
 
 #endif /* FREERTOS_CONFIG_H */
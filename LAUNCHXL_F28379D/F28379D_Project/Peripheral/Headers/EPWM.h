@@ -55,6 +55,12 @@ ________________________________________________________________________________
             ePWM_HSPCLKDIV_14
         }ePWM_HSPCLKDIV;
 
+        typedef enum ePWM_SOC_EVENTO{
+            SOC_CTR_ZERO = 0x1,         //  SOC gerado quando CTR = 0 (centro do pulso ligado com portadora UP_DOWN)
+            SOC_CTR_PRD,                //  SOC gerado quando CTR = TBPRD (centro do pulso desligado)
+            SOC_CTR_ZERO_PRD            //  SOC gerado em CTR = 0 e em CTR = TBPRD
+        }ePWM_SOC_EVENTO;
+
 
         //---> Defini��o de Macros para facilitar o uso do pwm
         #define EPWM1_Modulante_CMPA EPwm1Regs.CMPA.bit.CMPA
@@ -92,6 +98,7 @@ ________________________________________________________________________________
         void ConfigPhasePWM(ePWM_modulos SAIDA_EPWM, Uint16 Fase_graus);
         void ConfigFreqPWM(ePWM_modulos SAIDA_EPWM, Uint16 freq);
         void ConfigDeadBandPWM(ePWM_modulos SAIDA_EPWM, Uint16 tred, Uint16 tfed);
+        void ConfigSocPWM(ePWM_modulos SAIDA_EPWM, ePWM_SOC_EVENTO EVENTO, Uint16 prescale);
         void AqctlARegConfig(ePWM_modulos SAIDA_EPWM, Uint16 AQ_CAU, Uint16 AQ_CAD, Uint16 AQ_CBU, Uint16 AQ_CBD , Uint16 AQ_ZRO, Uint16 AQ_PRD);
         void AqctlBRegConfig(ePWM_modulos SAIDA_EPWM, Uint16 AQ_CAU, Uint16 AQ_CAD, Uint16 AQ_CBU, Uint16 AQ_CBD , Uint16 AQ_ZRO, Uint16 AQ_PRD);
         void ConfigSyncPWMs(void);
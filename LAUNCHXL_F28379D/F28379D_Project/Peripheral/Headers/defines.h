@@ -78,7 +78,7 @@ ____________________________________________________________________________*/
 
 /*----------------------------    Interrup��es    ----------------------------*/
     /* Definir quantas interrup��es ser�o usadas*/
-    #define MAX_INT 2
+    #define MAX_INT 3
 
     /* Comentar os grupos de interrup��es que N�O ser�o usados */
     #define ATIVAR_INT_GRUPO_1
@@ -88,7 +88,7 @@ ____________________________________________________________________________*/
 //    #define ATIVAR_INT_GRUPO_5
 //    #define ATIVAR_INT_GRUPO_6
 //    #define ATIVAR_INT_GRUPO_7
-//    #define ATIVAR_INT_GRUPO_8
+    #define ATIVAR_INT_GRUPO_8
 //    #define ATIVAR_INT_GRUPO_9
 //    #define ATIVAR_INT_GRUPO_10
 //    #define ATIVAR_INT_GRUPO_11
@@ -724,6 +724,47 @@ void ConfigEPwm_REF(ePWM_modulos SAIDA_EPWM, ePWM_HSPCLKDIV CLKDIV1, ePWM_CLKDIV
 }
 
 
+/*---------------------------------------------------------------------------
+ * ConfigSocPWM:
+ *---------------------------------------------------------------------------
+ *        Configura o sinal EPWMxSOCA de um módulo PWM para disparar as conversões
+ *      do ADC de forma sincronizada com a portadora.
+ *
+ *  Parâmetros:
+ *      ePWM_modulos SAIDA_EPWM:    Módulo ePWM sendo configurado
+ *      ePWM_SOC_EVENTO EVENTO:     Evento da portadora que gera o SOC [SOC_CTR_ZERO, SOC_CTR_PRD, SOC_CTR_ZERO_PRD]
+ *      Uint16 prescale:            Gera o SOC a cada 'prescale' eventos [1 ~ 15]
+ *
+ *        Com a portadora UP_DOWN, amostrar em CTR = 0 ou CTR = TBPRD coloca a amostra
+ *      no centro do pulso, onde a corrente no indutor é igual ao seu valor médio.
+ *        Os SOCs do ADC devem ser configurados com TRIG_EPWMx_ADCSOCA.
+ *
+ *      Exemplo:
+ *      ConfigSocPWM(EPWM1, SOC_CTR_ZERO, 1);
+ */
+void ConfigSocPWM(ePWM_modulos SAIDA_EPWM, ePWM_SOC_EVENTO EVENTO, Uint16 prescale){
+
+    if (prescale < 1)
+        prescale = 1;
+    if (prescale > 15)
+        prescale = 15;
+
+    EALLOW;                                                                         //  Permite escrita em registradores protegidos
+
+        EPWM_PTR[SAIDA_EPWM]->ETSEL.bit.SOCAEN = 0;                                 //  Desabilita o SOCA durante a configuração
+        EPWM_PTR[SAIDA_EPWM]->ETSEL.bit.SOCASELCMP = 0;                             //  Eventos de CMPA/CMPB (não CMPC/CMPD) quando SOCASEL usa comparadores
+        EPWM_PTR[SAIDA_EPWM]->ETSEL.bit.SOCASEL = EVENTO;                           //  Evento da portadora que gera o SOCA
+
+        EPWM_PTR[SAIDA_EPWM]->ETPS.bit.SOCPSSEL = 1;                                //  Usa ETSOCPS (prescale de 4 bits, até 15 eventos)
+        EPWM_PTR[SAIDA_EPWM]->ETSOCPS.bit.SOCAPRD2 = prescale;                      //  Gera o SOCA a cada 'prescale' eventos
+        EPWM_PTR[SAIDA_EPWM]->ETCLR.bit.SOCA = 1;                                   //  Limpa algum SOCA pendente
+
+        EPWM_PTR[SAIDA_EPWM]->ETSEL.bit.SOCAEN = 1;                                 //  Habilita o SOCA
+
+    EDIS;                                                                           //  Desabilita escrita em registradores protegidos
+}
+
+
 /*---------------------------------------------------------------------------
  * ConfigPWM_Bipolar:
  *---------------------------------------------------------------------------
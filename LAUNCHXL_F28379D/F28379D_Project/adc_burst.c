@@ -0,0 +1,142 @@
+/**
+ * @file adc_burst.c
+ * @brief Implementation of the per-channel SOC configuration and of the
+ *        ADC noise characterization
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "adc_burst.h"
+
+#include <math.h>
+
+/**
+ * @brief Result registers of one channel of the noise characterization
+ */
+typedef struct {
+    volatile uint16_t *results;     // First result of the burst
+    uint16_t count;                 // SOCs per conversion
+} AdcNoiseSource;
+
+// ADC module registers, indexed by Conversores_ADC (firmware_Adc.c)
+extern volatile struct ADC_REGS* ADC_PTR[5];
+
+AdcNoise adc_noise = {0};
+
+// Same order as AdcNoiseChannel, SOCs as configured by adc_init
+static const AdcNoiseSource adc_noise_sources[ADC_NOISE_CHANNELS] = {
+    {&AdcaResultRegs.ADCRESULT0, 1},
+    {&AdcbResultRegs.ADCRESULT0 + ADC_INPUT_SOC, 1},
+    {&AdcbResultRegs.ADCRESULT0, ADC_BURST_SIZE},
+    {&AdccResultRegs.ADCRESULT0, ADC_BURST_SIZE}
+};
+
+/**
+ * @brief Configure count consecutive SOCs of one ADC on the same channel
+ *        SOCs first to first + count - 1 convert channel on trigger with an
+ *        acquisition window of acqps + 1 SYSCLK cycles; the ADC converts
+ *        them back to back. adc_int, unless ADC_INT_OFF, is set at the EOC
+ *        of the last one
+ * @param adc ADC module
+ * @param channel Input channel
+ * @param first First SOC, also the first result register
+ * @param count SOCs
+ * @param trigger Start-of-conversion source
+ * @param acqps Acquisition window (ACQPS), ADC_ACQPS_MIN or longer
+ * @param adc_int ADC interrupt at the end of the burst, or ADC_INT_OFF
+ * @return void
+ */
+void adc_channel_setup(Conversores_ADC adc, Canais_ADC channel, Resultados_ADC first, uint16_t count,
+                       ADC_TRIG trigger, uint16_t acqps, ADC_INT adc_int) {
+    volatile union ADCSOC0CTL_REG *control = &ADC_PTR[adc]->ADCSOC0CTL;
+    uint16_t last = first + count - 1;
+    uint16_t soc;
+
+    for (soc = first; soc < last; soc++)
+        SetupADC(adc, channel, (Resultados_ADC)soc, trigger, ADC_INT_OFF, INT_OFF);
+
+    SetupADC(adc, channel, (Resultados_ADC)last, trigger, adc_int, (ADC_INT_SOURCE)last);
+
+    // SetupADC sets the minimum window of the resolution
+    EALLOW;
+        for (soc = first; soc <= last; soc++)
+            control[soc].bit.ACQPS = acqps;
+    EDIS;
+
+    return;
+}
+
+/**
+ * @brief Noise of one channel over the completed window
+ *        The variances are taken from n^2 times their value, exact in
+ *        64-bit integers, so the mean does not cancel in float
+ * @param result Destination
+ * @param accumulator Sums of the window, cleared afterwards
+ * @param count SOCs per conversion of the channel
+ * @return void
+ */
+static void adc_noise_result(AdcNoiseResult *result, AdcNoiseAccumulator *accumulator, uint16_t count) {
+    uint64_t samples = (uint64_t)ADC_NOISE_WINDOW * count;
+    uint64_t square_of_sum = accumulator->sum * accumulator->sum;
+    float variance;
+
+    result->mean = (float)accumulator->sum / (float)samples;
+    result->variance = (float)(samples * accumulator->squares - square_of_sum)
+                     / ((float)samples * (float)samples);
+
+    variance = (float)(ADC_NOISE_WINDOW * accumulator->burst_squares - square_of_sum)
+             / ((float)ADC_NOISE_WINDOW * (float)ADC_NOISE_WINDOW * (float)count * (float)count);
+    result->variance_average = variance;
+
+    // Against the quantization noise of an ideal ADC, 1/12 LSB^2
+    result->enob = ADC_NOISE_ENOB_MAX;
+    if (variance > 0.0f)
+        result->enob = ADC_NOISE_BITS - 0.5f * logf(12.0f * variance) / 0.6931472f;
+    if (result->enob > ADC_NOISE_ENOB_MAX)
+        result->enob = ADC_NOISE_ENOB_MAX;
+
+    accumulator->sum = 0;
+    accumulator->squares = 0;
+    accumulator->burst_squares = 0;
+
+    return;
+}
+
+/**
+ * @brief Accumulate the codes of the last conversion of every channel
+ *        Called by adcc1_isr with ADC_NOISE_CHARACTERIZATION; every
+ *        ADC_NOISE_WINDOW conversions the results of the window are stored
+ *        in adc_noise.result
+ * @return void
+ */
+void adc_noise_step(void) {
+    AdcNoiseAccumulator *accumulator;
+    uint32_t burst, code;
+    uint16_t channel, x;
+
+    for (channel = 0; channel < ADC_NOISE_CHANNELS; channel++) {
+        accumulator = &adc_noise.accumulator[channel];
+        burst = 0;
+
+        for (x = 0; x < adc_noise_sources[channel].count; x++) {
+            code = adc_noise_sources[channel].results[x];
+            burst += code;
+            accumulator->squares += code * code;
+        }
+
+        accumulator->sum += burst;
+        accumulator->burst_squares += burst * burst;
+    }
+
+    if (++adc_noise.conversions < ADC_NOISE_WINDOW)
+        return;
+
+    for (channel = 0; channel < ADC_NOISE_CHANNELS; channel++)
+        adc_noise_result(&adc_noise.result[channel], &adc_noise.accumulator[channel],
+                         adc_noise_sources[channel].count);
+
+    adc_noise.conversions = 0;
+    adc_noise.windows++;
+
+    return;
+}
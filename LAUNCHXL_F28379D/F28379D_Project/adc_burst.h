@@ -0,0 +1,102 @@
+/**
+ * @file adc_burst.h
+ * @brief Per-channel SOC configuration, burst oversampling and ADC noise
+ *        characterization
+ *        With ADC_ACQUISITION_BURST, Tensao_DC and Corrente_carga take
+ *        ADC_BURST_SIZE consecutive SOCs each on the carrier trigger; the
+ *        ADC converts them back to back and the channel table
+ *        (adc_channels.h) sums the results, ADC_BURST_SHIFT bits wider
+ *        than one code
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef ADC_BURST_H
+#define ADC_BURST_H
+
+    #include "peripheral_Setup.h"
+
+    #include <stdint.h>
+
+    // Tensao_DC and Corrente_carga SOCs per conversion with ADC_ACQUISITION_BURST:
+    // 1 << ADC_BURST_SHIFT, up to 3 (8 SOCs, ADCB also takes the input voltage)
+    #define ADC_BURST_SHIFT         2
+
+    #if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_BURST)
+        #define ADC_BURST_SIZE      (1 << ADC_BURST_SHIFT)
+    #else
+        #define ADC_BURST_SIZE      1
+    #endif
+
+    #if (ADC_BURST_SIZE > 8)
+        #error "ADCB has 16 SOCs: ADC_BURST_SIZE for Tensao_DC and one for the input voltage"
+    #endif
+
+    // Input voltage SOC on ADCB, after the Tensao_DC SOCs
+    #define ADC_INPUT_SOC           ADC_BURST_SIZE
+
+    // ADC noise characterization: adcc1_isr accumulates the codes of every
+    // channel over ADC_NOISE_WINDOW conversions and stores the variance and
+    // ENOB of each in adc_noise. Feed a steady input (DC source, converter off)
+    // #define ADC_NOISE_CHARACTERIZATION
+    #define ADC_NOISE_WINDOW        4096    // Conversions per result, power of two
+    #define ADC_NOISE_BITS          12      // ADC resolution
+    #define ADC_NOISE_ENOB_MAX      16.0f   // Reported when no noise is seen
+
+    #if (ADC_NOISE_WINDOW & (ADC_NOISE_WINDOW - 1))
+        #error "ADC_NOISE_WINDOW must be a power of two"
+    #endif
+
+    /**
+     * @brief Channels of the noise characterization
+     */
+    typedef enum {
+        ADC_NOISE_SETPOINT = 0,
+        ADC_NOISE_INPUT,
+        ADC_NOISE_VOLTAGE,
+        ADC_NOISE_CURRENT,
+        ADC_NOISE_CHANNELS
+    } AdcNoiseChannel;
+
+    /**
+     * @brief Running sums of one channel over the current window
+     *        squares is over the single codes, burst_squares over the
+     *        per-conversion sums of the burst
+     */
+    typedef struct {
+        uint64_t sum;
+        uint64_t squares;
+        uint64_t burst_squares;
+    } AdcNoiseAccumulator;
+
+    /**
+     * @brief Noise of one channel over the last window
+     *        enob follows from the variance of the averaged result: a burst
+     *        of uncorrelated noise adds half a bit per doubling
+     */
+    typedef struct {
+        float mean;                     // Code
+        float variance;                 // Single conversion (LSB^2)
+        float variance_average;         // Burst average (LSB^2)
+        float enob;                     // Effective bits of the burst average
+    } AdcNoiseResult;
+
+    /**
+     * @brief ADC noise characterization state (ADC_NOISE_CHARACTERIZATION)
+     */
+    typedef struct {
+        AdcNoiseAccumulator accumulator[ADC_NOISE_CHANNELS];
+        AdcNoiseResult result[ADC_NOISE_CHANNELS];
+        uint16_t conversions;           // In the current window
+        uint32_t windows;               // Completed windows
+    } AdcNoise;
+
+    extern AdcNoise adc_noise;
+
+    // Function prototypes
+    void adc_channel_setup(Conversores_ADC adc, Canais_ADC channel, Resultados_ADC first, uint16_t count,
+                           ADC_TRIG trigger, uint16_t acqps, ADC_INT adc_int);
+
+    void adc_noise_step(void);
+
+#endif /* ADC_BURST_H */
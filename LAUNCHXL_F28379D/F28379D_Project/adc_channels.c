@@ -0,0 +1,16 @@
+/**
+ * @file adc_channels.c
+ * @brief Channel description arrays of the table-driven acquisition
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "adc_channels.h"
+
+#define ADC_CHANNEL_GAIN(name, results, samples, gain, offset, coupling, code, value)      gain,
+#define ADC_CHANNEL_OFFSET(name, results, samples, gain, offset, coupling, code, value)    offset,
+#define ADC_CHANNEL_COUPLING(name, results, samples, gain, offset, coupling, code, value)  coupling,
+
+const float adc_channel_gain[ADC_CHANNELS] = { ADC_CHANNEL_TABLE(ADC_CHANNEL_GAIN) };
+const int16_t adc_channel_offset[ADC_CHANNELS] = { ADC_CHANNEL_TABLE(ADC_CHANNEL_OFFSET) };
+const Acoplamento adc_channel_coupling[ADC_CHANNELS] = { ADC_CHANNEL_TABLE(ADC_CHANNEL_COUPLING) };
@@ -0,0 +1,108 @@
+/**
+ * @file adc_channels.h
+ * @brief Table-driven acquisition of the ADC channels
+ *        Every sensor is one row of ADC_CHANNEL_TABLE: where its samples
+ *        are, how many are summed per conversion, its gain, offset and
+ *        coupling, and where its code and value go. The table is expanded
+ *        into the AdcChannel indices, the description arrays and
+ *        adc_channels_sample, a straight-line sampling function with the
+ *        row constants as immediate operands. Each row stores its results
+ *        straight into the variables the acquisition reads (MEDIDA,
+ *        input_monitor, setpoint_filter), with no intermediate copy
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef ADC_CHANNELS_H
+#define ADC_CHANNELS_H
+
+    #include "peripheral_Setup.h"
+    #include "adc_dma.h"
+    #include "adc_burst.h"
+
+    #include <stdint.h>
+
+    // First result register of a channel: module (Adca .. Adcd) and SOC
+    #define ADC_RESULT(module, soc)     (&module##ResultRegs.ADCRESULT0 + (soc))
+
+    // Tensao_DC comes from the DMA block with ADC_ACQUISITION_DMA
+    #if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+        #define ADC_VOLTAGE_RESULTS     adc_dma_buffer[adc_dma.half]
+        #define ADC_VOLTAGE_SAMPLES     ADC_DMA_OVERSAMPLING
+    #else
+        #define ADC_VOLTAGE_RESULTS     ADC_RESULT(Adcb, RESULT0)
+        #define ADC_VOLTAGE_SAMPLES     ADC_BURST_SIZE
+    #endif
+
+    // Channel table, one row per sensor. adc_init configures the SOCs
+    //  name:     AdcChannel index; Tensao_DC and Corrente_carga first, as in MEDIDA
+    //  results:  first sample of the conversion
+    //  samples:  samples summed per conversion, a power of two
+    //  gain:     value per code
+    //  offset:   code of a zero value
+    //  coupling: DC or AC (Acoplamento)
+    //  code:     destination of the average code (12 bits)
+    //  value:    destination of the scaled value
+    #define ADC_CHANNEL_TABLE(CHANNEL) \
+        CHANNEL(ADC_CHANNEL_VOLTAGE,  ADC_VOLTAGE_RESULTS,             ADC_VOLTAGE_SAMPLES, VOLTAGE_CONVERSION_FACTOR, 0, DC, \
+                medidasADC.leituras_dig[Tensao_DC],      medidasADC.valor_real[Tensao_DC]) \
+        CHANNEL(ADC_CHANNEL_CURRENT,  ADC_RESULT(Adcc, RESULT0),       ADC_BURST_SIZE,      CURRENT_CONVERSION_FACTOR, 0, AC, \
+                medidasADC.leituras_dig[Corrente_carga], medidasADC.valor_real[Corrente_carga]) \
+        CHANNEL(ADC_CHANNEL_INPUT,    ADC_RESULT(Adcb, ADC_INPUT_SOC), 1,                   INPUT_CONVERSION_FACTOR,   0, DC, \
+                input_monitor.raw,                       input_monitor.voltage) \
+        CHANNEL(ADC_CHANNEL_SETPOINT, ADC_RESULT(Adca, RESULT0),       1,                   MAX_VOLTAGE / MAX_ADC,     0, DC, \
+                setpoint_filter.raw,                     setpoint_filter.sample)
+
+    #define ADC_CHANNEL_ENUM(name, results, samples, gain, offset, coupling, code, value)   name,
+
+    typedef enum {
+        ADC_CHANNEL_TABLE(ADC_CHANNEL_ENUM)
+        ADC_CHANNELS
+    } AdcChannel;
+
+    // Channel description, from the table
+    extern const float adc_channel_gain[ADC_CHANNELS];
+    extern const int16_t adc_channel_offset[ADC_CHANNELS];
+    extern const Acoplamento adc_channel_coupling[ADC_CHANNELS];
+
+    /**
+     * @brief Sum of the samples of one conversion
+     *        samples is a constant in every row, so the loop unrolls
+     *        completely into loads and adds
+     * @param results First sample
+     * @param samples Samples
+     * @return uint32_t Sum of the codes
+     */
+    static inline uint32_t adc_channel_sum(volatile uint16_t *results, uint16_t samples) {
+        uint32_t sum = 0;
+        uint16_t x;
+
+        for (x = 0; x < samples; x++)
+            sum += results[x];
+
+        return sum;
+    }
+
+    // One row of adc_channels_sample: the division by samples is a shift,
+    // the scale factors fold into constants. The value is gain * (average
+    // - offset) from the sum, so it keeps the bits the oversampling adds
+    #define ADC_CHANNEL_SAMPLE(name, results, samples, gain, offset, coupling, code, value) \
+        sum = adc_channel_sum(results, samples); \
+        code = sum / (samples); \
+        value = sum * ((gain) / (samples)) - (offset) * (gain);
+
+    /**
+     * @brief Read, average and scale every channel of the table into its
+     *        destinations
+     *        Called by adcc1_isr once the conversion is complete
+     * @return void
+     */
+    static inline void adc_channels_sample(void) {
+        uint32_t sum;
+
+        ADC_CHANNEL_TABLE(ADC_CHANNEL_SAMPLE)
+
+        return;
+    }
+
+#endif /* ADC_CHANNELS_H */
@@ -0,0 +1,49 @@
+/**
+ * @file adc_dma.c
+ * @brief Implementation of the oversampled Tensao_DC acquisition through DMA
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "adc_dma.h"
+
+// The DMA reaches the global shared RAM, not the local RAM
+#pragma DATA_SECTION(adc_dma_buffer, "ramgs0");
+volatile uint16_t adc_dma_buffer[2][ADC_DMA_OVERSAMPLING];
+
+AdcDma adc_dma = {0};
+
+/**
+ * @brief Initialize DMA CH1 for ADC_ACQUISITION_DMA
+ *        One 16-bit word per ADCB ADCINT2 (Tensao_DC EOC, adc_init), from
+ *        ADCRESULT0 into the buffer half in the shadow registers,
+ *        ADC_DMA_OVERSAMPLING words per transfer. The channel restarts
+ *        every transfer (continuous mode) and interrupts at its start,
+ *        entering adcc1_isr (interrupt_init). Called after adc_init and
+ *        pwm_init
+ * @return void
+ */
+void adc_dma_init(void) {
+    adc_dma.address[0] = (uint32_t)(uintptr_t)adc_dma_buffer[0];
+    adc_dma.address[1] = (uint32_t)(uintptr_t)adc_dma_buffer[1];
+    adc_dma.half = 0;
+
+    EALLOW;
+        // ADCINT2 pulses on every EOC, the DMA does not clear the flag
+        AdcbRegs.ADCINTSEL1N2.bit.INT2CONT = 1;
+    EDIS;
+
+    DMAInitialize();
+
+    DMACH1AddrConfig(adc_dma_buffer[0], &AdcbResultRegs.ADCRESULT0);
+    DMACH1BurstConfig(0, 0, 0);
+    DMACH1TransferConfig(ADC_DMA_OVERSAMPLING - 1, 0, 1);
+    DMACH1WrapConfig(0xFFFF, 0, 0xFFFF, 0);
+    DMACH1ModeConfig(DMA_ADCBINT2, PERINT_ENABLE, ONESHOT_DISABLE, CONT_ENABLE,
+                     SYNC_DISABLE, SYNC_SRC, OVRFLOW_DISABLE, SIXTEEN_BIT,
+                     CHINT_BEGIN, CHINT_ENABLE);
+
+    StartDMACH1();
+
+    return;
+}
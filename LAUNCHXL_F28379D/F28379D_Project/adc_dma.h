@@ -0,0 +1,70 @@
+/**
+ * @file adc_dma.h
+ * @brief Oversampled Tensao_DC acquisition through DMA (ADC_ACQUISITION_DMA)
+ *        EPWM2 SOCA converts Tensao_DC ADC_DMA_OVERSAMPLING times per
+ *        carrier period, ADCB ADCINT2 triggers DMA CH1, which moves every
+ *        result into one half of a ping-pong buffer. The CPU is interrupted
+ *        once per block, not once per sample, and the channel table
+ *        (adc_channels.h) averages the completed half
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef ADC_DMA_H
+#define ADC_DMA_H
+
+    #include "peripheral_Setup.h"
+
+    #include <stdint.h>
+
+    // Tensao_DC samples per carrier period: 1 << ADC_DMA_SHIFT, 3 (8x) or 4 (16x)
+    #define ADC_DMA_SHIFT           3
+    #define ADC_DMA_OVERSAMPLING    (1 << ADC_DMA_SHIFT)
+
+    /**
+     * @brief DMA acquisition state and statistics
+     *        half is the last block DMA CH1 has completed, the running
+     *        transfer fills the other one
+     */
+    typedef struct {
+        uint32_t address[2];        // DMA addresses of the buffer halves
+        uint16_t half;
+        uint32_t blocks;            // Blocks taken by adcc1_isr
+        uint32_t overflows;         // ADCINT2 while the previous one was pending
+    } AdcDma;
+
+    extern volatile uint16_t adc_dma_buffer[2][ADC_DMA_OVERSAMPLING];
+    extern AdcDma adc_dma;
+
+    /**
+     * @brief Take the block DMA CH1 has completed and point the transfer
+     *        after the running one at its half
+     *        Called by adcc1_isr, entered at the start of every transfer:
+     *        the running transfer has already loaded its address from the
+     *        shadow registers, and the completed half is not written again
+     *        for one carrier period
+     * @return void
+     */
+    static inline void adc_dma_block(void) {
+        uint16_t completed = adc_dma.half ^ 1;
+
+        EALLOW;
+            DmaRegs.CH1.DST_BEG_ADDR_SHADOW = adc_dma.address[completed];
+            DmaRegs.CH1.DST_ADDR_SHADOW = adc_dma.address[completed];
+
+            if (DmaRegs.CH1.CONTROL.bit.OVRFLG) {
+                DmaRegs.CH1.CONTROL.bit.ERRCLR = 1;
+                adc_dma.overflows++;
+            }
+        EDIS;
+
+        adc_dma.half = completed;
+        adc_dma.blocks++;
+
+        return;
+    }
+
+    // Function prototypes
+    void adc_dma_init(void);
+
+#endif /* ADC_DMA_H */
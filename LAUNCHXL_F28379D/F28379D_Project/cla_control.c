@@ -0,0 +1,126 @@
+/**
+ * @file cla_control.c
+ * @brief C28x side of the CLA control law: message RAM, parameters and
+ *        the check against pi_controller_compute
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "cla_control.h"
+#include "controllers.h"
+
+// Message RAMs and CLA data RAM (2837xD_RAM_lnk_cpu1.cmd)
+#pragma DATA_SECTION(cla_control_input, "CpuToCla1MsgRAM");
+volatile ClaControlInput cla_control_input;
+
+#pragma DATA_SECTION(cla_control_output, "Cla1ToCpuMsgRAM");
+volatile ClaControlOutput cla_control_output;
+
+#pragma DATA_SECTION(cla_pi_state, "CLADataLS");
+volatile ClaPIState cla_pi_state;
+
+ClaErrorCheck cla_error_check = {0};
+
+/**
+ * @brief Load the PI parameters, conversion factors and CMPA scale into
+ *        the CPU to CLA message RAM, with the converter stopped
+ *        Called after pi_controller_init and pwm_init
+ * @return void
+ */
+void cla_control_load(void) {
+    cla_control_input.b0 = pi_controller.b0;
+    cla_control_input.b1 = pi_controller.b1;
+    cla_control_input.a1 = pi_controller.a1;
+    cla_control_input.voltage_factor = VOLTAGE_CONVERSION_FACTOR;
+    cla_control_input.current_factor = CURRENT_CONVERSION_FACTOR;
+    cla_control_input.setpoint = 0.0f;
+    cla_control_input.input_voltage = 0.0f;
+    cla_control_input.pwm_factor = pwm_factor;
+    cla_control_input.run = OFF;
+
+    cla_pi_state.error_old = 0.0f;
+    cla_pi_state.output_old = 0.0f;
+
+    return;
+}
+
+// Verification
+
+/**
+ * @brief Check the CLA control law against the C28x controller
+ *        Sweeps setpoint and voltage code over their range with
+ *        CLA_ERROR_POINTS points each, running cla_control_step and
+ *        pi_controller_compute with the controller_step clamp in lockstep
+ *        from the same state, and stores the largest duty cycle and CMPA
+ *        differences in cla_error_check. Compiled by the C28x (or host)
+ *        compiler: CLA rounding is not covered. Called after pwm_init,
+ *        uses local copies of the message RAM and resets the PI
+ *        controller afterwards.
+ * @return void
+ */
+void controller_cla_error_check(void) {
+    ClaControlInput input;
+    ClaControlOutput output = {0};
+    ClaPIState state = {0};
+    uint16_t voltage_code, cmpa;
+    float setpoint, voltage, duty, diff;
+    int s, v;
+
+    cla_error_check.duty_max_error = 0.0f;
+    cla_error_check.cmpa_max_error = 0;
+    cla_error_check.points = 0;
+
+    pi_controller_init();
+
+    input.b0 = pi_controller.b0;
+    input.b1 = pi_controller.b1;
+    input.a1 = pi_controller.a1;
+    input.voltage_factor = VOLTAGE_CONVERSION_FACTOR;
+    input.current_factor = CURRENT_CONVERSION_FACTOR;
+    input.input_voltage = MAX_VOLTAGE;
+    input.pwm_factor = pwm_factor;
+
+    for (s = 0; s < CLA_ERROR_POINTS; s++) {
+        setpoint = 0.95f * MAX_VOLTAGE * s / (CLA_ERROR_POINTS - 1);
+        input.setpoint = setpoint;
+
+        // Stopped: both controllers reset
+        input.run = OFF;
+        cla_control_step(&input, &state, &output, 0, 0);
+        pi_controller_reset();
+        input.run = ON;
+
+        for (v = 0; v < CLA_ERROR_POINTS; v++) {
+            voltage_code = (uint16_t)(MAX_ADC * v / (CLA_ERROR_POINTS - 1));
+            voltage = voltage_code * VOLTAGE_CONVERSION_FACTOR;
+
+            duty = pi_controller_compute(setpoint, voltage);
+            if (duty > 0.975f)
+                duty = 0.975f;
+            if (duty < 0.025f)
+                duty = 0.025f;
+            cmpa = duty * pwm_factor;
+
+            cla_control_step(&input, &state, &output, voltage_code, voltage_code);
+
+            diff = duty - output.duty;
+            if (diff < 0.0f)
+                diff = -diff;
+            if (diff > cla_error_check.duty_max_error)
+                cla_error_check.duty_max_error = diff;
+
+            cmpa = (cmpa > output.cmpa) ? cmpa - output.cmpa : output.cmpa - cmpa;
+            if (cmpa > cla_error_check.cmpa_max_error)
+                cla_error_check.cmpa_max_error = cmpa;
+
+            cla_error_check.points++;
+        }
+    }
+
+    cla_error_check.pass = (cla_error_check.duty_max_error < CLA_ERROR_BOUND) &&
+                           (cla_error_check.cmpa_max_error == 0);
+
+    pi_controller_reset();
+
+    return;
+}
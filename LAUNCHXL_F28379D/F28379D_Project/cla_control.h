@@ -0,0 +1,164 @@
+/**
+ * @file cla_control.h
+ * @brief PI control law on the Control Law Accelerator (CONTROL_LOOP_CLA)
+ *        Shared by the CLA task (cla_control.cla), the C28x and the host
+ *        build, so the same source runs on all three
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef CLA_CONTROL_H
+#define CLA_CONTROL_H
+
+#ifdef __TMS320C28XX_CLA__
+    #include "Libraries/Common/F2837xD_Cla_typedefs.h"
+    #include "Libraries/Headers/F2837xD_device.h"
+#else
+    #include "peripheral_Setup.h"
+    #include "Libraries/Common/F2837xD_Cla_defines.h"
+#endif
+
+    #include <stdint.h>
+
+    // Duty cycle clamp and input voltage margin, as controller_step
+    #define CLA_DUTY_MAX            0.975f
+    #define CLA_DUTY_MIN            0.025f
+    #define CLA_INPUT_MARGIN        0.975f
+
+    // Error bound of the CLA control law against pi_controller_compute
+    #define CLA_ERROR_BOUND         1.0e-6f
+    #define CLA_ERROR_POINTS        64          // Setpoint and voltage sweep points
+
+    // Uncomment to run the CLA control law check in peripheral_Setup
+    // #define CLA_ERROR_CHECK
+
+    /**
+     * @brief CPU to CLA message RAM, written by the C28x only
+     *        Gains and conversion factors are loaded once (cla_control_load),
+     *        setpoint, input voltage and state by adcc1_isr after every
+     *        conversion, so the CLA uses them one conversion later.
+     *        32-bit members first: the CLA and the C28x lay them out alike
+     */
+    typedef struct {
+        float b0, b1, a1;           // PI parameters, from pi_controller
+        float voltage_factor;       // VOLTAGE_CONVERSION_FACTOR
+        float current_factor;       // CURRENT_CONVERSION_FACTOR
+        float setpoint;
+        float input_voltage;
+        uint16_t pwm_factor;        // CMPA at 100 % duty cycle
+        uint16_t run;               // system_state, 0 resets the PI
+    } ClaControlInput;
+
+    /**
+     * @brief CLA to CPU message RAM, written by the CLA only
+     */
+    typedef struct {
+        float voltage;              // Scaled Tensao_DC
+        float current;              // Scaled Corrente_carga
+        float duty;                 // Clamped duty cycle, 0 while stopped
+        uint32_t runs;              // CLA task executions
+        uint16_t cmpa;              // Last CMPA written
+    } ClaControlOutput;
+
+    /**
+     * @brief PI state, in CLA data RAM
+     */
+    typedef struct {
+        float error_old;
+        float output_old;
+    } ClaPIState;
+
+    /**
+     * @brief CLA control law against the C28x reference over the
+     *        setpoint and voltage range
+     */
+    typedef struct {
+        float duty_max_error;
+        uint16_t cmpa_max_error;
+        uint32_t points;
+        uint16_t pass;              // Duty within CLA_ERROR_BOUND, same CMPA
+    } ClaErrorCheck;
+
+    extern volatile ClaControlInput cla_control_input;
+    extern volatile ClaControlOutput cla_control_output;
+    extern volatile ClaPIState cla_pi_state;
+
+    /**
+     * @brief One control law step: scaling, PI, clamp and CMPA
+     *        Same arithmetic, in the same order, as controller_step with
+     *        pi_controller_compute. The [0, 1] saturation of the PI output
+     *        is contained in the clamp
+     * @param input Parameters and latest setpoint
+     * @param state PI state
+     * @param output Scaled measurements and duty cycle
+     * @param voltage_code Tensao_DC ADC result
+     * @param current_code Corrente_carga ADC result
+     * @return 1 if output->cmpa is to be written to CMPA
+     */
+    static inline uint16_t cla_control_step(volatile ClaControlInput *input, volatile ClaPIState *state,
+                                            volatile ClaControlOutput *output,
+                                            uint16_t voltage_code, uint16_t current_code) {
+        float voltage = voltage_code * input->voltage_factor;
+        float error, duty;
+        uint16_t update = 0;
+
+        output->voltage = voltage;
+        output->current = current_code * input->current_factor;
+
+        if (!input->run) {
+            state->error_old = 0.0f;
+            state->output_old = 0.0f;
+            output->duty = 0.0f;
+        }
+        else if (input->setpoint < (CLA_INPUT_MARGIN * input->input_voltage)) {
+            error = input->setpoint - voltage;
+
+            duty =
+                (error * input->b0)            +
+                (state->error_old * input->b1) -
+                (state->output_old * input->a1);
+
+            state->error_old = error;
+            state->output_old = duty;
+
+            if (duty > CLA_DUTY_MAX)
+                duty = CLA_DUTY_MAX;
+            if (duty < CLA_DUTY_MIN)
+                duty = CLA_DUTY_MIN;
+
+            output->duty = duty;
+            output->cmpa = duty * input->pwm_factor;
+            update = 1;
+        }
+
+        output->runs++;
+
+        return update;
+    }
+
+    /**
+     * @brief Body of CLA Task 1, started by ADCC ADCINT1
+     *        Reads the results, runs the control law and writes CMPA
+     *        directly. Also compiled for the C28x and the host (Cla1Task1
+     *        in host_target.c) to check the task against the C28x path
+     */
+    static inline void cla_control_task(void) {
+        if (cla_control_step(&cla_control_input, &cla_pi_state, &cla_control_output,
+                             AdcbResultRegs.ADCRESULT0, AdccResultRegs.ADCRESULT0))
+            EPwm1Regs.CMPA.bit.CMPA = cla_control_output.cmpa;
+
+        return;
+    }
+
+#ifndef __TMS320C28XX_CLA__
+    extern ClaErrorCheck cla_error_check;
+
+    // CLA task entry points (cla_control.cla)
+    __interrupt void Cla1Task1(void);
+
+    // C28x functions
+    void cla_control_load(void);
+    void controller_cla_error_check(void);
+#endif
+
+#endif /* CLA_CONTROL_H */
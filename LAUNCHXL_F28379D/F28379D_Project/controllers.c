@@ -6,32 +6,92 @@
  */
 
 #include "controllers.h"
+#include "controllers_fixed.h"
+#include "nn_kernels.h"
+#include "nn_snapshot.h"
+#include "nn_ipc.h"
 #include "Libraries/Common/F2837xD_Examples.h"
+#include "Libraries/freeRTOS/FreeRTOS.h"
+#include "Libraries/freeRTOS/task.h"
+
+#include <string.h>
 
 // Global controller instances
 NeuralNetwork neural_network;
 PIController pi_controller;
 uint8_t current_controller_type = PI_CONTROLLER;
+volatile uint8_t controller_request = PI_CONTROLLER;
+uint16_t controller_switch_count = 0;
+
+// Control loop statistics
+volatile uint32_t control_loop_count = 0;
+float control_loop_rate = 0.0f;
+NNBenchmark nn_benchmark = {0};
+NNKernelBenchmark nn_kernel_benchmark[NN_KERNEL_BENCHMARK_TOPOLOGIES];
+ControlStepStats control_step_stats = {0};
+SettleStats settle_stats = {0};
+
+// Neural Network training state
+NeuralNetwork nn_weights[2];                // Published copies used for inference
+volatile uint16_t nn_weights_index = 0;     // Copy currently read by the control path
+NNTrainingRing nn_training_ring = {0};
+uint32_t nn_training_updates = 0;
+
+static volatile uint16_t nn_reset_request = 0;
+static float nn_bias_offset = 0.0f;         // Output bias shift pending for the shadow copy
+
+static inline void nn_training_push(float inputs[INPUT_SIZE], float error);
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FIXED)
+static float pi_controller_q_step(float setpoint, float measured_voltage, float measured_current);
+#else
+static float pi_controller_step(float setpoint, float measured_voltage, float measured_current);
+#endif
+
+// Controller registry, indexed by controller type
+const ControllerDescriptor controller_registry[CONTROLLER_COUNT] = {
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FIXED)
+    { "PI",  sizeof(PIControllerQ),  pi_controller_q_init,  pi_controller_q_step,     pi_controller_q_reset,  pi_controller_q_transfer  },
+    { "NNA", sizeof(NeuralNetworkQ), neural_network_q_init, neural_network_q_compute, neural_network_q_reset, neural_network_q_transfer },
+#else
+    { "PI",  sizeof(PIController),   pi_controller_init,    pi_controller_step,       pi_controller_reset,    pi_controller_transfer    },
+    { "NNA", sizeof(NeuralNetwork),  neural_network_init,   neural_network_compute,   neural_network_reset,   neural_network_transfer   },
+#endif
+};
+
+const ControllerDescriptor *active_controller = &controller_registry[PI_CONTROLLER];
 
 /**
- * @brief Initialize the selected controller
- * @param controller_type Type of controller to initialize
+ * @brief Initialize the registered controllers and select the first one
+ *        Every controller is initialized so controller_select can switch
+ *        at runtime
+ * @param controller_type Type of controller to start with
  * @return void
  */
 void controller_init(uint8_t controller_type) {
+    uint8_t x;
+
+    if (controller_type >= CONTROLLER_COUNT)
+        asm(" ESTOP0");
+
+    for (x = 0; x < CONTROLLER_COUNT; x++)
+        controller_registry[x].init();
+
+#if (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+    nn_ipc_init(&neural_network);
+#endif
+
     current_controller_type = controller_type;
+    controller_request = controller_type;
+    active_controller = &controller_registry[controller_type];
 
-    switch (controller_type) {
-        case PI_CONTROLLER:
-            pi_controller_init();
-            break;
-        case NNA_CONTROLLER:
-            neural_network_init();
-            break;
-        default:
-            asm(" ESTOP0");
-            break;
-    }
+#ifdef NN_BENCHMARK
+    neural_network_benchmark();
+    neural_network_kernel_benchmark();
+#endif
+
+#ifdef FIXED_ERROR_CHECK
+    controller_fixed_error_check();
+#endif
 
     DELAY_US(1000);
 
@@ -46,12 +106,7 @@ void controller_init(uint8_t controller_type) {
  * @return Computed controller output
  */
 float controller_compute(float setpoint, float measured_voltage, float measured_current) {
-    if (current_controller_type == NNA_CONTROLLER)
-        return neural_network_compute(setpoint, measured_voltage, measured_current);
-    else if (current_controller_type == PI_CONTROLLER)
-        return pi_controller_compute(setpoint, measured_voltage);
-    else
-        return 0.0f;
+    return active_controller->step(setpoint, measured_voltage, measured_current);
 }
 
 /**
@@ -59,12 +114,148 @@ float controller_compute(float setpoint, float measured_voltage, float measured_
  * @return void
  */
 void controller_reset(void) {
-    if (current_controller_type == NNA_CONTROLLER)
-        neural_network_reset();
+    active_controller->reset();
+
+    return;
+}
+
+/**
+ * @brief Request a runtime controller switch
+ *        The switch happens at the start of the next controller_step, which
+ *        hands the last duty cycle and measurements to the new controller
+ * @param controller_type Type of controller to switch to
+ * @return 1 if the request was accepted, 0 for an unknown type
+ */
+uint16_t controller_select(uint8_t controller_type) {
+    if (controller_type >= CONTROLLER_COUNT)
+        return 0;
+
+    controller_request = controller_type;
+
+    return 1;
+}
+
+/**
+ * @brief Start a time-to-settle measurement
+ * @return void
+ */
+static inline void settle_start(void) {
+    settle_stats.steps = 0;
+    settle_stats.hold = 0;
+    settle_stats.settled = 0;
+
+    return;
+}
+
+/**
+ * @brief Update the time-to-settle measurement
+ *        Settled once the output stays within SETTLE_BAND of the setpoint
+ *        for SETTLE_HOLD consecutive steps
+ * @param setpoint Desired setpoint value
+ * @param measured_voltage Measured voltage value
+ * @return void
+ */
+static inline void settle_update(float setpoint, float measured_voltage) {
+    float error = setpoint - measured_voltage;
+
+    if (settle_stats.settled)
+        return;
+
+    settle_stats.steps++;
+
+    if (error < 0.0f)
+        error = -error;
+
+    if (error <= SETTLE_BAND * setpoint)
+        settle_stats.hold++;
     else
-        pi_controller_reset();
+        settle_stats.hold = 0;
 
-    DELAY_US(1000);
+    if (settle_stats.hold >= SETTLE_HOLD) {
+        settle_stats.settled = 1;
+        settle_stats.settle_steps = settle_stats.steps - SETTLE_HOLD;
+        if (control_loop_rate > 0.0f)
+            settle_stats.settle_time_ms = settle_stats.settle_steps * 1000.0f / control_loop_rate;
+    }
+
+    return;
+}
+
+/**
+ * @brief Execute one control iteration from the latest measurements
+ *        Computes the controller output, clamps it and updates CMPA.
+ *        The inputs come from one conversion (measurement_read).
+ *        Called from control_task or from adcc1_isr, see CONTROL_LOOP_MODE.
+ * @return void
+ */
+void controller_step(void) {
+    static char reset_flag = 1;
+    static char running = 0;
+    Measurements measurements;
+    float controller_output;
+    uint32_t start_cycles;
+
+    start_cycles = read_cycle_counter();
+
+    measurement_read(&measurements);
+
+    // Bumpless switch to the requested controller
+    if (controller_request != current_controller_type && controller_request < CONTROLLER_COUNT) {
+        current_controller_type = controller_request;
+        active_controller = &controller_registry[current_controller_type];
+        active_controller->transfer(
+            duty_cycle,
+            measurements.setpoint,
+            measurements.voltage,
+            measurements.current
+        );
+        controller_switch_count++;
+    }
+
+    if (measurements.system_state) {
+        GpioDataRegs.GPACLEAR.bit.GPIO31 = 1;
+
+        reset_flag = 1;
+
+        if (!running) {
+            running = 1;
+            settle_start();
+        }
+
+        if (measurements.setpoint < (0.975f * measurements.input_voltage)) {
+            controller_output = controller_compute(
+                measurements.setpoint,
+                measurements.voltage,
+                measurements.current
+            );
+
+            if (controller_output > 0.975f)
+                controller_output = 0.975f;
+            if (controller_output < 0.025f)
+                controller_output = 0.025f;
+
+            EPWM1_Modulante_CMPA = controller_output * pwm_factor;
+            duty_cycle = controller_output;
+        }
+
+        settle_update(measurements.setpoint, measurements.voltage);
+    }
+    else {
+        running = 0;
+
+        if (reset_flag) {
+            controller_reset();
+            reset_flag = 0;
+        }
+
+        duty_cycle = 0.0f;
+    }
+
+    control_loop_count++;
+
+    control_step_stats.cycles = read_cycle_counter() - start_cycles;
+    if (control_step_stats.cycles > control_step_stats.cycles_max)
+        control_step_stats.cycles_max = control_step_stats.cycles;
 
     return;
 }
@@ -128,37 +319,80 @@ void pi_controller_reset(void) {
     return;
 }
 
+/**
+ * @brief Initialize PI controller state from the previous controller
+ *        With output_old at the last duty, the next output continues from it
+ * @param duty Last duty cycle applied
+ * @param setpoint Desired setpoint value
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value (unused)
+ * @return void
+ */
+void pi_controller_transfer(float duty, float setpoint, float measured_voltage, float measured_current) {
+    pi_controller.error         = setpoint - measured_voltage;
+    pi_controller.error_old     = pi_controller.error;
+    pi_controller.output        = duty;
+    pi_controller.output_old    = duty;
+
+    return;
+}
+
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FIXED)
+/**
+ * @brief Q24 PI controller step with the registry signature
+ */
+static float pi_controller_q_step(float setpoint, float measured_voltage, float measured_current) {
+    return pi_controller_q_compute(setpoint, measured_voltage);
+}
+#else
+/**
+ * @brief PI controller step with the registry signature
+ */
+static float pi_controller_step(float setpoint, float measured_voltage, float measured_current) {
+    return pi_controller_compute(setpoint, measured_voltage);
+}
+#endif
+
 // Neural Network implementation
 
 /**
- * @brief Initialize neural network with random weights
+ * @brief Initialize neural network from the last flash snapshot,
+ *        or with random weights when there is none
  * @return void
  */
 void neural_network_init(void) {
     int x, y;
     float sqrt_layers;
 
+    // Warm start
+    if (nn_snapshot_load(&neural_network)) {
+        neural_network_publish();
+        return;
+    }
+
     // Initialize weights using He initialization
     sqrt_layers = custom_sqrt(2.0f / INPUT_SIZE);
     for (x = 0; x < INPUT_SIZE; x++)
         for (y = 0; y < HIDDEN1_SIZE; y++)
-            neural_network.weights_h1[x][y] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
+            neural_network.weights[NN_H1_WEIGHT(x, y)] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
 
     sqrt_layers = custom_sqrt(2.0f / HIDDEN1_SIZE);
     for (x = 0; x < HIDDEN1_SIZE; x++) {
-        neural_network.bias_h1[x] = 0.01f;
+        neural_network.weights[NN_H1_BIAS(x)] = 0.01f;
 
         for (y = 0; y < HIDDEN2_SIZE; y++)
-            neural_network.weights_h2[x][y] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
+            neural_network.weights[NN_H2_WEIGHT(x, y)] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
     }
 
     sqrt_layers = custom_sqrt(2.0f / HIDDEN2_SIZE);
     for (x = 0; x < HIDDEN2_SIZE; x++) {
-        neural_network.bias_h2[x] = 0.01f;
-        neural_network.weights_output[x] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
+        neural_network.weights[NN_H2_BIAS(x)] = 0.01f;
+        neural_network.weights[NN_OUT_WEIGHT(x)] = (random_float() * 2.0f - 1.0f) * sqrt_layers;
     }
 
-    neural_network.bias_output = 0.01f;
+    neural_network.weights[NN_OUT_BIAS] = 0.01f;
+
+    neural_network_publish();
 
     return;
 }
@@ -171,6 +405,7 @@ void neural_network_init(void) {
  * @return Computed controller output
  */
 float neural_network_compute(float setpoint, float measured_voltage, float measured_current) {
+    NeuralNetworkActivations activations;
     float inputs[INPUT_SIZE];
     float output_network;
     float error, error_norm;
@@ -185,8 +420,12 @@ float neural_network_compute(float setpoint, float measured_voltage, float measu
     if (inputs[2] > 1.0f)
         inputs[2] = 1.0f;
 
-    // Forward pass
-    output_network = neural_network_forward(inputs);
+    // Forward pass, keeping the activations for training
+#if (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    output_network = neural_network_forward_cached(&nn_weights[nn_weights_index], inputs, &activations);
+#else
+    output_network = neural_network_forward_cached(&neural_network, inputs, &activations);
+#endif
 
     // Clamp output
     if (output_network > 0.975f)
@@ -197,17 +436,223 @@ float neural_network_compute(float setpoint, float measured_voltage, float measu
     // Training
     error = setpoint - measured_voltage;
     error_norm = error / MAX_VOLTAGE;
-    neural_network_backpropagate(inputs, setpoint, error_norm);
+#if (NN_TRAINING_MODE == NN_TRAINING_TASK)
+    nn_training_push(inputs, error_norm);
+#elif (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+    nn_ipc_push(inputs, error_norm);
+#else
+    neural_network_train(&activations, error_norm);
+#endif
 
     return output_network;
 }
 
 /**
  * @brief Reset neural network
+ *        Warm restart: the learned weights are kept, only the samples
+ *        queued by the last run are dropped. neural_network_init is the
+ *        cold start
  * @return void
  */
 void neural_network_reset(void) {
-    neural_network_init();
+#if (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    // The shadow copy belongs to the training task
+    nn_reset_request = 1;
+#endif
+
+    // Inline training keeps no state besides the weights
+
+    return;
+}
+
+/**
+ * @brief Shift the output bias so the network continues from duty
+ *        With the training task, the published copy is shifted at once and
+ *        the shadow copy when the training task next runs
+ * @param duty Last duty cycle applied
+ * @param setpoint Desired setpoint value (unused)
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value
+ * @return void
+ */
+void neural_network_transfer(float duty, float setpoint, float measured_voltage, float measured_current) {
+    NeuralNetworkActivations activations;
+    float inputs[INPUT_SIZE];
+    float offset;
+
+    inputs[0] = BIAS;
+    inputs[1] = (2.0f * measured_voltage / MAX_VOLTAGE) - 1.0f;
+    inputs[2] = (2.0f * measured_current / MAX_CURRENT_mA) - 1.0f;
+
+    if (inputs[2] < -1.0f)
+        inputs[2] = -1.0f;
+    if (inputs[2] > 1.0f)
+        inputs[2] = 1.0f;
+
+#if (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    // adcc1_isr already excludes neural_network_publish, control_task does not
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+    taskENTER_CRITICAL();
+#endif
+    neural_network_forward_cached(&nn_weights[nn_weights_index], inputs, &activations);
+    offset = duty - activations.output;
+
+    nn_weights[nn_weights_index].weights[NN_OUT_BIAS] += offset;
+    nn_bias_offset += offset;
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+    taskEXIT_CRITICAL();
+#endif
+#else
+    neural_network_forward_cached(&neural_network, inputs, &activations);
+    offset = duty - activations.output;
+
+    neural_network.weights[NN_OUT_BIAS] += offset;
+#endif
+
+    return;
+}
+
+/**
+ * @brief Publish the trained weights to the control path
+ *        Copies the shadow network into the copy not in use and swaps the
+ *        index, so inference never sees a partially updated network.
+ *        A bias shift not yet in the shadow copy is added to the published
+ *        one, under the lock neural_network_transfer updates it with
+ * @return void
+ */
+void neural_network_publish(void) {
+    uint16_t next = nn_weights_index ^ 1;
+
+    *(volatile NeuralNetwork *)&nn_weights[next] = neural_network;
+
+    taskENTER_CRITICAL();
+    nn_weights[next].weights[NN_OUT_BIAS] += nn_bias_offset;
+    nn_weights_index = next;
+    taskEXIT_CRITICAL();
+
+    return;
+}
+
+/**
+ * @brief Queue a training sample for nn_training_task
+ *        Drops the sample when the ring is full
+ * @param inputs The input values
+ * @param error The error value
+ * @return void
+ */
+static inline void nn_training_push(float inputs[INPUT_SIZE], float error) {
+    volatile NNTrainingSample *slot;
+    uint16_t head = nn_training_ring.head;
+    int x;
+
+    if ((uint16_t)(head - nn_training_ring.tail) >= NN_TRAINING_RING_SIZE) {
+        nn_training_ring.dropped++;
+        return;
+    }
+
+    slot = &nn_training_ring.samples[head & (NN_TRAINING_RING_SIZE - 1)];
+    for (x = 0; x < INPUT_SIZE; x++)
+        slot->inputs[x] = inputs[x];
+    slot->error = error;
+
+    nn_training_ring.head = head + 1;
+
+    return;
+}
+
+/**
+ * @brief Train the shadow network with the queued samples
+ *        Called from nn_training_task. The gradient is taken with the shadow
+ *        weights, so the forward pass is recomputed for every sample.
+ *        With NN_TRAINING_CPU2, CPU2 trains: the reset and the bias shift
+ *        are posted to it, and the weights it posted are published.
+ * @return void
+ */
+void neural_network_training_service(void) {
+#if (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+    float offset;
+
+    // One request to CPU2 at a time
+    if (nn_ipc_busy() == 0) {
+        if (nn_reset_request) {
+            nn_reset_request = 0;
+
+            // Warm restart: CPU2 goes back to the weights it last posted,
+            // dropping the samples queued before the load. A pending bias
+            // shift follows with the next request
+            nn_ipc_load(&neural_network);
+            neural_network_publish();
+
+            // With NN_SNAPSHOT_ENABLE, also kept across a power cycle
+            nn_snapshot_save(&neural_network);
+
+            return;
+        }
+
+        taskENTER_CRITICAL();
+        offset = nn_bias_offset;
+        nn_bias_offset = 0.0f;
+        taskEXIT_CRITICAL();
+
+        if (offset != 0.0f)
+            nn_ipc_bias(offset);
+    }
+
+    if (nn_ipc_fetch(&neural_network)) {
+        neural_network_publish();
+        nn_training_updates = nn_ipc_status.trained;
+    }
+#else
+    volatile NNTrainingSample *slot;
+    NNTrainingSample sample;
+    NeuralNetworkActivations activations;
+    uint16_t tail = nn_training_ring.tail;
+    uint16_t trained = 0;
+    float offset;
+    int x;
+
+    if (nn_reset_request) {
+        nn_reset_request = 0;
+        nn_training_ring.tail = nn_training_ring.head;
+
+        // Warm restart: the queued samples of the last run are dropped,
+        // the learned weights are published as they are. A pending bias
+        // shift is applied on the next call
+        neural_network_publish();
+
+        // With NN_SNAPSHOT_ENABLE, also kept across a power cycle
+        nn_snapshot_save(&neural_network);
+
+        return;
+    }
+
+    // Bias shift of a controller switch, written from the control path
+    taskENTER_CRITICAL();
+    offset = nn_bias_offset;
+    nn_bias_offset = 0.0f;
+    taskEXIT_CRITICAL();
+
+    if (offset != 0.0f)
+        neural_network.weights[NN_OUT_BIAS] += offset;
+
+    while (tail != nn_training_ring.head) {
+        slot = &nn_training_ring.samples[tail & (NN_TRAINING_RING_SIZE - 1)];
+        for (x = 0; x < INPUT_SIZE; x++)
+            sample.inputs[x] = slot->inputs[x];
+        sample.error = slot->error;
+
+        nn_training_ring.tail = ++tail;
+
+        neural_network_forward_cached(&neural_network, sample.inputs, &activations);
+        neural_network_train(&activations, sample.error);
+        trained++;
+    }
+
+    if (trained || offset != 0.0f) {
+        neural_network_publish();
+        nn_training_updates += trained;
+    }
+#endif
 
     return;
 }
@@ -296,41 +741,153 @@ float sigmoid(float output) {
  * @return float The output value
  */
 float neural_network_forward(float inputs[INPUT_SIZE]) {
-    float h1[HIDDEN1_SIZE];
-    float h2[HIDDEN2_SIZE];
+    NeuralNetworkActivations activations;
+
+    return neural_network_forward_cached(&neural_network, inputs, &activations);
+}
+
+/**
+ * @brief Loop forward pass over a flat weight array
+ * @param w Flat weight array
+ * @param in The input values
+ * @param h1 Hidden layer 1 activations (output)
+ * @param h2 Hidden layer 2 activations (output)
+ * @param n_in Number of inputs
+ * @param n_h1 Hidden layer 1 size
+ * @param n_h2 Hidden layer 2 size
+ * @return float The output layer pre-activation
+ */
+static float nn_forward_loop(const float *w, const float *in, float *h1, float *h2,
+                             int n_in, int n_h1, int n_h2) {
     float output;
     int x, y;
 
     // Hidden layer 1
-    for (x = 0; x < HIDDEN1_SIZE; x++) {
-        h1[x] = neural_network.bias_h1[x];
+    for (x = 0; x < n_h1; x++) {
+        h1[x] = w[0];
 
-        for (y = 0; y < INPUT_SIZE; y++)
-            h1[x] += inputs[y] * neural_network.weights_h1[y][x];
+        for (y = 0; y < n_in; y++)
+            h1[x] += in[y] * w[1 + y];
 
         h1[x] = relu(h1[x]);
+        w += n_in + 1;
     }
 
     // Hidden layer 2
-    for (x = 0; x < HIDDEN2_SIZE; x++) {
-        h2[x] = neural_network.bias_h2[x];
+    for (x = 0; x < n_h2; x++) {
+        h2[x] = w[0];
 
-        for (y = 0; y < HIDDEN1_SIZE; y++)
-            h2[x] += h1[y] * neural_network.weights_h2[y][x];
+        for (y = 0; y < n_h1; y++)
+            h2[x] += h1[y] * w[1 + y];
 
         h2[x] = relu(h2[x]);
+        w += n_h1 + 1;
     }
 
     // Output layer
-    output = neural_network.bias_output;
-    for (x = 0; x < HIDDEN2_SIZE; x++)
-        output += h2[x] * neural_network.weights_output[x];
+    output = w[0];
+    for (x = 0; x < n_h2; x++)
+        output += h2[x] * w[1 + x];
+
+    return output;
+}
+
+/**
+ * @brief Loop gradient step over a flat weight array
+ * @param w Flat weight array
+ * @param in The input values of the forward pass
+ * @param h1 Hidden layer 1 activations of the forward pass
+ * @param h2 Hidden layer 2 activations of the forward pass
+ * @param output The output layer pre-activation
+ * @param error The error value
+ * @param n_in Number of inputs
+ * @param n_h1 Hidden layer 1 size
+ * @param n_h2 Hidden layer 2 size (up to NN_KERNEL_MAX_WIDTH)
+ * @return void
+ */
+static void nn_train_loop(float *w, const float *in, const float *h1, const float *h2,
+                          float output, float error, int n_in, int n_h1, int n_h2) {
+    float *w_h1 = w;
+    float *w_h2 = w_h1 + n_h1 * (n_in + 1);
+    float *w_out = w_h2 + n_h2 * (n_h1 + 1);
+    float delta_h2[NN_KERNEL_MAX_WIDTH];
+    float delta_h1, delta_output;
+    float grad_h1, grad_h2, sum;
+    int x, y;
+
+    output = relu(output);
+
+    // Backpropagation
+    delta_output = error * (output > 0.0f ? 1.0f : 0.0f);
+
+    // Update output layer
+    for (x = 0; x < n_h2; x++)
+        w_out[1 + x] += ETA * delta_output * h2[x];
+
+    w_out[0] += ETA * delta_output;
+
+    // Update hidden layer 2
+    for (x = 0; x < n_h2; x++) {
+        grad_h2 = (h2[x] > 0.0f ? 1.0f : 0.0f);
+        delta_h2[x] = delta_output * w_out[1 + x] * grad_h2;
+
+        for (y = 0; y < n_h1; y++)
+            w_h2[x * (n_h1 + 1) + 1 + y] += ETA * delta_h2[x] * h1[y];
+
+        w_h2[x * (n_h1 + 1)] += ETA * delta_h2[x];
+    }
+
+    // Update hidden layer 1
+    for (y = 0; y < n_h1; y++) {
+        sum = 0.0f;
+
+        for (x = 0; x < n_h2; x++)
+            sum += delta_h2[x] * w_h2[x * (n_h1 + 1) + 1 + y];
+
+        grad_h1 = (h1[y] > 0.0f ? 1.0f : 0.0f);
+        delta_h1 = sum * grad_h1;
+
+        for (x = 0; x < n_in; x++)
+            w_h1[y * (n_in + 1) + 1 + x] += ETA * delta_h1 * in[x];
+
+        w_h1[y * (n_in + 1)] += ETA * delta_h1;
+    }
+
+    return;
+}
+
+/**
+ * @brief Neural network forward pass keeping the intermediate values
+ * @param network The weights to evaluate
+ * @param inputs The input values
+ * @param activations Storage for the inputs, hidden activations and output pre-activation
+ * @return float The output value
+ */
+float neural_network_forward_cached(const NeuralNetwork *network, float inputs[INPUT_SIZE], NeuralNetworkActivations *activations) {
+    float output;
+    int x;
+
+    for (x = 0; x < INPUT_SIZE; x++)
+        activations->inputs[x] = inputs[x];
+
+#if (NN_KERNEL == NN_KERNEL_UNROLLED)
+    output = nn_forward_unrolled(network->weights, inputs, activations->h1, activations->h2);
+#else
+    output = nn_forward_loop(network->weights, inputs, activations->h1, activations->h2,
+                             INPUT_SIZE, HIDDEN1_SIZE, HIDDEN2_SIZE);
+#endif
+
+    activations->output = output;
 
     return relu_clipped(output);
 }
 
 /**
  * @brief Neural network backpropagation
+ *        Recomputes the forward pass before the gradient step. Written out
+ *        on its own, without the kernels of neural_network_forward_cached
+ *        and neural_network_train, so neural_network_benchmark checks them
+ *        against an independent reference
  * @param inputs The input values
  * @param target The target output value
  * @param error The error value
@@ -346,25 +903,25 @@ void neural_network_backpropagate(float inputs[INPUT_SIZE], float target, float
 
     // Forward pass to get intermediate values
     for (x = 0; x < HIDDEN1_SIZE; x++) {
-        h1[x] = neural_network.bias_h1[x];
+        h1[x] = neural_network.weights[NN_H1_BIAS(x)];
 
         for (y = 0; y < INPUT_SIZE; y++)
-            h1[x] += inputs[y] * neural_network.weights_h1[y][x];
+            h1[x] += inputs[y] * neural_network.weights[NN_H1_WEIGHT(y, x)];
         h1[x] = relu(h1[x]);
     }
 
     for (x = 0; x < HIDDEN2_SIZE; x++) {
-        h2[x] = neural_network.bias_h2[x];
+        h2[x] = neural_network.weights[NN_H2_BIAS(x)];
 
         for (y = 0; y < HIDDEN1_SIZE; y++)
-            h2[x] += h1[y] * neural_network.weights_h2[y][x];
+            h2[x] += h1[y] * neural_network.weights[NN_H2_WEIGHT(y, x)];
 
         h2[x] = relu(h2[x]);
     }
 
-    output = neural_network.bias_output;
+    output = neural_network.weights[NN_OUT_BIAS];
     for (x = 0; x < HIDDEN2_SIZE; x++)
-        output += h2[x] * neural_network.weights_output[x];
+        output += h2[x] * neural_network.weights[NN_OUT_WEIGHT(x)];
 
     output = relu(output);
 
@@ -373,19 +930,19 @@ void neural_network_backpropagate(float inputs[INPUT_SIZE], float target, float
 
     // Update output layer
     for (x = 0; x < HIDDEN2_SIZE; x++)
-        neural_network.weights_output[x] += ETA * delta_output * h2[x];
+        neural_network.weights[NN_OUT_WEIGHT(x)] += ETA * delta_output * h2[x];
 
-    neural_network.bias_output += ETA * delta_output;
+    neural_network.weights[NN_OUT_BIAS] += ETA * delta_output;
 
     // Update hidden layer 2
     for (x = 0; x < HIDDEN2_SIZE; x++) {
         grad_h2 = (h2[x] > 0.0f ? 1.0f : 0.0f);
-        delta_h2[x] = delta_output * neural_network.weights_output[x] * grad_h2;
+        delta_h2[x] = delta_output * neural_network.weights[NN_OUT_WEIGHT(x)] * grad_h2;
 
         for (y = 0; y < HIDDEN1_SIZE; y++)
-            neural_network.weights_h2[y][x] += ETA * delta_h2[x] * h1[y];
+            neural_network.weights[NN_H2_WEIGHT(y, x)] += ETA * delta_h2[x] * h1[y];
 
-        neural_network.bias_h2[x] += ETA * delta_h2[x];
+        neural_network.weights[NN_H2_BIAS(x)] += ETA * delta_h2[x];
     }
 
     // Update hidden layer 1
@@ -393,15 +950,176 @@ void neural_network_backpropagate(float inputs[INPUT_SIZE], float target, float
         sum = 0.0f;
 
         for (x = 0; x < HIDDEN2_SIZE; x++)
-            sum += delta_h2[x] * neural_network.weights_h2[y][x];
+            sum += delta_h2[x] * neural_network.weights[NN_H2_WEIGHT(y, x)];
 
         grad_h1 = (h1[y] > 0.0f ? 1.0f : 0.0f);
         delta_h1 = sum * grad_h1;
 
         for (x = 0; x < INPUT_SIZE; x++)
-            neural_network.weights_h1[x][y] += ETA * delta_h1 * inputs[x];
+            neural_network.weights[NN_H1_WEIGHT(x, y)] += ETA * delta_h1 * inputs[x];
+
+        neural_network.weights[NN_H1_BIAS(y)] += ETA * delta_h1;
+    }
+
+    return;
+}
+
+/**
+ * @brief Neural network gradient step from the activations of a forward pass
+ * @param activations Values stored by neural_network_forward_cached
+ * @param error The error value
+ * @return void
+ */
+void neural_network_train(const NeuralNetworkActivations *activations, float error) {
+#if (NN_KERNEL == NN_KERNEL_UNROLLED)
+    nn_train_unrolled(neural_network.weights, activations->inputs, activations->h1,
+                      activations->h2, activations->output, error);
+#else
+    nn_train_loop(neural_network.weights, activations->inputs, activations->h1,
+                  activations->h2, activations->output, error,
+                  INPUT_SIZE, HIDDEN1_SIZE, HIDDEN2_SIZE);
+#endif
+
+    return;
+}
+
+/**
+ * @brief Compare the recomputing and the fused training paths
+ *        Runs NN_BENCHMARK_STEPS training steps through each path from the
+ *        same initial weights, stores the cycle counts in nn_benchmark and
+ *        checks that both produce bit-identical weights. The network is
+ *        restored afterwards.
+ * @return void
+ */
+void neural_network_benchmark(void) {
+    NeuralNetwork initial, recompute;
+    NeuralNetworkActivations activations;
+    float inputs[INPUT_SIZE];
+    uint32_t start;
+    int step;
+
+    initial = neural_network;
+
+    // Recomputing path: forward pass, then backpropagate recomputes it
+    start = read_cycle_counter();
+    for (step = 0; step < NN_BENCHMARK_STEPS; step++) {
+        inputs[0] = BIAS;
+        inputs[1] = (2.0f * step / NN_BENCHMARK_STEPS) - 1.0f;
+        inputs[2] = 1.0f - (2.0f * step / NN_BENCHMARK_STEPS);
+
+        neural_network_forward(inputs);
+        neural_network_backpropagate(inputs, 0.0f, inputs[2] * 0.1f);
+    }
+    nn_benchmark.cycles_recompute = read_cycle_counter() - start;
+
+    recompute = neural_network;
+    neural_network = initial;
+
+    // Fused path: training reuses the inference activations
+    start = read_cycle_counter();
+    for (step = 0; step < NN_BENCHMARK_STEPS; step++) {
+        inputs[0] = BIAS;
+        inputs[1] = (2.0f * step / NN_BENCHMARK_STEPS) - 1.0f;
+        inputs[2] = 1.0f - (2.0f * step / NN_BENCHMARK_STEPS);
+
+        neural_network_forward_cached(&neural_network, inputs, &activations);
+        neural_network_train(&activations, inputs[2] * 0.1f);
+    }
+    nn_benchmark.cycles_fused = read_cycle_counter() - start;
+
+    nn_benchmark.bit_exact = (memcmp(&recompute, &neural_network, sizeof(NeuralNetwork)) == 0);
+
+    neural_network = initial;
+
+    return;
+}
+
+/**
+ * @brief Deterministic benchmark inputs: bias, then ramps in [-1, 1]
+ * @param inputs The input values (output)
+ * @param n_in Number of inputs
+ * @param step Benchmark step
+ * @return void
+ */
+static void nn_benchmark_inputs(float *inputs, int n_in, int step) {
+    int y;
+
+    inputs[0] = BIAS;
+    for (y = 1; y < n_in; y++)
+        inputs[y] = (y & 1) ? (2.0f * step / NN_BENCHMARK_STEPS) - 1.0f
+                            : 1.0f - (2.0f * step / NN_BENCHMARK_STEPS);
+
+    return;
+}
+
+/**
+ * @brief Compare the loop and the unrolled kernels
+ *        For each benchmark topology, runs NN_BENCHMARK_STEPS forward and
+ *        training steps with each kernel from the same weights, stores the
+ *        cycles per step in nn_kernel_benchmark and checks that both
+ *        produce bit-identical weights. The benchmark topologies must be
+ *        generated in nn_kernels.h.
+ * @return void
+ */
+void neural_network_kernel_benchmark(void) {
+    static const struct {
+        uint16_t inputs;
+        uint16_t hidden1;
+        uint16_t hidden2;
+        float (*forward)(const float *w, const float *in, float *h1, float *h2);
+        void (*train)(float *w, const float *in, const float *h1, const float *h2, float output, float error);
+    } topologies[NN_KERNEL_BENCHMARK_TOPOLOGIES] = {
+        { 3, 3, 2,  nn_forward_3_3_2,  nn_train_3_3_2  },
+        { 3, 6, 4,  nn_forward_3_6_4,  nn_train_3_6_4  },
+        { 3, 12, 8, nn_forward_3_12_8, nn_train_3_12_8 },
+    };
+    static float w_loop[NN_KERNEL_BENCHMARK_WEIGHTS];
+    static float w_unrolled[NN_KERNEL_BENCHMARK_WEIGHTS];
+    float inputs[NN_KERNEL_MAX_WIDTH], h1[NN_KERNEL_MAX_WIDTH], h2[NN_KERNEL_MAX_WIDTH];
+    float output;
+    uint32_t start;
+    int t, i, step, count;
+
+    for (t = 0; t < NN_KERNEL_BENCHMARK_TOPOLOGIES; t++) {
+        int n_in = topologies[t].inputs;
+        int n_h1 = topologies[t].hidden1;
+        int n_h2 = topologies[t].hidden2;
+
+        // inputs, h1, h2 and the loop kernel delta_h2 hold NN_KERNEL_MAX_WIDTH
+        count = n_h1 * (n_in + 1) + n_h2 * (n_h1 + 1) + n_h2 + 1;
+        if (count > NN_KERNEL_BENCHMARK_WEIGHTS || n_in > NN_KERNEL_MAX_WIDTH ||
+            n_h1 > NN_KERNEL_MAX_WIDTH || n_h2 > NN_KERNEL_MAX_WIDTH)
+            asm(" ESTOP0");
 
-        neural_network.bias_h1[y] += ETA * delta_h1;
+        // Deterministic weights in [-0.2, 0.8): the output stays positive
+        // over the benchmark inputs, so every step trains every layer
+        for (i = 0; i < count; i++) {
+            w_loop[i] = (float)((i * 7) % 11) / 11.0f - 0.2f;
+            w_unrolled[i] = w_loop[i];
+        }
+
+        start = read_cycle_counter();
+        for (step = 0; step < NN_BENCHMARK_STEPS; step++) {
+            nn_benchmark_inputs(inputs, n_in, step);
+
+            output = nn_forward_loop(w_loop, inputs, h1, h2, n_in, n_h1, n_h2);
+            nn_train_loop(w_loop, inputs, h1, h2, output, inputs[1] * 0.1f, n_in, n_h1, n_h2);
+        }
+        nn_kernel_benchmark[t].cycles_loop = (read_cycle_counter() - start) / NN_BENCHMARK_STEPS;
+
+        start = read_cycle_counter();
+        for (step = 0; step < NN_BENCHMARK_STEPS; step++) {
+            nn_benchmark_inputs(inputs, n_in, step);
+
+            output = topologies[t].forward(w_unrolled, inputs, h1, h2);
+            topologies[t].train(w_unrolled, inputs, h1, h2, output, inputs[1] * 0.1f);
+        }
+        nn_kernel_benchmark[t].cycles_unrolled = (read_cycle_counter() - start) / NN_BENCHMARK_STEPS;
+
+        nn_kernel_benchmark[t].inputs = n_in;
+        nn_kernel_benchmark[t].hidden1 = n_h1;
+        nn_kernel_benchmark[t].hidden2 = n_h2;
+        nn_kernel_benchmark[t].bit_exact = (memcmp(w_loop, w_unrolled, count * sizeof(float)) == 0);
     }
 
     return;
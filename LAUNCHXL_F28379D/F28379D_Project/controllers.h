@@ -10,9 +10,20 @@
 
     #include "peripheral_Setup.h"
 
-    // Controller types
+    // Controller types, index into controller_registry
     #define PI_CONTROLLER   0
     #define NNA_CONTROLLER  1
+    #define CONTROLLER_COUNT    2
+
+    /**
+     * @brief Controller arithmetic
+     *        Set to CONTROLLER_FLOAT for the float controllers
+     *        Set to CONTROLLER_FIXED for the Q24/Q15 controllers of
+     *        controllers_fixed.c
+     */
+    #define CONTROLLER_FLOAT        0
+    #define CONTROLLER_FIXED        1
+    #define CONTROLLER_ARITHMETIC   CONTROLLER_FLOAT
 
     // Neural Network parameters
     #define ALPHA           0.4f
@@ -23,19 +34,154 @@
     #define HIDDEN1_SIZE    3
     #define HIDDEN2_SIZE    2
 
+    // Flat weight array: per neuron, the bias followed by its input weights
+    #define NN_H1_WEIGHTS       (HIDDEN1_SIZE * (INPUT_SIZE + 1))
+    #define NN_H2_WEIGHTS       (HIDDEN2_SIZE * (HIDDEN1_SIZE + 1))
+    #define NN_OUT_WEIGHTS      (HIDDEN2_SIZE + 1)
+    #define NN_WEIGHT_COUNT     (NN_H1_WEIGHTS + NN_H2_WEIGHTS + NN_OUT_WEIGHTS)
+
+    #define NN_H1_BIAS(x)       ((x) * (INPUT_SIZE + 1))
+    #define NN_H1_WEIGHT(y, x)  (NN_H1_BIAS(x) + 1 + (y))      // Input y to neuron x
+    #define NN_H2_BIAS(x)       (NN_H1_WEIGHTS + (x) * (HIDDEN1_SIZE + 1))
+    #define NN_H2_WEIGHT(y, x)  (NN_H2_BIAS(x) + 1 + (y))      // Hidden 1 neuron y to neuron x
+    #define NN_OUT_BIAS         (NN_H1_WEIGHTS + NN_H2_WEIGHTS)
+    #define NN_OUT_WEIGHT(x)    (NN_OUT_BIAS + 1 + (x))
+
+    /**
+     * @brief Neural Network kernel selection
+     *        Set to NN_KERNEL_LOOP for the loop kernels (runtime sizes)
+     *        Set to NN_KERNEL_UNROLLED for the straight-line kernels of
+     *        nn_kernels.h, generated by tools/nn_codegen.py
+     */
+    #define NN_KERNEL_LOOP          0
+    #define NN_KERNEL_UNROLLED      1
+    #define NN_KERNEL               NN_KERNEL_UNROLLED
+
+    #define NN_KERNEL_MAX_WIDTH     16      // Widest layer of the loop kernel and the benchmark
+
+    /**
+     * @brief Neural Network online training placement
+     *        Set to NN_TRAINING_INLINE to run the gradient step inside
+     *        neural_network_compute (control path)
+     *        Set to NN_TRAINING_TASK to queue (inputs, error) samples to
+     *        nn_training_task, which trains a shadow copy and publishes it
+     *        Set to NN_TRAINING_CPU2 to queue them to CPU2 (nn_ipc.h), which
+     *        trains its own copy; nn_training_task publishes the weights it
+     *        posts back, CPU1 only runs inference
+     */
+    #define NN_TRAINING_INLINE      0
+    #define NN_TRAINING_TASK        1
+    #define NN_TRAINING_CPU2        2
+    #define NN_TRAINING_MODE        NN_TRAINING_TASK
+
+    #define NN_TRAINING_RING_SIZE   32      // Must be a power of two
+    #define NN_TRAINING_PERIOD      1       // Training task period (ms)
+
     /**
      * @brief Neural Network structure (3-3-2-1 architecture)
+     *        Weights and biases in the order the forward pass reads them,
+     *        see NN_H1_BIAS and following
      */
     typedef struct {
-        float weights_h1[INPUT_SIZE][HIDDEN1_SIZE];
-        float bias_h1[HIDDEN1_SIZE];
+        float weights[NN_WEIGHT_COUNT];
+    } NeuralNetwork;
 
-        float weights_h2[HIDDEN1_SIZE][HIDDEN2_SIZE];
-        float bias_h2[HIDDEN2_SIZE];
+    /**
+     * @brief Neural Network activations kept from the inference pass
+     *        so the gradient step does not recompute them
+     */
+    typedef struct {
+        float inputs[INPUT_SIZE];
+        float h1[HIDDEN1_SIZE];
+        float h2[HIDDEN2_SIZE];
+        float output;               // Output layer pre-activation
+    } NeuralNetworkActivations;
 
-        float weights_output[HIDDEN2_SIZE];
-        float bias_output;
-    } NeuralNetwork;
+    /**
+     * @brief Neural Network training path benchmark
+     *        Compares forward + neural_network_backpropagate (recomputes the
+     *        forward pass) against forward + neural_network_train (reuses it)
+     */
+    typedef struct {
+        uint32_t cycles_recompute;
+        uint32_t cycles_fused;
+        uint16_t bit_exact;
+    } NNBenchmark;
+
+    /**
+     * @brief Training sample queued by the control path
+     */
+    typedef struct {
+        float inputs[INPUT_SIZE];
+        float error;
+    } NNTrainingSample;
+
+    /**
+     * @brief Single-producer/single-consumer training sample ring
+     *        head is written only by the control path, tail only by the
+     *        training task
+     */
+    typedef struct {
+        NNTrainingSample samples[NN_TRAINING_RING_SIZE];
+        volatile uint16_t head;
+        volatile uint16_t tail;
+        uint32_t dropped;           // Samples lost with the ring full
+    } NNTrainingRing;
+
+    /**
+     * @brief Control step execution time (CPU cycles)
+     */
+    typedef struct {
+        uint32_t cycles;
+        uint32_t cycles_max;
+    } ControlStepStats;
+
+    /**
+     * @brief Loop against unrolled kernel benchmark, one topology
+     */
+    typedef struct {
+        uint16_t inputs;
+        uint16_t hidden1;
+        uint16_t hidden2;
+        uint32_t cycles_loop;       // Cycles per forward + training step
+        uint32_t cycles_unrolled;
+        uint16_t bit_exact;
+    } NNKernelBenchmark;
+
+    #define NN_KERNEL_BENCHMARK_TOPOLOGIES  3
+    #define NN_KERNEL_BENCHMARK_WEIGHTS     192     // Largest benchmark topology
+
+    /**
+     * @brief Time-to-settle after a start (system_state OFF to ON)
+     */
+    typedef struct {
+        uint32_t steps;             // Control steps since the start
+        uint32_t settle_steps;      // Steps to settle after the last start
+        float settle_time_ms;       // settle_steps at the measured control loop rate
+        uint16_t hold;
+        uint16_t settled;
+    } SettleStats;
+
+    #define SETTLE_BAND         0.02f       // Settled within 2% of the setpoint...
+    #define SETTLE_HOLD         200         // ...for this many consecutive control steps
+
+    // Uncomment to run the training path and kernel benchmarks in controller_init
+    // #define NN_BENCHMARK
+    #define NN_BENCHMARK_STEPS  64
+
+    /**
+     * @brief Controller descriptor
+     *        transfer initializes the controller from the output and
+     *        measurements of the controller it replaces (bumpless switch)
+     */
+    typedef struct {
+        const char *name;
+        uint16_t state_size;        // sizeof the controller state
+        void (*init)(void);
+        float (*step)(float setpoint, float measured_voltage, float measured_current);
+        void (*reset)(void);
+        void (*transfer)(float duty, float setpoint, float measured_voltage, float measured_current);
+    } ControllerDescriptor;
 
     /**
      * @brief PI Controller structure
@@ -54,21 +200,45 @@
     extern NeuralNetwork neural_network;
     extern PIController pi_controller;
     extern uint8_t current_controller_type;
+    extern volatile uint8_t controller_request;
+    extern uint16_t controller_switch_count;
+    extern const ControllerDescriptor controller_registry[CONTROLLER_COUNT];
+    extern const ControllerDescriptor *active_controller;
+
+    // Control loop statistics
+    extern volatile uint32_t control_loop_count;
+    extern float control_loop_rate;
+    extern NNBenchmark nn_benchmark;
+    extern NNKernelBenchmark nn_kernel_benchmark[NN_KERNEL_BENCHMARK_TOPOLOGIES];
+    extern ControlStepStats control_step_stats;
+    extern SettleStats settle_stats;
+
+    // Neural Network training state
+    extern NeuralNetwork nn_weights[2];
+    extern volatile uint16_t nn_weights_index;
+    extern NNTrainingRing nn_training_ring;
+    extern uint32_t nn_training_updates;
 
     // Controller interface functions
     void controller_init(uint8_t controller_type);
     float controller_compute(float setpoint, float measured_voltage, float measured_current);
     void controller_reset(void);
+    void controller_step(void);
+    uint16_t controller_select(uint8_t controller_type);
 
     // PI Controller functions
     void pi_controller_init(void);
     float pi_controller_compute(float setpoint, float measured_voltage);
     void pi_controller_reset(void);
+    void pi_controller_transfer(float duty, float setpoint, float measured_voltage, float measured_current);
 
     // Neural Network functions
     void neural_network_init(void);
     float neural_network_compute(float setpoint, float measured_voltage, float measured_current);
     void neural_network_reset(void);
+    void neural_network_transfer(float duty, float setpoint, float measured_voltage, float measured_current);
+    void neural_network_publish(void);
+    void neural_network_training_service(void);
 
     // Neural Network utility functions
     float custom_sqrt(float value);
@@ -78,6 +248,10 @@
     float relu_clipped(float value);
     float sigmoid(float output);
     float neural_network_forward(float inputs[INPUT_SIZE]);
+    float neural_network_forward_cached(const NeuralNetwork *network, float inputs[INPUT_SIZE], NeuralNetworkActivations *activations);
     void neural_network_backpropagate(float inputs[INPUT_SIZE], float target, float error);
+    void neural_network_train(const NeuralNetworkActivations *activations, float error);
+    void neural_network_benchmark(void);
+    void neural_network_kernel_benchmark(void);
 
 #endif /* CONTROLLERS_H */
@@ -0,0 +1,410 @@
+/**
+ * @file controllers_fixed.c
+ * @brief Implementation of the fixed-point (Q24/Q15) controllers
+ *        Same control laws as controllers.c, selected with
+ *        CONTROLLER_ARITHMETIC == CONTROLLER_FIXED
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "controllers_fixed.h"
+
+// Global controller instances
+PIControllerQ pi_controller_q;
+NeuralNetworkQ neural_network_q;
+q15_t controller_output_q15 = 0;
+FixedErrorCheck fixed_error_check = {0};
+
+// PI Controller implementation
+
+/**
+ * @brief Initialize Q24 PI controller with the float controller parameters
+ * @return void
+ */
+void pi_controller_q_init(void) {
+    pi_controller_q.error       = 0;
+    pi_controller_q.error_old   = 0;
+    pi_controller_q.output      = 0;
+    pi_controller_q.output_old  = 0;
+
+    // Tuned parameters for buck converter, see pi_controller_init
+    pi_controller_q.b0 = Q24(0.063288f);
+    pi_controller_q.b1 = Q24(-0.060934f);
+    pi_controller_q.a1 = Q24(-1.0f);
+
+    return;
+}
+
+/**
+ * @brief Compute Q24 PI controller output
+ * @param setpoint Desired setpoint value
+ * @param measured_voltage Measured voltage value
+ * @return Computed controller output
+ */
+float pi_controller_q_compute(float setpoint, float measured_voltage) {
+    pi_controller_q.error = q24_from_float(setpoint - measured_voltage, 1.0f);
+
+    pi_controller_q.output = q24_sub(
+        q24_add(q24_mul(pi_controller_q.error, pi_controller_q.b0),
+                q24_mul(pi_controller_q.error_old, pi_controller_q.b1)),
+        q24_mul(pi_controller_q.output_old, pi_controller_q.a1));
+
+    pi_controller_q.error_old = pi_controller_q.error;
+    pi_controller_q.output_old = pi_controller_q.output;
+
+    // Saturate output
+    if (pi_controller_q.output >= Q24_ONE) {
+        controller_output_q15 = Q15_MAX;
+        return 1.0f;
+    }
+    if (pi_controller_q.output <= 0) {
+        controller_output_q15 = 0;
+        return 0.0f;
+    }
+
+    controller_output_q15 = q24_to_q15(pi_controller_q.output);
+
+    return q24_to_float(pi_controller_q.output);
+}
+
+/**
+ * @brief Reset Q24 PI controller state
+ * @return void
+ */
+void pi_controller_q_reset(void) {
+    pi_controller_q.error       = 0;
+    pi_controller_q.error_old   = 0;
+    pi_controller_q.output      = 0;
+    pi_controller_q.output_old  = 0;
+
+    return;
+}
+
+/**
+ * @brief Initialize Q24 PI controller state from the previous controller
+ * @param duty Last duty cycle applied
+ * @param setpoint Desired setpoint value
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value (unused)
+ * @return void
+ */
+void pi_controller_q_transfer(float duty, float setpoint, float measured_voltage, float measured_current) {
+    pi_controller_q.error       = q24_from_float(setpoint - measured_voltage, 1.0f);
+    pi_controller_q.error_old   = pi_controller_q.error;
+    pi_controller_q.output      = q24_from_float(duty, 1.0f);
+    pi_controller_q.output_old  = pi_controller_q.output;
+
+    return;
+}
+
+// Neural Network implementation
+
+/**
+ * @brief Q24 ReLU
+ */
+static inline q24_t relu_q(q24_t value) {
+    return (value > 0) ? value : 0;
+}
+
+/**
+ * @brief Q24 clipped leaky ReLU, see relu_clipped
+ */
+static inline q24_t relu_clipped_q(q24_t value) {
+    value = (value > 0) ? value : q24_mul(value, Q24(0.01f));
+
+    return (value < Q24_ONE) ? value : Q24_ONE;
+}
+
+/**
+ * @brief Q24 forward pass over the flat weight array
+ * @param inputs The input values
+ * @param h1 Hidden layer 1 activations (output)
+ * @param h2 Hidden layer 2 activations (output)
+ * @return q24_t The output layer pre-activation
+ */
+static q24_t neural_network_q_forward(const q24_t inputs[INPUT_SIZE], q24_t h1[HIDDEN1_SIZE], q24_t h2[HIDDEN2_SIZE]) {
+    const q24_t *w = neural_network_q.weights;
+    q24_t output;
+    int x, y;
+
+    // Hidden layer 1
+    for (x = 0; x < HIDDEN1_SIZE; x++) {
+        h1[x] = w[NN_H1_BIAS(x)];
+
+        for (y = 0; y < INPUT_SIZE; y++)
+            h1[x] = q24_add(h1[x], q24_mul(inputs[y], w[NN_H1_WEIGHT(y, x)]));
+
+        h1[x] = relu_q(h1[x]);
+    }
+
+    // Hidden layer 2
+    for (x = 0; x < HIDDEN2_SIZE; x++) {
+        h2[x] = w[NN_H2_BIAS(x)];
+
+        for (y = 0; y < HIDDEN1_SIZE; y++)
+            h2[x] = q24_add(h2[x], q24_mul(h1[y], w[NN_H2_WEIGHT(y, x)]));
+
+        h2[x] = relu_q(h2[x]);
+    }
+
+    // Output layer
+    output = w[NN_OUT_BIAS];
+    for (x = 0; x < HIDDEN2_SIZE; x++)
+        output = q24_add(output, q24_mul(h2[x], w[NN_OUT_WEIGHT(x)]));
+
+    return output;
+}
+
+/**
+ * @brief Q24 gradient step, same update order as neural_network_train
+ * @param inputs The input values of the forward pass
+ * @param h1 Hidden layer 1 activations of the forward pass
+ * @param h2 Hidden layer 2 activations of the forward pass
+ * @param output The output layer pre-activation
+ * @param error The error value
+ * @return void
+ */
+static void neural_network_q_train(const q24_t inputs[INPUT_SIZE], const q24_t h1[HIDDEN1_SIZE],
+                                   const q24_t h2[HIDDEN2_SIZE], q24_t output, q24_t error) {
+    q24_t *w = neural_network_q.weights;
+    q24_t delta_h2[HIDDEN2_SIZE];
+    q24_t delta_output, eta_delta, sum;
+    int x, y;
+
+    // Backpropagation
+    delta_output = (relu_q(output) > 0) ? error : 0;
+    eta_delta = q24_mul(Q24(ETA), delta_output);
+
+    // Update output layer
+    for (x = 0; x < HIDDEN2_SIZE; x++)
+        w[NN_OUT_WEIGHT(x)] = q24_add(w[NN_OUT_WEIGHT(x)], q24_mul(eta_delta, h2[x]));
+
+    w[NN_OUT_BIAS] = q24_add(w[NN_OUT_BIAS], eta_delta);
+
+    // Update hidden layer 2
+    for (x = 0; x < HIDDEN2_SIZE; x++) {
+        delta_h2[x] = (h2[x] > 0) ? q24_mul(delta_output, w[NN_OUT_WEIGHT(x)]) : 0;
+        eta_delta = q24_mul(Q24(ETA), delta_h2[x]);
+
+        for (y = 0; y < HIDDEN1_SIZE; y++)
+            w[NN_H2_WEIGHT(y, x)] = q24_add(w[NN_H2_WEIGHT(y, x)], q24_mul(eta_delta, h1[y]));
+
+        w[NN_H2_BIAS(x)] = q24_add(w[NN_H2_BIAS(x)], eta_delta);
+    }
+
+    // Update hidden layer 1
+    for (y = 0; y < HIDDEN1_SIZE; y++) {
+        sum = 0;
+
+        for (x = 0; x < HIDDEN2_SIZE; x++)
+            sum = q24_add(sum, q24_mul(delta_h2[x], w[NN_H2_WEIGHT(y, x)]));
+
+        eta_delta = (h1[y] > 0) ? q24_mul(Q24(ETA), sum) : 0;
+
+        for (x = 0; x < INPUT_SIZE; x++)
+            w[NN_H1_WEIGHT(x, y)] = q24_add(w[NN_H1_WEIGHT(x, y)], q24_mul(eta_delta, inputs[x]));
+
+        w[NN_H1_BIAS(y)] = q24_add(w[NN_H1_BIAS(y)], eta_delta);
+    }
+
+    return;
+}
+
+/**
+ * @brief Load the Q24 neural network from the float weights
+ * @return void
+ */
+static void neural_network_q_load(void) {
+    int x;
+
+    for (x = 0; x < NN_WEIGHT_COUNT; x++)
+        neural_network_q.weights[x] = q24_from_float(neural_network.weights[x], 1.0f);
+
+    return;
+}
+
+/**
+ * @brief Initialize the Q24 neural network from the float initialization
+ * @return void
+ */
+void neural_network_q_init(void) {
+    neural_network_init();
+    neural_network_q_load();
+
+    return;
+}
+
+/**
+ * @brief Normalize the measurements into the Q24 network inputs
+ * @param inputs The input values (output)
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value
+ * @return void
+ */
+static void neural_network_q_inputs(q24_t inputs[INPUT_SIZE], float measured_voltage, float measured_current) {
+    inputs[0] = Q24(BIAS);
+    inputs[1] = q24_sub(q24_from_float(measured_voltage, 2.0f / MAX_VOLTAGE), Q24_ONE);
+    inputs[2] = q24_sub(q24_from_float(measured_current, 2.0f / MAX_CURRENT_mA), Q24_ONE);
+
+    if (inputs[2] < -Q24_ONE)
+        inputs[2] = -Q24_ONE;
+    if (inputs[2] > Q24_ONE)
+        inputs[2] = Q24_ONE;
+
+    return;
+}
+
+/**
+ * @brief Compute Q24 neural network output with real-time training
+ *        Training runs inline, NN_TRAINING_MODE applies to the float
+ *        controller only
+ * @param setpoint Desired setpoint value
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value
+ * @return Computed controller output
+ */
+float neural_network_q_compute(float setpoint, float measured_voltage, float measured_current) {
+    q24_t inputs[INPUT_SIZE];
+    q24_t h1[HIDDEN1_SIZE];
+    q24_t h2[HIDDEN2_SIZE];
+    q24_t output, output_network, error_norm;
+
+    neural_network_q_inputs(inputs, measured_voltage, measured_current);
+
+    // Forward pass
+    output = neural_network_q_forward(inputs, h1, h2);
+    output_network = relu_clipped_q(output);
+
+    // Clamp output
+    if (output_network > Q24(0.975f))
+        output_network = Q24(0.975f);
+    if (output_network < Q24(0.025f))
+        output_network = Q24(0.025f);
+
+    // Training
+    error_norm = q24_from_float(setpoint - measured_voltage, 1.0f / MAX_VOLTAGE);
+    neural_network_q_train(inputs, h1, h2, output, error_norm);
+
+    controller_output_q15 = q24_to_q15(output_network);
+
+    return q24_to_float(output_network);
+}
+
+/**
+ * @brief Reset Q24 neural network
+ *        Warm restart: the learned weights are kept, training runs inline
+ *        and keeps no other state
+ * @return void
+ */
+void neural_network_q_reset(void) {
+    return;
+}
+
+/**
+ * @brief Shift the Q24 output bias so the network continues from duty
+ * @param duty Last duty cycle applied
+ * @param setpoint Desired setpoint value (unused)
+ * @param measured_voltage Measured voltage value
+ * @param measured_current Measured current value
+ * @return void
+ */
+void neural_network_q_transfer(float duty, float setpoint, float measured_voltage, float measured_current) {
+    q24_t inputs[INPUT_SIZE];
+    q24_t h1[HIDDEN1_SIZE];
+    q24_t h2[HIDDEN2_SIZE];
+    q24_t output;
+
+    neural_network_q_inputs(inputs, measured_voltage, measured_current);
+    output = neural_network_q_forward(inputs, h1, h2);
+
+    neural_network_q.weights[NN_OUT_BIAS] = q24_add(neural_network_q.weights[NN_OUT_BIAS],
+                                                    q24_sub(q24_from_float(duty, 1.0f), output));
+
+    return;
+}
+
+// Verification
+
+/**
+ * @brief Bound the fixed-point error against the float controllers
+ *        Sweeps setpoint and measured voltage over [0, MAX_VOLTAGE] with
+ *        FIXED_ERROR_POINTS points each, running the float and the Q24
+ *        controllers in lockstep (including NN training) from the same
+ *        state, and stores the largest output difference in
+ *        fixed_error_check. Controller states are reset afterwards.
+ * @return void
+ */
+void controller_fixed_error_check(void) {
+    NeuralNetwork nn_float;
+    NeuralNetworkActivations activations;
+    float inputs[INPUT_SIZE];
+    float setpoint, voltage, current;
+    float out_float, out_fixed, diff;
+    int s, v;
+
+    fixed_error_check.pi_max_error = 0.0f;
+    fixed_error_check.nn_max_error = 0.0f;
+    fixed_error_check.points = 0;
+
+    pi_controller_init();
+    pi_controller_q_init();
+
+    nn_float = neural_network;
+    neural_network_q_load();
+
+    for (s = 0; s < FIXED_ERROR_POINTS; s++) {
+        setpoint = MAX_VOLTAGE * s / (FIXED_ERROR_POINTS - 1);
+
+        pi_controller_reset();
+        pi_controller_q_reset();
+
+        for (v = 0; v < FIXED_ERROR_POINTS; v++) {
+            voltage = MAX_VOLTAGE * v / (FIXED_ERROR_POINTS - 1);
+            current = MAX_CURRENT_mA * v / (FIXED_ERROR_POINTS - 1);
+
+            // PI
+            out_float = pi_controller_compute(setpoint, voltage);
+            out_fixed = pi_controller_q_compute(setpoint, voltage);
+
+            diff = out_float - out_fixed;
+            if (diff < 0.0f)
+                diff = -diff;
+            if (diff > fixed_error_check.pi_max_error)
+                fixed_error_check.pi_max_error = diff;
+
+            // NN, float reference with inline training
+            inputs[0] = BIAS;
+            inputs[1] = (2.0f * voltage / MAX_VOLTAGE) - 1.0f;
+            inputs[2] = (2.0f * current / MAX_CURRENT_mA) - 1.0f;
+
+            out_float = neural_network_forward_cached(&neural_network, inputs, &activations);
+            if (out_float > 0.975f)
+                out_float = 0.975f;
+            if (out_float < 0.025f)
+                out_float = 0.025f;
+            neural_network_train(&activations, (setpoint - voltage) / MAX_VOLTAGE);
+
+            out_fixed = neural_network_q_compute(setpoint, voltage, current);
+
+            diff = out_float - out_fixed;
+            if (diff < 0.0f)
+                diff = -diff;
+            if (diff > fixed_error_check.nn_max_error)
+                fixed_error_check.nn_max_error = diff;
+
+            fixed_error_check.points++;
+        }
+    }
+
+    fixed_error_check.pass = (fixed_error_check.pi_max_error < FIXED_ERROR_BOUND) &&
+                             (fixed_error_check.nn_max_error < FIXED_ERROR_BOUND);
+
+    // Restore the controllers
+    neural_network = nn_float;
+    neural_network_publish();
+    neural_network_q_load();
+    pi_controller_reset();
+    pi_controller_q_reset();
+
+    return;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file controllers_fixed.h
+ * @brief Fixed-point (Q24/Q15) PI and Neural Network controllers
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef CONTROLLERS_FIXED_H
+#define CONTROLLERS_FIXED_H
+
+    #include "controllers.h"
+
+    /**
+     * @brief Q formats
+     *        Q24: 32-bit, 24 fractional bits, range [-128, 128), states,
+     *             signals and weights
+     *        Q15: 16-bit, 15 fractional bits, range [-1, 1), duty cycle
+     */
+    typedef int32_t q24_t;
+    typedef int16_t q15_t;
+
+    #define Q24_SHIFT       24
+    #define Q24_ONE         16777216L
+    #define Q24_MAX         INT32_MAX
+    #define Q24_MIN         INT32_MIN
+    #define Q24(x)          ((q24_t)((x) * 16777216.0f))    // Constant conversion
+
+    #define Q15_ONE         32768L
+    #define Q15_MAX         INT16_MAX
+
+    // Error bound of the fixed-point controllers against the float reference
+    #define FIXED_ERROR_BOUND       1.0e-3f
+    #define FIXED_ERROR_POINTS      64          // Setpoint and voltage sweep points
+
+    // Uncomment to run the fixed-point error check in controller_init
+    // #define FIXED_ERROR_CHECK
+
+    /**
+     * @brief PI Controller structure, Q24
+     */
+    typedef struct {
+        q24_t error;
+        q24_t error_old;
+
+        q24_t output;
+        q24_t output_old;
+
+        q24_t b0, b1, a1;  // PI parameters
+    } PIControllerQ;
+
+    /**
+     * @brief Neural Network structure, Q24, same layout as NeuralNetwork
+     */
+    typedef struct {
+        q24_t weights[NN_WEIGHT_COUNT];
+    } NeuralNetworkQ;
+
+    /**
+     * @brief Fixed-point against float controller error over the
+     *        setpoint and voltage range
+     */
+    typedef struct {
+        float pi_max_error;
+        float nn_max_error;
+        uint32_t points;
+        uint16_t pass;              // Both errors within FIXED_ERROR_BOUND
+    } FixedErrorCheck;
+
+    // Global controller instances
+    extern PIControllerQ pi_controller_q;
+    extern NeuralNetworkQ neural_network_q;
+    extern q15_t controller_output_q15;
+    extern FixedErrorCheck fixed_error_check;
+
+    // Saturating Q24 arithmetic
+
+    /**
+     * @brief Saturate a 64-bit intermediate to Q24
+     */
+    static inline q24_t q24_sat(int64_t value) {
+        if (value > Q24_MAX)
+            return Q24_MAX;
+        if (value < Q24_MIN)
+            return Q24_MIN;
+
+        return (q24_t)value;
+    }
+
+    static inline q24_t q24_add(q24_t a, q24_t b) {
+        return q24_sat((int64_t)a + b);
+    }
+
+    static inline q24_t q24_sub(q24_t a, q24_t b) {
+        return q24_sat((int64_t)a - b);
+    }
+
+    static inline q24_t q24_mul(q24_t a, q24_t b) {
+        return q24_sat(((int64_t)a * b) >> Q24_SHIFT);
+    }
+
+    /**
+     * @brief Convert a float scaled by scale to Q24, saturating
+     */
+    static inline q24_t q24_from_float(float value, float scale) {
+        value *= scale * 16777216.0f;
+
+        if (value >= 2147483647.0f)
+            return Q24_MAX;
+        if (value <= -2147483648.0f)
+            return Q24_MIN;
+
+        return (q24_t)value;
+    }
+
+    static inline float q24_to_float(q24_t value) {
+        return (float)value * (1.0f / 16777216.0f);
+    }
+
+    /**
+     * @brief Convert Q24 to Q15, saturating to [-1, 1)
+     */
+    static inline q15_t q24_to_q15(q24_t value) {
+        value >>= (Q24_SHIFT - 15);
+
+        if (value > Q15_MAX)
+            return Q15_MAX;
+        if (value < -Q15_ONE)
+            return (q15_t)(-Q15_ONE);
+
+        return (q15_t)value;
+    }
+
+    // PI Controller functions
+    void pi_controller_q_init(void);
+    float pi_controller_q_compute(float setpoint, float measured_voltage);
+    void pi_controller_q_reset(void);
+    void pi_controller_q_transfer(float duty, float setpoint, float measured_voltage, float measured_current);
+
+    // Neural Network functions
+    void neural_network_q_init(void);
+    float neural_network_q_compute(float setpoint, float measured_voltage, float measured_current);
+    void neural_network_q_reset(void);
+    void neural_network_q_transfer(float duty, float setpoint, float measured_voltage, float measured_current);
+
+    // Verification
+    void controller_fixed_error_check(void);
+
+#endif /* CONTROLLERS_FIXED_H */
@@ -11,24 +11,57 @@
 static StaticTask_t update_time_task_buffer;
 static StaticTask_t communication_task_buffer;
 static StaticTask_t control_task_buffer;
+static StaticTask_t nn_training_task_buffer;
+static StaticTask_t uart_link_task_buffer;
+#if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED)
+static StaticTask_t waveform_task_buffer;
+#endif
 static StaticTask_t idle_task_buffer;
 
 static StackType_t update_time_task_stack[STACK_SIZE];
 static StackType_t communication_task_stack[STACK_SIZE];
 static StackType_t control_task_stack[STACK_SIZE];
+static StackType_t nn_training_task_stack[STACK_SIZE];
+static StackType_t uart_link_task_stack[STACK_SIZE];
+#if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED)
+static StackType_t waveform_task_stack[STACK_SIZE];
+#endif
 static StackType_t idle_task_stack[STACK_SIZE];
 
 // freeRTOS objects
 SemaphoreHandle_t communication_semaphore = NULL;
 QueueHandle_t control_queue = NULL;
 
-// External variables
-extern MEDIDA medidasADC;
-extern InputMonitor input_monitor;
-extern SetpointFilter setpoint_filter;
+static TaskHandle_t update_time_task_handle = NULL;
+static TaskHandle_t control_task_handle = NULL;
+
+// Run time statistics of a profile dump
+static TaskStatus_t task_status[MAX_TASKS];
+
+// Periodic tasks, created in this order by freeRTOS_Setup
+PeriodicTask periodic_tasks[] = {
+    {update_time_task, "UpdateTimeTask", TASK3_PERIOD, TASK3_STARTUP_DELAY, PERIODIC_RELEASE_TIMER, tskIDLE_PRIORITY + 1,
+     PROFILE_UPDATE_TIME, 13, update_time_task_stack, &update_time_task_buffer, &update_time_task_handle},
+    {communication_task, "CommTask", TASK1_PERIOD, TASK1_STARTUP_DELAY, PERIODIC_RELEASE_TIMER, tskIDLE_PRIORITY + 1,
+     PROFILE_COMMUNICATION, 12, communication_task_stack, &communication_task_buffer, NULL},
+    {control_task, "ControlTask", TASK2_PERIOD, TASK2_STARTUP_DELAY, CONTROL_RELEASE, tskIDLE_PRIORITY + 4,
+     PROFILE_CONTROL, 8, control_task_stack, &control_task_buffer, &control_task_handle},
+#if (NN_TRAINING_MODE != NN_TRAINING_INLINE) || defined(NN_SNAPSHOT_ENABLE)
+    {nn_training_task, "NNTrainingTask", NN_TRAINING_PERIOD, 0, PERIODIC_RELEASE_TIMER, tskIDLE_PRIORITY + 1,
+     PROFILE_NN_TRAINING, 13, nn_training_task_stack, &nn_training_task_buffer, NULL},
+#endif
+    {uart_link_task, "UartLinkTask", UART_LINK_PERIOD, 0, PERIODIC_RELEASE_TIMER, tskIDLE_PRIORITY + 2,
+     PROFILE_UART_LINK, 10, uart_link_task_stack, &uart_link_task_buffer, NULL},
+#if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED)
+    {waveform_task, "WaveformTask", WAVEFORM_TASK_PERIOD, 0, PERIODIC_RELEASE_TIMER, tskIDLE_PRIORITY + 2,
+     PROFILE_WAVEFORM, 11, waveform_task_stack, &waveform_task_buffer, NULL},
+#endif
+};
+
+const uint16_t periodic_task_count = sizeof(periodic_tasks) / sizeof(periodic_tasks[0]);
 
+// External variables
 extern uint16_t i2c_status;
-extern uint16_t pwm_factor;
 
 extern uint16_t hours;
 extern uint16_t minutes;
@@ -38,27 +71,128 @@ extern uint16_t hours_decimal;
 extern uint16_t minutes_decimal;
 extern uint16_t seconds_decimal;
 
-extern float duty_cycle;
-extern char system_state;
+#if (I2C_READ_MODE == I2C_READ_INTERRUPT)
+/**
+ * @brief Completion of the DS3231 burst read, called from i2cb_isr
+ */
+static void update_time_notify(void) {
+    BaseType_t woken = pdFALSE;
 
-void update_time_task(void *pvParameters) {
-    vTaskDelay(TASK3_STARTUP_DELAY / portTICK_PERIOD_MS);
+    vTaskNotifyGiveFromISR(update_time_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
 
-    while (1) {
-        vTaskDelay(TASK3_LOOP_DELAY / portTICK_PERIOD_MS);
-        ServiceDog();
+    return;
+}
+#endif
 
-        i2c_status = ds3231_read_time(&hours, &minutes, &seconds);
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+/**
+ * @brief Release control_task, called from adcc1_isr after every
+ *        publication of measurement_snapshot
+ */
+static void control_notify(void) {
+    static uint16_t conversions = 0;
+    BaseType_t woken = pdFALSE;
+
+    if (++conversions < CONTROL_NOTIFY_DECIMATION)
+        return;
+
+    conversions = 0;
+
+    vTaskNotifyGiveFromISR(control_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+
+    return;
+}
+#endif
 
-        if (i2c_status == I2C_SUCCESS) {
-            hours_decimal = bcd_to_decimal(hours);
-            minutes_decimal = bcd_to_decimal(minutes);
-            seconds_decimal = bcd_to_decimal(seconds);
+/**
+ * @brief Read the DS3231 time into hours, minutes and seconds (BCD)
+ *        With I2C_READ_MODE == I2C_READ_INTERRUPT the task starts a burst
+ *        read and blocks on its notification while i2cb_isr runs the
+ *        transfer. The CPU time of each read is kept in rtc_stats.
+ * @return uint16_t I2C_SUCCESS or the I2C error
+ */
+static uint16_t update_time_read(void) {
+    uint32_t read_start, read_cycles;
+    uint16_t status;
+
+#if (I2C_READ_MODE == I2C_READ_INTERRUPT)
+    // Drop a completion that arrived after a timeout
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    read_start = read_cycle_counter();
+    status = ds3231_read_time_start(update_time_notify);
+    read_cycles = read_cycle_counter() - read_start;
+
+    if (status == I2C_SUCCESS) {
+        if (ulTaskNotifyTake(pdTRUE, RTC_READ_TIMEOUT / portTICK_PERIOD_MS) == 0) {
+            i2c_abort();
+            status = I2C_TIMEOUT_ERROR;
+            rtc_stats.timeouts++;
+        }
+        else {
+            read_start = read_cycle_counter();
+            status = ds3231_read_time_result(&hours, &minutes, &seconds);
+            read_cycles += read_cycle_counter() - read_start + i2c_transfer.isr_cycles;
         }
+    }
+#else
+    read_start = read_cycle_counter();
+    status = ds3231_read_time(&hours, &minutes, &seconds);
+    read_cycles = read_cycle_counter() - read_start;
+#endif
+
+    rtc_stats.cycles = read_cycles;
+    if (rtc_stats.cycles > rtc_stats.cycles_max)
+        rtc_stats.cycles_max = rtc_stats.cycles;
+    rtc_stats.reads++;
+
+    if (status != I2C_SUCCESS)
+        rtc_stats.errors++;
+
+    return status;
+}
+
+/**
+ * @brief Update time task - keeps the wall clock (timebase.h)
+ *        HH:MM:SS comes from the Timer1 timebase. Every TIME_RESYNC_PERIOD
+ *        seconds the DS3231 is read every period until its seconds change;
+ *        the edge, halfway between the last two reads, resyncs the wall
+ *        clock and its drift estimate. No I2C traffic in between.
+ */
+void update_time_task(void) {
+    static TickType_t last_sync = 0;
+    static uint64_t read_time = 0, last_read_time = 0;
+    static uint16_t resync = 1, last_seconds = 0xFFFF;
+
+    if (resync) {
+        i2c_status = update_time_read();
+        read_time = timebase_now_us();
 
-        vTaskDelay(TASK3_END_DELAY / portTICK_PERIOD_MS);
+        if (i2c_status != I2C_SUCCESS)
+            last_seconds = 0xFFFF;
+        else {
+            if ((last_seconds != 0xFFFF) && (seconds != last_seconds)) {
+                wall_clock_sync(bcd_to_decimal(hours) * 3600UL + bcd_to_decimal(minutes) * 60UL + bcd_to_decimal(seconds),
+                                last_read_time + (read_time - last_read_time) / 2);
+
+                last_sync = xTaskGetTickCount();
+                resync = 0;
+            }
+
+            last_seconds = seconds;
+            last_read_time = read_time;
+        }
+    }
+    else if ((xTaskGetTickCount() - last_sync) >= (TIME_RESYNC_PERIOD * 1000UL / portTICK_PERIOD_MS)) {
+        last_seconds = 0xFFFF;
+        resync = 1;
     }
 
+    wall_clock_time(&hours_decimal, &minutes_decimal, &seconds_decimal);
+
+    return;
 }
 
 /**
@@ -75,110 +209,277 @@ void update_time_task(void *pvParameters) {
  *          MINUTES_DECIMAL
  *          :
  *          SECONDS_DECIMAL
+ *        With TELEMETRY_FORMAT == TELEMETRY_BINARY a status frame is sent
+ *        instead, preceded by an info frame every TELEMETRY_INFO_PERIOD
+ *        status frames (see telemetry.h). Counted apart from the waveform
+ *        and profile frames, so the receiver gets the full tick count
+ *        the status frames extend regularly
+ *        The CPU time spent on each frame is kept in uart_tx_stats
  */
-void communication_task(void *pvParameters) {
-    vTaskDelay(TASK1_STARTUP_DELAY / portTICK_PERIOD_MS);
+void communication_task(void) {
+#if (TELEMETRY_FORMAT == TELEMETRY_ASCII)
+    Measurements measurements;
+#else
+    static uint16_t status_frames = 0;
+#endif
+    uint32_t frame_start;
 
-    while (1) {
-        vTaskDelay(TASK1_LOOP_DELAY / portTICK_PERIOD_MS);
-        ServiceDog();
+    frame_start = read_cycle_counter();
 
-        if (system_state) {
-            GpioDataRegs.GPBCLEAR.bit.GPIO34 = 1;
+    // SCI-C is shared with waveform_task and uart_link_task
+    xSemaphoreTake(communication_semaphore, portMAX_DELAY);
 
-            int decimal_part;
+#if (TELEMETRY_FORMAT == TELEMETRY_BINARY)
+    if (system_state)
+        GpioDataRegs.GPBCLEAR.bit.GPIO34 = 1;
 
-            uart_send_int(setpoint_filter.setpoint);
-            decimal_part = (setpoint_filter.setpoint - (int)setpoint_filter.setpoint) * 10;
-            uart_send_char('.');
-            uart_send_int(decimal_part);
+    if ((status_frames++ % TELEMETRY_INFO_PERIOD) == 0)
+        telemetry_send_info(xTaskGetTickCount() * portTICK_PERIOD_MS);
 
-            uart_send_char(',');
+    telemetry_send_status(xTaskGetTickCount() * portTICK_PERIOD_MS);
+#else
+    measurement_read(&measurements);
 
-            uart_send_int(medidasADC.valor_real[Tensao_DC]);
-            decimal_part = (medidasADC.valor_real[Tensao_DC] - (int)medidasADC.valor_real[Tensao_DC]) * 10;
-            uart_send_char('.');
-            uart_send_int(decimal_part);
+    if (measurements.system_state) {
+        GpioDataRegs.GPBCLEAR.bit.GPIO34 = 1;
 
-            uart_send_char(',');
+        int decimal_part;
 
-            uart_send_int(medidasADC.valor_real[Corrente_carga]);
-            decimal_part = (medidasADC.valor_real[Corrente_carga] - (int)medidasADC.valor_real[Corrente_carga]) * 10;
-            uart_send_char('.');
-            if (decimal_part > 0)
-                uart_send_int(decimal_part);
-            else
-                uart_send_int(0);
-        }
-        else
-            uart_send_string("OFF");
+        uart_send_int(measurements.setpoint);
+        decimal_part = (measurements.setpoint - (int)measurements.setpoint) * 10;
+        uart_send_char('.');
+        uart_send_int(decimal_part);
 
         uart_send_char(',');
 
-        if (hours_decimal < 10)
-            uart_send_char('0');
-        uart_send_int(hours_decimal);
+        uart_send_int(measurements.voltage);
+        decimal_part = (measurements.voltage - (int)measurements.voltage) * 10;
+        uart_send_char('.');
+        uart_send_int(decimal_part);
 
-        uart_send_char(':');
+        uart_send_char(',');
 
-        if (minutes_decimal < 10)
-            uart_send_char('0');
-        uart_send_int(minutes_decimal);
+        uart_send_int(measurements.current);
+        decimal_part = (measurements.current - (int)measurements.current) * 10;
+        uart_send_char('.');
+        if (decimal_part > 0)
+            uart_send_int(decimal_part);
+        else
+            uart_send_int(0);
+    }
+    else
+        uart_send_string("OFF");
 
-        uart_send_char(':');
+    uart_send_char(',');
 
-        if (seconds_decimal < 10)
-            uart_send_char('0');
-        uart_send_int(seconds_decimal);
+    if (hours_decimal < 10)
+        uart_send_char('0');
+    uart_send_int(hours_decimal);
 
-        vTaskDelay(TASK1_END_DELAY / portTICK_PERIOD_MS);
-    }
+    uart_send_char(':');
+
+    if (minutes_decimal < 10)
+        uart_send_char('0');
+    uart_send_int(minutes_decimal);
+
+    uart_send_char(':');
+
+    if (seconds_decimal < 10)
+        uart_send_char('0');
+    uart_send_int(seconds_decimal);
+#endif
+
+    xSemaphoreGive(communication_semaphore);
+
+    // Includes the time spent waiting for the transmitter with UART_TX_POLLED
+    uart_tx_stats.frame_cycles = read_cycle_counter() - frame_start;
+    if (uart_tx_stats.frame_cycles > uart_tx_stats.frame_cycles_max)
+        uart_tx_stats.frame_cycles_max = uart_tx_stats.frame_cycles;
+    uart_tx_stats.frames++;
+
+    return;
 }
 
 /**
  * @brief Control task - executes main control loop
+ *        With CONTROL_LOOP_MODE == CONTROL_LOOP_ISR the control law runs in
+ *        adcc1_isr and this task only reports the achieved loop rate.
  */
-void control_task(void *pvParameters) {
-    float controller_output = 0.0f;
-    char reset_flag = 1;
+void control_task(void) {
+    static TickType_t rate_window_start = 0;
+    static uint32_t rate_window_count = 0;
+    TickType_t now;
+
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+    controller_step();
+#endif
+
+    // Achieved control loop rate (Hz) over the last window
+    now = xTaskGetTickCount();
+    if ((now - rate_window_start) >= (CONTROL_RATE_WINDOW / portTICK_PERIOD_MS)) {
+        control_loop_rate = (float)(control_loop_count - rate_window_count) * 1000.0f /
+                            (float)((now - rate_window_start) * portTICK_PERIOD_MS);
+
+        rate_window_start = now;
+        rate_window_count = control_loop_count;
+    }
 
-    vTaskDelay(TASK2_STARTUP_DELAY / portTICK_PERIOD_MS);
+    return;
+}
 
-    while (1) {
-        vTaskDelay(TASK2_LOOP_DELAY / portTICK_PERIOD_MS);
-        ServiceDog();
+/**
+ * @brief Neural network training task - runs the NN gradient steps
+ *        queued by the control path on the shadow weights and publishes
+ *        them, keeping backpropagation out of the control step.
+ *        With NN_TRAINING_CPU2 it publishes the weights trained by CPU2.
+ *        Also takes the periodic weight snapshots.
+ *        Created with NN_TRAINING_TASK, NN_TRAINING_CPU2 or
+ *        NN_SNAPSHOT_ENABLE.
+ */
+void nn_training_task(void) {
+#if (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    neural_network_training_service();
+#endif
+
+    nn_snapshot_periodic(NN_TRAINING_PERIOD);
+
+    return;
+}
 
-        if (system_state) {
-            GpioDataRegs.GPACLEAR.bit.GPIO31 = 1;
+/**
+ * @brief Waveform task - streams the samples recorded by adcc1_isr
+ *        Sends a block whenever WAVEFORM_BLOCK_SAMPLES are waiting. Frames
+ *        are only started with room for a whole frame in the UART ring, so
+ *        when the link cannot keep up the sample ring fills and adcc1_isr
+ *        drops samples (reported in every block) instead of corrupting frames.
+ *        Created with WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED.
+ */
+void waveform_task(void) {
+    while (waveform_available() >= WAVEFORM_BLOCK_SAMPLES) {
+        xSemaphoreTake(communication_semaphore, portMAX_DELAY);
 
-            reset_flag = 1;
+        while (uart_tx_free() < TELEMETRY_MAX_FRAME)
+            vTaskDelay(1);
 
-            if (setpoint_filter.setpoint < (0.975f * input_monitor.voltage)) {
-                controller_output = controller_compute(
-                    setpoint_filter.setpoint,
-                    medidasADC.valor_real[Tensao_DC],
-                    medidasADC.valor_real[Corrente_carga]
-                );
+        waveform_send_block();
 
-                if (controller_output > 0.975f)
-                    controller_output = 0.975f;
-                if (controller_output < 0.025f)
-                    controller_output = 0.025f;
+        xSemaphoreGive(communication_semaphore);
+    }
 
-                EPWM1_Modulante_CMPA = controller_output * pwm_factor;
-                duty_cycle = controller_output;
-            }
-        }
+    return;
+}
+
+/**
+ * @brief Send the next frames of a profile dump (profile.h)
+ *        PROFILE frames of every slot, then TASK_STATS frames of every
+ *        task from one uxTaskGetSystemState snapshot. Only whole frames
+ *        that fit in the UART ring are started, so a dump at a low rate is
+ *        spread over several uart_link_task loops. Callers hold
+ *        communication_semaphore.
+ */
+static void profile_dump(void) {
+    static uint16_t index = 0, task_count = 0;
+    static uint32_t total_run_time = 0;
+    TaskStatus_t *task;
+
+    if (index == 0)
+        task_count = uxTaskGetSystemState(task_status, MAX_TASKS, &total_run_time);
+
+    while ((index < PROFILE_SLOTS + task_count) && (uart_tx_free() >= TELEMETRY_MAX_FRAME)) {
+        if (index < PROFILE_SLOTS)
+            profile_send_slot(index);
         else {
-            if (reset_flag) {
-                controller_reset();
-                reset_flag = 0;
-            }
+            task = &task_status[index - PROFILE_SLOTS];
+            profile_send_task(task->xTaskNumber, task->pcTaskName, task->eCurrentState, task->uxBasePriority,
+                              task->ulRunTimeCounter, total_run_time, task->usStackHighWaterMark);
+        }
 
-            duty_cycle = 0.0f;
+        index++;
+    }
+
+    if (index >= PROFILE_SLOTS + task_count) {
+        index = 0;
+        profile_dump_request = 0;
+    }
+
+    return;
+}
+
+/**
+ * @brief UART link task - negotiates the SCI-C rate with the monitor
+ *        Keeps communication_semaphore while uart_link_service changes the
+ *        rate, so no frame is split across two rates. Also sends the
+ *        profile dumps the monitor asks for.
+ */
+void uart_link_task(void) {
+    static uint16_t reserved = 0;
+
+    if (!reserved)
+        xSemaphoreTake(communication_semaphore, portMAX_DELAY);
+
+    reserved = uart_link_service();
+
+    if (!reserved && profile_dump_request)
+        profile_dump();
+
+    if (!reserved)
+        xSemaphoreGive(communication_semaphore);
+
+    return;
+}
+
+/**
+ * @brief Periodic task - releases the entry function of its table entry
+ *        every period ms with xTaskDelayUntil, so the period does not drift
+ *        with the execution time. A release already past when the previous
+ *        run ends is counted in overruns and the schedule restarts from
+ *        there, instead of running the missed releases back to back.
+ *        With PERIODIC_RELEASE_NOTIFY the entry runs on each task
+ *        notification instead; notifications given while it was still
+ *        running are counted in overruns and run once.
+ *        The achieved rate is refreshed every PERIODIC_RATE_WINDOW ms.
+ * @param pvParameters PeriodicTask entry
+ */
+static void periodic_task(void *pvParameters) {
+    PeriodicTask *task = (PeriodicTask *)pvParameters;
+    TickType_t last_wake, window_start;
+    uint32_t window_runs = 0, released;
+
+    vTaskDelay(task->startup / portTICK_PERIOD_MS);
+
+    last_wake = xTaskGetTickCount();
+    window_start = last_wake;
+
+    while (1) {
+        if (task->release == PERIODIC_RELEASE_NOTIFY) {
+            // portMAX_DELAY is finite without INCLUDE_vTaskSuspend
+            released = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (released == 0)
+                continue;
+
+            task->overruns += released - 1;
+            last_wake = xTaskGetTickCount();
+        }
+        else if (xTaskDelayUntil(&last_wake, task->period / portTICK_PERIOD_MS) == pdFALSE) {
+            task->overruns++;
+            last_wake = xTaskGetTickCount();
         }
 
-        vTaskDelay(TASK2_END_DELAY / portTICK_PERIOD_MS);
+        ServiceDog();
+
+        profile_begin(task->profile);
+        task->entry();
+        profile_end(task->profile);
+
+        task->runs++;
+
+        if ((last_wake - window_start) >= (PERIODIC_RATE_WINDOW / portTICK_PERIOD_MS)) {
+            task->rate = (float)(task->runs - window_runs) * 1000.0f /
+                         (float)((last_wake - window_start) * portTICK_PERIOD_MS);
+
+            window_start = last_wake;
+            window_runs = task->runs;
+        }
     }
 }
 
@@ -189,41 +490,37 @@ void freeRTOS_Setup(void) {
     static StaticSemaphore_t semaphore_buffer;
     static uint8_t queue_storage[1 * sizeof(float)];
     static StaticQueue_t static_queue;
+    PeriodicTask *task;
+    TaskHandle_t handle;
+    uint16_t x;
 
     communication_semaphore = xSemaphoreCreateMutexStatic(&semaphore_buffer);
     xSemaphoreGive(communication_semaphore);
 
     control_queue = xQueueCreateStatic(1, sizeof(float), queue_storage, &static_queue);
 
-    xTaskCreateStatic(
-        update_time_task,
-        "UpdateTimeTask",
-        STACK_SIZE, 
-        (void *)NULL,
-        tskIDLE_PRIORITY + 1,
-        update_time_task_stack,
-        &update_time_task_buffer
-    );
-
-    xTaskCreateStatic(
-        communication_task,
-        "CommTask",
-        STACK_SIZE, 
-        (void *)NULL,
-        tskIDLE_PRIORITY + 1,
-        communication_task_stack,
-        &communication_task_buffer
-    );
-
-    xTaskCreateStatic(
-        control_task,
-        "ControlTask",
-        STACK_SIZE, 
-        (void *)NULL,
-        tskIDLE_PRIORITY + 4,
-        control_task_stack,
-        &control_task_buffer
-    );
+    for (x = 0; x < periodic_task_count; x++) {
+        task = &periodic_tasks[x];
+
+        profile_init(task->profile, task->period * 1000UL, task->profile_shift, 15);
+
+        handle = xTaskCreateStatic(
+            periodic_task,
+            task->name,
+            STACK_SIZE,
+            (void *)task,
+            task->priority,
+            task->stack,
+            task->buffer
+        );
+
+        if (task->handle != NULL)
+            *task->handle = handle;
+    }
+
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+    measurement_snapshot.notify = control_notify;
+#endif
 
     vTaskStartScheduler();
 }
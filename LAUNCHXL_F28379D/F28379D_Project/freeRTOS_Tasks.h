@@ -11,6 +11,12 @@
     #include "peripheral_Setup.h"
 
     #include "controllers.h"
+    #include "nn_snapshot.h"
+    #include "telemetry.h"
+    #include "waveform.h"
+    #include "uart_link.h"
+    #include "timebase.h"
+    #include "profile.h"
 
     #include "Libraries/freeRTOS/FreeRTOS.h"
     #include "Libraries/freeRTOS/task.h"
@@ -24,28 +30,74 @@
 
     // Task configuration
     #define STACK_SIZE          256
+    #define MAX_TASKS           8       // Tasks in a profile dump, idle included
 
     // Task timing (milliseconds)
     #define TASK1_STARTUP_DELAY 10
-    #define TASK1_LOOP_DELAY    4000
-    #define TASK1_END_DELAY     1
+    #define TASK1_PERIOD        4000
 
     #define TASK2_STARTUP_DELAY 10
-    #define TASK2_LOOP_DELAY    1
-    #define TASK2_END_DELAY     1
+    #define TASK2_PERIOD        1
+
+    #define CONTROL_RATE_WINDOW 1000
+
+    // With CONTROL_LOOP_TASK, adcc1_isr releases control_task right after
+    // publishing a conversion, every CONTROL_NOTIFY_DECIMATION conversions
+    #define CONTROL_NOTIFY_DECIMATION   ((TASK2_PERIOD * 1000UL) / ADC_SAMPLE_PERIOD)
+
+    #if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+        #define CONTROL_RELEASE         PERIODIC_RELEASE_NOTIFY
+    #else
+        #define CONTROL_RELEASE         PERIODIC_RELEASE_TIMER
+    #endif
 
     #define TASK3_STARTUP_DELAY 10
-    #define TASK3_LOOP_DELAY    1
-    #define TASK3_END_DELAY     1
+    #define TASK3_PERIOD        1
+    #define RTC_READ_TIMEOUT    5       // ms, burst read takes ~0.15 ms at 400 kHz
+
+    #define PERIODIC_RATE_WINDOW 1000   // Achieved rate of the periodic tasks
+
+    // Periodic task release
+    //  PERIODIC_RELEASE_TIMER:  xTaskDelayUntil, every period
+    //  PERIODIC_RELEASE_NOTIFY: task notification from an ISR, nominally every period
+    #define PERIODIC_RELEASE_TIMER  0
+    #define PERIODIC_RELEASE_NOTIFY 1
+
+    /**
+     * @brief Periodic task table entry
+     *        periodic_task calls entry once per period; the statistics are
+     *        written by the task only
+     */
+    typedef struct {
+        void (*entry)(void);
+        const char *name;
+        uint16_t period;                    // ms
+        uint16_t startup;                   // ms before the first release
+        uint16_t release;                   // PERIODIC_RELEASE_x
+        UBaseType_t priority;
+        uint16_t profile;                   // PROFILE_x slot
+        uint16_t profile_shift;             // Execution time histogram resolution (profile.h)
+        StackType_t *stack;                 // STACK_SIZE words
+        StaticTask_t *buffer;
+        TaskHandle_t *handle;               // Where to store the handle, or NULL
+        uint32_t runs;
+        uint32_t overruns;                  // Releases missed, the run before ended too late
+        float rate;                         // Achieved rate (Hz) over PERIODIC_RATE_WINDOW
+    } PeriodicTask;
 
     // Global variables
     extern SemaphoreHandle_t communication_semaphore;
     extern QueueHandle_t control_queue;
+    extern PeriodicTask periodic_tasks[];
+    extern const uint16_t periodic_task_count;
 
-    // Function prototypes
-    void update_time_task(void *pvParameters);
-    void communication_task(void *pvParameters);
-    void control_task(void *pvParameters);
+    // Task bodies, run once per period by periodic_task
+    void update_time_task(void);
+    void communication_task(void);
+    void control_task(void);
+    void nn_training_task(void);
+    void waveform_task(void);
+    void uart_link_task(void);
     void freeRTOS_Setup(void);
 
 #endif /* FREERTOS_TASKS_H_ */
@@ -6,7 +6,8 @@
  * - PI Controller (traditional control approach)
  * - Neural Network Approximator (NNA) with real-time training
  * 
- * The controller type is selected using the CONTROLLER define below.
+ * The controller started at boot is selected using the CONTROLLER define
+ * below; controller_select() switches controllers at runtime.
  * 
  * @author Gabriel Del Monte
  * @date 2025
@@ -17,7 +18,7 @@
 #include "controllers.h"
 
 /**
- * @brief Controller selection define
+ * @brief Initial controller selection define
  *        Set to 0 for PI Controller
  *        Set to 1 for Neural Network Approximator (NNA)
  */
@@ -0,0 +1,99 @@
+/**
+ * @file measurement_stats.c
+ * @brief Implementation of the streaming statistics of the MEDIDA channels
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "measurement_stats.h"
+#include "adc_channels.h"
+
+#include <math.h>
+
+// Derivative per code of difference between the half sums: the half means
+// are MEASUREMENT_STATS_HALF samples apart
+#define MEASUREMENT_STATS_DERIVATIVE_SCALE  (1.0f / ((float)MEASUREMENT_STATS_HALF * MEASUREMENT_STATS_HALF * (ADC_SAMPLE_PERIOD * 1e-6f)))
+
+MeasurementStats measurement_stats;
+
+/**
+ * @brief Clear the statistics
+ *        The window starts filled with zero codes; results are valid once
+ *        a whole window has been sampled
+ * @return void
+ */
+void measurement_stats_init(void) {
+    uint16_t x, n;
+
+    for (x = 0; x < MEASUREMENT_STATS_CHANNELS; x++) {
+        measurement_stats.channel[x].sums.sum = 0;
+        measurement_stats.channel[x].sums.squares = 0;
+        measurement_stats.channel[x].sums.half_sum = 0;
+        measurement_stats.channel[x].sums.ripple_min = 0;
+        measurement_stats.channel[x].sums.ripple_max = 0;
+        measurement_stats.channel[x].min = UINT16_MAX;
+        measurement_stats.channel[x].max = 0;
+
+        for (n = 0; n < MEASUREMENT_STATS_WINDOW; n++)
+            measurement_stats.channel[x].samples[n] = 0;
+    }
+
+    measurement_stats.index = 0;
+    measurement_stats.windows = 0;
+    measurement_stats.retries = 0;
+
+    return;
+}
+
+/**
+ * @brief Statistics of one channel over the last window
+ *        Copies the sums of one update, retrying while adcc1_isr updates,
+ *        and scales them with the gain, offset and coupling of the channel
+ *        table (adc_channels.h). Meant for the tasks: one square root,
+ *        the rest are multiplications by constants
+ * @param channel Tensao_DC or Corrente_carga
+ * @param result Destination
+ * @return void
+ */
+void measurement_stats_read(uint16_t channel, MeasurementStatsResult *result) {
+    MeasurementStatsSums sums;
+    uint32_t windows;
+    uint16_t sequence;
+    int16_t offset = adc_channel_offset[channel];
+    float gain = adc_channel_gain[channel];
+    int64_t squares;
+
+    while (1) {
+        sequence = measurement_stats.sequence;
+        sums = measurement_stats.channel[channel].sums;
+        windows = measurement_stats.windows;
+
+        if (!(sequence & 1) && (sequence == measurement_stats.sequence))
+            break;
+
+        measurement_stats.retries++;
+    }
+
+    result->mean = gain * (sums.sum * (1.0f / MEASUREMENT_STATS_WINDOW) - offset);
+
+    // Window^2 times the mean square, exact in 64 bits: about the mean for
+    // AC coupled channels, about the offset otherwise
+    if (adc_channel_coupling[channel] == AC)
+        squares = (int64_t)MEASUREMENT_STATS_WINDOW * sums.squares - (int64_t)sums.sum * sums.sum;
+    else
+        squares = (int64_t)MEASUREMENT_STATS_WINDOW * ((int64_t)sums.squares - 2 * (int64_t)offset * sums.sum
+                                                       + (int64_t)MEASUREMENT_STATS_WINDOW * offset * offset);
+
+    result->rms = gain * sqrtf((float)squares * (1.0f / ((float)MEASUREMENT_STATS_WINDOW * MEASUREMENT_STATS_WINDOW)));
+
+    result->min = gain * ((int32_t)sums.ripple_min - offset);
+    result->max = gain * ((int32_t)sums.ripple_max - offset);
+    result->ripple = gain * ((int32_t)sums.ripple_max - sums.ripple_min);
+
+    // Newest half minus oldest half
+    result->derivative = gain * (2 * sums.half_sum - sums.sum) * MEASUREMENT_STATS_DERIVATIVE_SCALE;
+
+    result->valid = (windows > 0);
+
+    return;
+}
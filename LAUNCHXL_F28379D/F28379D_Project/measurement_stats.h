@@ -0,0 +1,140 @@
+/**
+ * @file measurement_stats.h
+ * @brief Streaming statistics of the MEDIDA channels
+ *        adcc1_isr feeds the codes of every sample; running sums over the
+ *        last MEASUREMENT_STATS_WINDOW samples are kept exact in integers
+ *        with a fixed cost per sample (add the new sample, subtract the one
+ *        leaving the window) and no division. Mean, RMS, peak-to-peak
+ *        ripple and derivative are scaled to real values only when read
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef MEASUREMENT_STATS_H
+#define MEASUREMENT_STATS_H
+
+    #include "peripheral_Setup.h"
+
+    #include <stdint.h>
+
+    // Samples per window: 1 << MEASUREMENT_STATS_SHIFT, 2 to 8 (64 samples, 3.2 ms at 20 kHz)
+    #define MEASUREMENT_STATS_SHIFT     6
+    #define MEASUREMENT_STATS_WINDOW    (1 << MEASUREMENT_STATS_SHIFT)
+    #define MEASUREMENT_STATS_HALF      (MEASUREMENT_STATS_WINDOW / 2)
+    #define MEASUREMENT_STATS_MASK      (MEASUREMENT_STATS_WINDOW - 1)
+
+    // Statistics of Tensao_DC and Corrente_carga
+    #define MEASUREMENT_STATS_CHANNELS  SENSOR_BUF_SIZE
+
+    // 12-bit squares summed over 256 samples still fit in 32 bits
+    #if (MEASUREMENT_STATS_SHIFT < 2) || (MEASUREMENT_STATS_SHIFT > 8)
+        #error "MEASUREMENT_STATS_SHIFT must be 2 to 8"
+    #endif
+
+    /**
+     * @brief Window sums of one channel, in codes
+     *        half_sum is over the newest half of the window. ripple_min and
+     *        ripple_max are over the last completed window, as the extremes
+     *        of a sliding window have no fixed-cost update
+     */
+    typedef struct {
+        int32_t sum;
+        uint32_t squares;
+        int32_t half_sum;
+        uint16_t ripple_min;
+        uint16_t ripple_max;
+    } MeasurementStatsSums;
+
+    /**
+     * @brief One channel: sums and the samples still in the window
+     */
+    typedef struct {
+        volatile MeasurementStatsSums sums;
+        uint16_t min;                   // Of the window being completed
+        uint16_t max;
+        uint16_t samples[MEASUREMENT_STATS_WINDOW];
+    } MeasurementStatsChannel;
+
+    /**
+     * @brief Statistics state, written by adcc1_isr
+     *        Sequence lock as measurement_snapshot: odd while the ISR
+     *        updates, readers retry (measurement_stats_read)
+     */
+    typedef struct {
+        volatile uint16_t sequence;
+        MeasurementStatsChannel channel[MEASUREMENT_STATS_CHANNELS];
+        uint16_t index;                 // Oldest sample, next to be replaced
+        volatile uint32_t windows;      // Completed windows
+        uint32_t retries;               // Reads that overlapped an update
+    } MeasurementStats;
+
+    /**
+     * @brief Statistics of one channel, in real values
+     */
+    typedef struct {
+        float mean;
+        float rms;                      // Of the AC component for AC coupled channels
+        float min;                      // Over the last completed window
+        float max;
+        float ripple;                   // Peak to peak, max - min
+        float derivative;               // Per second, from the means of the two window halves
+        uint16_t valid;                 // A whole window has been sampled
+    } MeasurementStatsResult;
+
+    extern MeasurementStats measurement_stats;
+
+    /**
+     * @brief Add the codes of this sample to the statistics
+     *        Called by adcc1_isr once adc_channels_sample has updated MEDIDA.
+     *        Per channel: one ring slot, three running sums and the window
+     *        extremes. The extremes are latched for ripple when the ring
+     *        wraps, every MEASUREMENT_STATS_WINDOW samples
+     * @param medidas Measurements of this sample
+     * @return void
+     */
+    static inline void measurement_stats_update(const MEDIDA *medidas) {
+        MeasurementStatsChannel *channel;
+        uint16_t index = measurement_stats.index;
+        uint16_t middle = (index + MEASUREMENT_STATS_HALF) & MEASUREMENT_STATS_MASK;
+        uint16_t code, oldest;
+        int x;
+
+        measurement_stats.sequence++;
+
+        for (x = 0; x < MEASUREMENT_STATS_CHANNELS; x++) {
+            channel = &measurement_stats.channel[x];
+            code = medidas->leituras_dig[x];
+            oldest = channel->samples[index];
+
+            channel->sums.sum += (int32_t)code - oldest;
+            channel->sums.squares += (uint32_t)code * code - (uint32_t)oldest * oldest;
+            channel->sums.half_sum += (int32_t)code - channel->samples[middle];
+            channel->samples[index] = code;
+
+            if (code < channel->min)
+                channel->min = code;
+            if (code > channel->max)
+                channel->max = code;
+
+            if (index == MEASUREMENT_STATS_MASK) {
+                channel->sums.ripple_min = channel->min;
+                channel->sums.ripple_max = channel->max;
+                channel->min = UINT16_MAX;
+                channel->max = 0;
+            }
+        }
+
+        measurement_stats.index = (index + 1) & MEASUREMENT_STATS_MASK;
+        if (index == MEASUREMENT_STATS_MASK)
+            measurement_stats.windows++;
+
+        measurement_stats.sequence++;
+
+        return;
+    }
+
+    // Function prototypes
+    void measurement_stats_init(void);
+    void measurement_stats_read(uint16_t channel, MeasurementStatsResult *result);
+
+#endif /* MEASUREMENT_STATS_H */
@@ -0,0 +1,208 @@
+/**
+ * @file nn_ipc.c
+ * @brief Implementation of the CPU1/CPU2 Neural Network training link
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "nn_ipc.h"
+#include "nn_kernels.h"
+
+// Message RAMs, at the same address in both images (NN_IPC_CPU1TOCPU2 and
+// NN_IPC_CPU2TOCPU1 in the linker command files), never initialized
+#pragma DATA_SECTION(nn_ipc_command, "NNIpcCpu1ToCpu2");
+volatile NNIpcCommand nn_ipc_command;
+
+#pragma DATA_SECTION(nn_ipc_status, "NNIpcCpu2ToCpu1");
+volatile NNIpcStatus nn_ipc_status;
+
+NNIpcStats nn_ipc_stats = {0};
+
+// CPU1
+
+/**
+ * @brief Clear the command, post the initial weights and release CPU2
+ *        Called once from controller_init, before the control path runs
+ * @param network Weights CPU2 starts training from
+ * @return void
+ */
+void nn_ipc_init(const NeuralNetwork *network) {
+    nn_ipc_command.head = 0;
+    nn_ipc_command.load_sequence = 0;
+    nn_ipc_command.bias_sequence = 0;
+    nn_ipc_command.bias_offset = 0.0f;
+
+    nn_ipc_load(network);
+
+    IpcRegs.IPCSET.all = NN_IPC_FLAG;
+
+    return;
+}
+
+/**
+ * @brief Whether CPU2 is still to start or to acknowledge the last load
+ *        or bias shift
+ * @return 1 if no load or bias shift can be posted
+ */
+uint16_t nn_ipc_busy(void) {
+    if (IpcRegs.IPCFLG.all & NN_IPC_FLAG)
+        return 1;
+
+    return (nn_ipc_status.load_ack != nn_ipc_command.load_sequence) ||
+           (nn_ipc_status.bias_ack != nn_ipc_command.bias_sequence);
+}
+
+/**
+ * @brief Post the weights CPU2 restarts from, dropping the queued samples
+ *        Only while not nn_ipc_busy, except from nn_ipc_init
+ * @param network Weights to load
+ * @return void
+ */
+void nn_ipc_load(const NeuralNetwork *network) {
+    int x;
+
+    for (x = 0; x < NN_WEIGHT_COUNT; x++)
+        nn_ipc_command.load.weights[x] = network->weights[x];
+
+    nn_ipc_command.load_sequence++;
+
+    return;
+}
+
+/**
+ * @brief Post an output bias shift, only while not nn_ipc_busy
+ * @param offset Shift applied by neural_network_transfer
+ * @return void
+ */
+void nn_ipc_bias(float offset) {
+    nn_ipc_command.bias_offset = offset;
+    nn_ipc_command.bias_sequence++;
+
+    return;
+}
+
+/**
+ * @brief Copy the weights CPU2 posted last
+ *        Skipped when they are not newer than the last copy, or do not yet
+ *        include the last load and bias shift posted
+ * @param network Storage for the weights
+ * @return 1 if network was updated
+ */
+uint16_t nn_ipc_fetch(NeuralNetwork *network) {
+    NeuralNetwork copy;
+    uint32_t generation;
+    uint16_t current;
+    int x;
+
+    if (IpcRegs.IPCFLG.all & NN_IPC_FLAG)
+        return 0;
+
+    generation = nn_ipc_status.generation;
+    if ((generation & 1) || (generation == nn_ipc_stats.generation))
+        return 0;
+
+    current = (nn_ipc_status.load_ack == nn_ipc_command.load_sequence) &&
+              (nn_ipc_status.bias_ack == nn_ipc_command.bias_sequence);
+
+    for (x = 0; x < NN_WEIGHT_COUNT; x++)
+        copy.weights[x] = nn_ipc_status.weights.weights[x];
+
+    if (nn_ipc_status.generation != generation) {
+        nn_ipc_stats.retries++;
+        return 0;
+    }
+
+    if (!current)
+        return 0;
+
+    *network = copy;
+    nn_ipc_stats.generation = generation;
+    nn_ipc_stats.updates++;
+
+    return 1;
+}
+
+// CPU2
+
+/**
+ * @brief Clear the status, once NN_IPC_FLAG is set and before it is
+ *        acknowledged (F28379D_CPU2 main)
+ * @return void
+ */
+void nn_ipc_cpu2_init(void) {
+    int x;
+
+    for (x = 0; x < NN_WEIGHT_COUNT; x++)
+        nn_ipc_status.weights.weights[x] = 0.0f;
+
+    nn_ipc_status.generation = 0;
+    nn_ipc_status.trained = 0;
+    nn_ipc_status.tail = nn_ipc_command.head;
+    nn_ipc_status.load_ack = 0;
+    nn_ipc_status.bias_ack = 0;
+
+    return;
+}
+
+/**
+ * @brief Apply the posted load and bias shift, train on the queued
+ *        samples and post the weights
+ *        The gradient is taken with the weights being trained, as
+ *        neural_network_training_service does on CPU1, with the unrolled
+ *        kernels of nn_kernels.h
+ * @param network Weights trained by CPU2
+ * @return Number of samples trained
+ */
+uint16_t nn_ipc_train(NeuralNetwork *network) {
+    NeuralNetworkActivations activations;
+    volatile NNTrainingSample *slot;
+    uint16_t head = nn_ipc_command.head;
+    uint16_t load = nn_ipc_command.load_sequence;
+    uint16_t bias = nn_ipc_command.bias_sequence;
+    uint16_t tail = nn_ipc_status.tail;
+    uint16_t trained = 0, changed = 0;
+    int x;
+
+    if (load != nn_ipc_status.load_ack) {
+        for (x = 0; x < NN_WEIGHT_COUNT; x++)
+            network->weights[x] = nn_ipc_command.load.weights[x];
+
+        // Samples queued for the previous weights
+        tail = head;
+        nn_ipc_status.tail = tail;
+        changed = 1;
+    }
+
+    if (bias != nn_ipc_status.bias_ack) {
+        network->weights[NN_OUT_BIAS] += nn_ipc_command.bias_offset;
+        changed = 1;
+    }
+
+    while (tail != head) {
+        slot = &nn_ipc_command.samples[tail & (NN_IPC_RING_SIZE - 1)];
+        for (x = 0; x < INPUT_SIZE; x++)
+            activations.inputs[x] = slot->inputs[x];
+
+        activations.output = nn_forward_unrolled(network->weights, activations.inputs,
+                                                 activations.h1, activations.h2);
+        nn_train_unrolled(network->weights, activations.inputs, activations.h1,
+                          activations.h2, activations.output, slot->error);
+
+        nn_ipc_status.tail = ++tail;
+        trained++;
+    }
+
+    if (trained || changed) {
+        nn_ipc_status.generation++;
+
+        for (x = 0; x < NN_WEIGHT_COUNT; x++)
+            nn_ipc_status.weights.weights[x] = network->weights[x];
+        nn_ipc_status.trained += trained;
+        nn_ipc_status.load_ack = load;
+        nn_ipc_status.bias_ack = bias;
+
+        nn_ipc_status.generation++;
+    }
+
+    return trained;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file nn_ipc.h
+ * @brief Neural Network training on CPU2 (NN_TRAINING_CPU2)
+ *        CPU1 queues the training samples of the control path in the
+ *        CPU1 to CPU2 message RAM, CPU2 (F28379D_CPU2) trains its own copy
+ *        and posts the weights back in the CPU2 to CPU1 message RAM with a
+ *        generation counter. Built by both images and by the host
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef NN_IPC_H
+#define NN_IPC_H
+
+    #include "controllers.h"
+
+    #define NN_IPC_RING_SIZE        32          // Must be a power of two
+    #define NN_IPC_FLAG             (1UL << 4)  // IPC flag 4: set by CPU1 once the command is valid, acknowledged by CPU2
+
+    /**
+     * @brief CPU1 to CPU2 message RAM, written by CPU1 only
+     *        samples is a single-producer/single-consumer ring: CPU1 owns
+     *        head, CPU2 owns tail (NNIpcStatus). A load or a bias shift is
+     *        posted by incrementing its sequence, and only once CPU2 has
+     *        acknowledged the previous one (nn_ipc_busy)
+     */
+    typedef struct {
+        NNTrainingSample samples[NN_IPC_RING_SIZE];
+        NeuralNetwork load;         // Weights to restart from (boot and reset)
+        float bias_offset;          // Output bias shift of a controller switch
+        uint16_t head;
+        uint16_t load_sequence;
+        uint16_t bias_sequence;
+    } NNIpcCommand;
+
+    /**
+     * @brief CPU2 to CPU1 message RAM, written by CPU2 only
+     *        generation is odd while weights and the acknowledgements are
+     *        written, CPU1 retries a copy that saw it change
+     */
+    typedef struct {
+        NeuralNetwork weights;      // Trained weights
+        volatile uint32_t generation;
+        uint32_t trained;           // Samples trained since CPU2 started
+        uint16_t tail;
+        uint16_t load_ack;          // load_sequence the weights include
+        uint16_t bias_ack;          // bias_sequence the weights include
+    } NNIpcStatus;
+
+    /**
+     * @brief CPU1 side of the link
+     */
+    typedef struct {
+        uint32_t dropped;           // Samples lost with the ring full
+        uint32_t generation;        // Last generation taken
+        uint32_t updates;           // Weight sets taken
+        uint32_t retries;           // Copies torn by a CPU2 publication
+    } NNIpcStats;
+
+    extern volatile NNIpcCommand nn_ipc_command;
+    extern volatile NNIpcStatus nn_ipc_status;
+    extern NNIpcStats nn_ipc_stats;
+
+    /**
+     * @brief Queue a training sample for CPU2, from the control path
+     *        Drops the sample when the ring is full
+     * @param inputs The input values
+     * @param error The error value
+     * @return void
+     */
+    static inline void nn_ipc_push(float inputs[INPUT_SIZE], float error) {
+        volatile NNTrainingSample *slot;
+        uint16_t head = nn_ipc_command.head;
+        int x;
+
+        if ((uint16_t)(head - nn_ipc_status.tail) >= NN_IPC_RING_SIZE) {
+            nn_ipc_stats.dropped++;
+            return;
+        }
+
+        slot = &nn_ipc_command.samples[head & (NN_IPC_RING_SIZE - 1)];
+        for (x = 0; x < INPUT_SIZE; x++)
+            slot->inputs[x] = inputs[x];
+        slot->error = error;
+
+        nn_ipc_command.head = head + 1;
+
+        return;
+    }
+
+    // CPU1 functions
+    void nn_ipc_init(const NeuralNetwork *network);
+    uint16_t nn_ipc_busy(void);
+    void nn_ipc_load(const NeuralNetwork *network);
+    void nn_ipc_bias(float offset);
+    uint16_t nn_ipc_fetch(NeuralNetwork *network);
+
+    // CPU2 functions
+    void nn_ipc_cpu2_init(void);
+    uint16_t nn_ipc_train(NeuralNetwork *network);
+
+#endif /* NN_IPC_H */
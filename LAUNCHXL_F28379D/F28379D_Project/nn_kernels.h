@@ -0,0 +1,863 @@
+/**
+ * @file nn_kernels.h
+ * @brief Fully unrolled Neural Network kernels
+ *        Generated by tools/nn_codegen.py, do not edit
+ *        Topologies: 3-3-2-1, 3-6-4-1, 3-12-8-1
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef NN_KERNELS_H
+#define NN_KERNELS_H
+
+    #include "controllers.h"
+
+    /**
+     * @brief Forward pass, 3-3-2-1 topology
+     * @param w Flat weight array
+     * @param in The input values
+     * @param h1 Hidden layer 1 activations (output)
+     * @param h2 Hidden layer 2 activations (output)
+     * @return float The output layer pre-activation
+     */
+    static inline float nn_forward_3_3_2(const float *w, const float *in, float *h1, float *h2) {
+        float output;
+
+        // Hidden layer 1
+        h1[0] = w[0];
+        h1[0] += in[0] * w[1];
+        h1[0] += in[1] * w[2];
+        h1[0] += in[2] * w[3];
+        h1[0] = (h1[0] > 0.0f) ? h1[0] : 0.0f;
+        h1[1] = w[4];
+        h1[1] += in[0] * w[5];
+        h1[1] += in[1] * w[6];
+        h1[1] += in[2] * w[7];
+        h1[1] = (h1[1] > 0.0f) ? h1[1] : 0.0f;
+        h1[2] = w[8];
+        h1[2] += in[0] * w[9];
+        h1[2] += in[1] * w[10];
+        h1[2] += in[2] * w[11];
+        h1[2] = (h1[2] > 0.0f) ? h1[2] : 0.0f;
+
+        // Hidden layer 2
+        h2[0] = w[12];
+        h2[0] += h1[0] * w[13];
+        h2[0] += h1[1] * w[14];
+        h2[0] += h1[2] * w[15];
+        h2[0] = (h2[0] > 0.0f) ? h2[0] : 0.0f;
+        h2[1] = w[16];
+        h2[1] += h1[0] * w[17];
+        h2[1] += h1[1] * w[18];
+        h2[1] += h1[2] * w[19];
+        h2[1] = (h2[1] > 0.0f) ? h2[1] : 0.0f;
+
+        // Output layer
+        output = w[20];
+        output += h2[0] * w[21];
+        output += h2[1] * w[22];
+
+        return output;
+    }
+
+    /**
+     * @brief Gradient step, 3-3-2-1 topology
+     * @param w Flat weight array
+     * @param in The input values of the forward pass
+     * @param h1 Hidden layer 1 activations of the forward pass
+     * @param h2 Hidden layer 2 activations of the forward pass
+     * @param output The output layer pre-activation
+     * @param error The error value
+     * @return void
+     */
+    static inline void nn_train_3_3_2(float *w, const float *in, const float *h1, const float *h2, float output, float error) {
+        float delta_h2[2];
+        float delta_h1, delta_output, sum;
+
+        delta_output = error * (((output > 0.0f) ? output : 0.0f) > 0.0f ? 1.0f : 0.0f);
+
+        // Update output layer
+        w[21] += ETA * delta_output * h2[0];
+        w[22] += ETA * delta_output * h2[1];
+        w[20] += ETA * delta_output;
+
+        // Update hidden layer 2
+        delta_h2[0] = delta_output * w[21] * (h2[0] > 0.0f ? 1.0f : 0.0f);
+        w[13] += ETA * delta_h2[0] * h1[0];
+        w[14] += ETA * delta_h2[0] * h1[1];
+        w[15] += ETA * delta_h2[0] * h1[2];
+        w[12] += ETA * delta_h2[0];
+        delta_h2[1] = delta_output * w[22] * (h2[1] > 0.0f ? 1.0f : 0.0f);
+        w[17] += ETA * delta_h2[1] * h1[0];
+        w[18] += ETA * delta_h2[1] * h1[1];
+        w[19] += ETA * delta_h2[1] * h1[2];
+        w[16] += ETA * delta_h2[1];
+
+        // Update hidden layer 1
+        sum = 0.0f;
+        sum += delta_h2[0] * w[13];
+        sum += delta_h2[1] * w[17];
+        delta_h1 = sum * (h1[0] > 0.0f ? 1.0f : 0.0f);
+        w[1] += ETA * delta_h1 * in[0];
+        w[2] += ETA * delta_h1 * in[1];
+        w[3] += ETA * delta_h1 * in[2];
+        w[0] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[14];
+        sum += delta_h2[1] * w[18];
+        delta_h1 = sum * (h1[1] > 0.0f ? 1.0f : 0.0f);
+        w[5] += ETA * delta_h1 * in[0];
+        w[6] += ETA * delta_h1 * in[1];
+        w[7] += ETA * delta_h1 * in[2];
+        w[4] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[15];
+        sum += delta_h2[1] * w[19];
+        delta_h1 = sum * (h1[2] > 0.0f ? 1.0f : 0.0f);
+        w[9] += ETA * delta_h1 * in[0];
+        w[10] += ETA * delta_h1 * in[1];
+        w[11] += ETA * delta_h1 * in[2];
+        w[8] += ETA * delta_h1;
+
+        return;
+    }
+
+    /**
+     * @brief Forward pass, 3-6-4-1 topology
+     * @param w Flat weight array
+     * @param in The input values
+     * @param h1 Hidden layer 1 activations (output)
+     * @param h2 Hidden layer 2 activations (output)
+     * @return float The output layer pre-activation
+     */
+    static inline float nn_forward_3_6_4(const float *w, const float *in, float *h1, float *h2) {
+        float output;
+
+        // Hidden layer 1
+        h1[0] = w[0];
+        h1[0] += in[0] * w[1];
+        h1[0] += in[1] * w[2];
+        h1[0] += in[2] * w[3];
+        h1[0] = (h1[0] > 0.0f) ? h1[0] : 0.0f;
+        h1[1] = w[4];
+        h1[1] += in[0] * w[5];
+        h1[1] += in[1] * w[6];
+        h1[1] += in[2] * w[7];
+        h1[1] = (h1[1] > 0.0f) ? h1[1] : 0.0f;
+        h1[2] = w[8];
+        h1[2] += in[0] * w[9];
+        h1[2] += in[1] * w[10];
+        h1[2] += in[2] * w[11];
+        h1[2] = (h1[2] > 0.0f) ? h1[2] : 0.0f;
+        h1[3] = w[12];
+        h1[3] += in[0] * w[13];
+        h1[3] += in[1] * w[14];
+        h1[3] += in[2] * w[15];
+        h1[3] = (h1[3] > 0.0f) ? h1[3] : 0.0f;
+        h1[4] = w[16];
+        h1[4] += in[0] * w[17];
+        h1[4] += in[1] * w[18];
+        h1[4] += in[2] * w[19];
+        h1[4] = (h1[4] > 0.0f) ? h1[4] : 0.0f;
+        h1[5] = w[20];
+        h1[5] += in[0] * w[21];
+        h1[5] += in[1] * w[22];
+        h1[5] += in[2] * w[23];
+        h1[5] = (h1[5] > 0.0f) ? h1[5] : 0.0f;
+
+        // Hidden layer 2
+        h2[0] = w[24];
+        h2[0] += h1[0] * w[25];
+        h2[0] += h1[1] * w[26];
+        h2[0] += h1[2] * w[27];
+        h2[0] += h1[3] * w[28];
+        h2[0] += h1[4] * w[29];
+        h2[0] += h1[5] * w[30];
+        h2[0] = (h2[0] > 0.0f) ? h2[0] : 0.0f;
+        h2[1] = w[31];
+        h2[1] += h1[0] * w[32];
+        h2[1] += h1[1] * w[33];
+        h2[1] += h1[2] * w[34];
+        h2[1] += h1[3] * w[35];
+        h2[1] += h1[4] * w[36];
+        h2[1] += h1[5] * w[37];
+        h2[1] = (h2[1] > 0.0f) ? h2[1] : 0.0f;
+        h2[2] = w[38];
+        h2[2] += h1[0] * w[39];
+        h2[2] += h1[1] * w[40];
+        h2[2] += h1[2] * w[41];
+        h2[2] += h1[3] * w[42];
+        h2[2] += h1[4] * w[43];
+        h2[2] += h1[5] * w[44];
+        h2[2] = (h2[2] > 0.0f) ? h2[2] : 0.0f;
+        h2[3] = w[45];
+        h2[3] += h1[0] * w[46];
+        h2[3] += h1[1] * w[47];
+        h2[3] += h1[2] * w[48];
+        h2[3] += h1[3] * w[49];
+        h2[3] += h1[4] * w[50];
+        h2[3] += h1[5] * w[51];
+        h2[3] = (h2[3] > 0.0f) ? h2[3] : 0.0f;
+
+        // Output layer
+        output = w[52];
+        output += h2[0] * w[53];
+        output += h2[1] * w[54];
+        output += h2[2] * w[55];
+        output += h2[3] * w[56];
+
+        return output;
+    }
+
+    /**
+     * @brief Gradient step, 3-6-4-1 topology
+     * @param w Flat weight array
+     * @param in The input values of the forward pass
+     * @param h1 Hidden layer 1 activations of the forward pass
+     * @param h2 Hidden layer 2 activations of the forward pass
+     * @param output The output layer pre-activation
+     * @param error The error value
+     * @return void
+     */
+    static inline void nn_train_3_6_4(float *w, const float *in, const float *h1, const float *h2, float output, float error) {
+        float delta_h2[4];
+        float delta_h1, delta_output, sum;
+
+        delta_output = error * (((output > 0.0f) ? output : 0.0f) > 0.0f ? 1.0f : 0.0f);
+
+        // Update output layer
+        w[53] += ETA * delta_output * h2[0];
+        w[54] += ETA * delta_output * h2[1];
+        w[55] += ETA * delta_output * h2[2];
+        w[56] += ETA * delta_output * h2[3];
+        w[52] += ETA * delta_output;
+
+        // Update hidden layer 2
+        delta_h2[0] = delta_output * w[53] * (h2[0] > 0.0f ? 1.0f : 0.0f);
+        w[25] += ETA * delta_h2[0] * h1[0];
+        w[26] += ETA * delta_h2[0] * h1[1];
+        w[27] += ETA * delta_h2[0] * h1[2];
+        w[28] += ETA * delta_h2[0] * h1[3];
+        w[29] += ETA * delta_h2[0] * h1[4];
+        w[30] += ETA * delta_h2[0] * h1[5];
+        w[24] += ETA * delta_h2[0];
+        delta_h2[1] = delta_output * w[54] * (h2[1] > 0.0f ? 1.0f : 0.0f);
+        w[32] += ETA * delta_h2[1] * h1[0];
+        w[33] += ETA * delta_h2[1] * h1[1];
+        w[34] += ETA * delta_h2[1] * h1[2];
+        w[35] += ETA * delta_h2[1] * h1[3];
+        w[36] += ETA * delta_h2[1] * h1[4];
+        w[37] += ETA * delta_h2[1] * h1[5];
+        w[31] += ETA * delta_h2[1];
+        delta_h2[2] = delta_output * w[55] * (h2[2] > 0.0f ? 1.0f : 0.0f);
+        w[39] += ETA * delta_h2[2] * h1[0];
+        w[40] += ETA * delta_h2[2] * h1[1];
+        w[41] += ETA * delta_h2[2] * h1[2];
+        w[42] += ETA * delta_h2[2] * h1[3];
+        w[43] += ETA * delta_h2[2] * h1[4];
+        w[44] += ETA * delta_h2[2] * h1[5];
+        w[38] += ETA * delta_h2[2];
+        delta_h2[3] = delta_output * w[56] * (h2[3] > 0.0f ? 1.0f : 0.0f);
+        w[46] += ETA * delta_h2[3] * h1[0];
+        w[47] += ETA * delta_h2[3] * h1[1];
+        w[48] += ETA * delta_h2[3] * h1[2];
+        w[49] += ETA * delta_h2[3] * h1[3];
+        w[50] += ETA * delta_h2[3] * h1[4];
+        w[51] += ETA * delta_h2[3] * h1[5];
+        w[45] += ETA * delta_h2[3];
+
+        // Update hidden layer 1
+        sum = 0.0f;
+        sum += delta_h2[0] * w[25];
+        sum += delta_h2[1] * w[32];
+        sum += delta_h2[2] * w[39];
+        sum += delta_h2[3] * w[46];
+        delta_h1 = sum * (h1[0] > 0.0f ? 1.0f : 0.0f);
+        w[1] += ETA * delta_h1 * in[0];
+        w[2] += ETA * delta_h1 * in[1];
+        w[3] += ETA * delta_h1 * in[2];
+        w[0] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[26];
+        sum += delta_h2[1] * w[33];
+        sum += delta_h2[2] * w[40];
+        sum += delta_h2[3] * w[47];
+        delta_h1 = sum * (h1[1] > 0.0f ? 1.0f : 0.0f);
+        w[5] += ETA * delta_h1 * in[0];
+        w[6] += ETA * delta_h1 * in[1];
+        w[7] += ETA * delta_h1 * in[2];
+        w[4] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[27];
+        sum += delta_h2[1] * w[34];
+        sum += delta_h2[2] * w[41];
+        sum += delta_h2[3] * w[48];
+        delta_h1 = sum * (h1[2] > 0.0f ? 1.0f : 0.0f);
+        w[9] += ETA * delta_h1 * in[0];
+        w[10] += ETA * delta_h1 * in[1];
+        w[11] += ETA * delta_h1 * in[2];
+        w[8] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[28];
+        sum += delta_h2[1] * w[35];
+        sum += delta_h2[2] * w[42];
+        sum += delta_h2[3] * w[49];
+        delta_h1 = sum * (h1[3] > 0.0f ? 1.0f : 0.0f);
+        w[13] += ETA * delta_h1 * in[0];
+        w[14] += ETA * delta_h1 * in[1];
+        w[15] += ETA * delta_h1 * in[2];
+        w[12] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[29];
+        sum += delta_h2[1] * w[36];
+        sum += delta_h2[2] * w[43];
+        sum += delta_h2[3] * w[50];
+        delta_h1 = sum * (h1[4] > 0.0f ? 1.0f : 0.0f);
+        w[17] += ETA * delta_h1 * in[0];
+        w[18] += ETA * delta_h1 * in[1];
+        w[19] += ETA * delta_h1 * in[2];
+        w[16] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[30];
+        sum += delta_h2[1] * w[37];
+        sum += delta_h2[2] * w[44];
+        sum += delta_h2[3] * w[51];
+        delta_h1 = sum * (h1[5] > 0.0f ? 1.0f : 0.0f);
+        w[21] += ETA * delta_h1 * in[0];
+        w[22] += ETA * delta_h1 * in[1];
+        w[23] += ETA * delta_h1 * in[2];
+        w[20] += ETA * delta_h1;
+
+        return;
+    }
+
+    /**
+     * @brief Forward pass, 3-12-8-1 topology
+     * @param w Flat weight array
+     * @param in The input values
+     * @param h1 Hidden layer 1 activations (output)
+     * @param h2 Hidden layer 2 activations (output)
+     * @return float The output layer pre-activation
+     */
+    static inline float nn_forward_3_12_8(const float *w, const float *in, float *h1, float *h2) {
+        float output;
+
+        // Hidden layer 1
+        h1[0] = w[0];
+        h1[0] += in[0] * w[1];
+        h1[0] += in[1] * w[2];
+        h1[0] += in[2] * w[3];
+        h1[0] = (h1[0] > 0.0f) ? h1[0] : 0.0f;
+        h1[1] = w[4];
+        h1[1] += in[0] * w[5];
+        h1[1] += in[1] * w[6];
+        h1[1] += in[2] * w[7];
+        h1[1] = (h1[1] > 0.0f) ? h1[1] : 0.0f;
+        h1[2] = w[8];
+        h1[2] += in[0] * w[9];
+        h1[2] += in[1] * w[10];
+        h1[2] += in[2] * w[11];
+        h1[2] = (h1[2] > 0.0f) ? h1[2] : 0.0f;
+        h1[3] = w[12];
+        h1[3] += in[0] * w[13];
+        h1[3] += in[1] * w[14];
+        h1[3] += in[2] * w[15];
+        h1[3] = (h1[3] > 0.0f) ? h1[3] : 0.0f;
+        h1[4] = w[16];
+        h1[4] += in[0] * w[17];
+        h1[4] += in[1] * w[18];
+        h1[4] += in[2] * w[19];
+        h1[4] = (h1[4] > 0.0f) ? h1[4] : 0.0f;
+        h1[5] = w[20];
+        h1[5] += in[0] * w[21];
+        h1[5] += in[1] * w[22];
+        h1[5] += in[2] * w[23];
+        h1[5] = (h1[5] > 0.0f) ? h1[5] : 0.0f;
+        h1[6] = w[24];
+        h1[6] += in[0] * w[25];
+        h1[6] += in[1] * w[26];
+        h1[6] += in[2] * w[27];
+        h1[6] = (h1[6] > 0.0f) ? h1[6] : 0.0f;
+        h1[7] = w[28];
+        h1[7] += in[0] * w[29];
+        h1[7] += in[1] * w[30];
+        h1[7] += in[2] * w[31];
+        h1[7] = (h1[7] > 0.0f) ? h1[7] : 0.0f;
+        h1[8] = w[32];
+        h1[8] += in[0] * w[33];
+        h1[8] += in[1] * w[34];
+        h1[8] += in[2] * w[35];
+        h1[8] = (h1[8] > 0.0f) ? h1[8] : 0.0f;
+        h1[9] = w[36];
+        h1[9] += in[0] * w[37];
+        h1[9] += in[1] * w[38];
+        h1[9] += in[2] * w[39];
+        h1[9] = (h1[9] > 0.0f) ? h1[9] : 0.0f;
+        h1[10] = w[40];
+        h1[10] += in[0] * w[41];
+        h1[10] += in[1] * w[42];
+        h1[10] += in[2] * w[43];
+        h1[10] = (h1[10] > 0.0f) ? h1[10] : 0.0f;
+        h1[11] = w[44];
+        h1[11] += in[0] * w[45];
+        h1[11] += in[1] * w[46];
+        h1[11] += in[2] * w[47];
+        h1[11] = (h1[11] > 0.0f) ? h1[11] : 0.0f;
+
+        // Hidden layer 2
+        h2[0] = w[48];
+        h2[0] += h1[0] * w[49];
+        h2[0] += h1[1] * w[50];
+        h2[0] += h1[2] * w[51];
+        h2[0] += h1[3] * w[52];
+        h2[0] += h1[4] * w[53];
+        h2[0] += h1[5] * w[54];
+        h2[0] += h1[6] * w[55];
+        h2[0] += h1[7] * w[56];
+        h2[0] += h1[8] * w[57];
+        h2[0] += h1[9] * w[58];
+        h2[0] += h1[10] * w[59];
+        h2[0] += h1[11] * w[60];
+        h2[0] = (h2[0] > 0.0f) ? h2[0] : 0.0f;
+        h2[1] = w[61];
+        h2[1] += h1[0] * w[62];
+        h2[1] += h1[1] * w[63];
+        h2[1] += h1[2] * w[64];
+        h2[1] += h1[3] * w[65];
+        h2[1] += h1[4] * w[66];
+        h2[1] += h1[5] * w[67];
+        h2[1] += h1[6] * w[68];
+        h2[1] += h1[7] * w[69];
+        h2[1] += h1[8] * w[70];
+        h2[1] += h1[9] * w[71];
+        h2[1] += h1[10] * w[72];
+        h2[1] += h1[11] * w[73];
+        h2[1] = (h2[1] > 0.0f) ? h2[1] : 0.0f;
+        h2[2] = w[74];
+        h2[2] += h1[0] * w[75];
+        h2[2] += h1[1] * w[76];
+        h2[2] += h1[2] * w[77];
+        h2[2] += h1[3] * w[78];
+        h2[2] += h1[4] * w[79];
+        h2[2] += h1[5] * w[80];
+        h2[2] += h1[6] * w[81];
+        h2[2] += h1[7] * w[82];
+        h2[2] += h1[8] * w[83];
+        h2[2] += h1[9] * w[84];
+        h2[2] += h1[10] * w[85];
+        h2[2] += h1[11] * w[86];
+        h2[2] = (h2[2] > 0.0f) ? h2[2] : 0.0f;
+        h2[3] = w[87];
+        h2[3] += h1[0] * w[88];
+        h2[3] += h1[1] * w[89];
+        h2[3] += h1[2] * w[90];
+        h2[3] += h1[3] * w[91];
+        h2[3] += h1[4] * w[92];
+        h2[3] += h1[5] * w[93];
+        h2[3] += h1[6] * w[94];
+        h2[3] += h1[7] * w[95];
+        h2[3] += h1[8] * w[96];
+        h2[3] += h1[9] * w[97];
+        h2[3] += h1[10] * w[98];
+        h2[3] += h1[11] * w[99];
+        h2[3] = (h2[3] > 0.0f) ? h2[3] : 0.0f;
+        h2[4] = w[100];
+        h2[4] += h1[0] * w[101];
+        h2[4] += h1[1] * w[102];
+        h2[4] += h1[2] * w[103];
+        h2[4] += h1[3] * w[104];
+        h2[4] += h1[4] * w[105];
+        h2[4] += h1[5] * w[106];
+        h2[4] += h1[6] * w[107];
+        h2[4] += h1[7] * w[108];
+        h2[4] += h1[8] * w[109];
+        h2[4] += h1[9] * w[110];
+        h2[4] += h1[10] * w[111];
+        h2[4] += h1[11] * w[112];
+        h2[4] = (h2[4] > 0.0f) ? h2[4] : 0.0f;
+        h2[5] = w[113];
+        h2[5] += h1[0] * w[114];
+        h2[5] += h1[1] * w[115];
+        h2[5] += h1[2] * w[116];
+        h2[5] += h1[3] * w[117];
+        h2[5] += h1[4] * w[118];
+        h2[5] += h1[5] * w[119];
+        h2[5] += h1[6] * w[120];
+        h2[5] += h1[7] * w[121];
+        h2[5] += h1[8] * w[122];
+        h2[5] += h1[9] * w[123];
+        h2[5] += h1[10] * w[124];
+        h2[5] += h1[11] * w[125];
+        h2[5] = (h2[5] > 0.0f) ? h2[5] : 0.0f;
+        h2[6] = w[126];
+        h2[6] += h1[0] * w[127];
+        h2[6] += h1[1] * w[128];
+        h2[6] += h1[2] * w[129];
+        h2[6] += h1[3] * w[130];
+        h2[6] += h1[4] * w[131];
+        h2[6] += h1[5] * w[132];
+        h2[6] += h1[6] * w[133];
+        h2[6] += h1[7] * w[134];
+        h2[6] += h1[8] * w[135];
+        h2[6] += h1[9] * w[136];
+        h2[6] += h1[10] * w[137];
+        h2[6] += h1[11] * w[138];
+        h2[6] = (h2[6] > 0.0f) ? h2[6] : 0.0f;
+        h2[7] = w[139];
+        h2[7] += h1[0] * w[140];
+        h2[7] += h1[1] * w[141];
+        h2[7] += h1[2] * w[142];
+        h2[7] += h1[3] * w[143];
+        h2[7] += h1[4] * w[144];
+        h2[7] += h1[5] * w[145];
+        h2[7] += h1[6] * w[146];
+        h2[7] += h1[7] * w[147];
+        h2[7] += h1[8] * w[148];
+        h2[7] += h1[9] * w[149];
+        h2[7] += h1[10] * w[150];
+        h2[7] += h1[11] * w[151];
+        h2[7] = (h2[7] > 0.0f) ? h2[7] : 0.0f;
+
+        // Output layer
+        output = w[152];
+        output += h2[0] * w[153];
+        output += h2[1] * w[154];
+        output += h2[2] * w[155];
+        output += h2[3] * w[156];
+        output += h2[4] * w[157];
+        output += h2[5] * w[158];
+        output += h2[6] * w[159];
+        output += h2[7] * w[160];
+
+        return output;
+    }
+
+    /**
+     * @brief Gradient step, 3-12-8-1 topology
+     * @param w Flat weight array
+     * @param in The input values of the forward pass
+     * @param h1 Hidden layer 1 activations of the forward pass
+     * @param h2 Hidden layer 2 activations of the forward pass
+     * @param output The output layer pre-activation
+     * @param error The error value
+     * @return void
+     */
+    static inline void nn_train_3_12_8(float *w, const float *in, const float *h1, const float *h2, float output, float error) {
+        float delta_h2[8];
+        float delta_h1, delta_output, sum;
+
+        delta_output = error * (((output > 0.0f) ? output : 0.0f) > 0.0f ? 1.0f : 0.0f);
+
+        // Update output layer
+        w[153] += ETA * delta_output * h2[0];
+        w[154] += ETA * delta_output * h2[1];
+        w[155] += ETA * delta_output * h2[2];
+        w[156] += ETA * delta_output * h2[3];
+        w[157] += ETA * delta_output * h2[4];
+        w[158] += ETA * delta_output * h2[5];
+        w[159] += ETA * delta_output * h2[6];
+        w[160] += ETA * delta_output * h2[7];
+        w[152] += ETA * delta_output;
+
+        // Update hidden layer 2
+        delta_h2[0] = delta_output * w[153] * (h2[0] > 0.0f ? 1.0f : 0.0f);
+        w[49] += ETA * delta_h2[0] * h1[0];
+        w[50] += ETA * delta_h2[0] * h1[1];
+        w[51] += ETA * delta_h2[0] * h1[2];
+        w[52] += ETA * delta_h2[0] * h1[3];
+        w[53] += ETA * delta_h2[0] * h1[4];
+        w[54] += ETA * delta_h2[0] * h1[5];
+        w[55] += ETA * delta_h2[0] * h1[6];
+        w[56] += ETA * delta_h2[0] * h1[7];
+        w[57] += ETA * delta_h2[0] * h1[8];
+        w[58] += ETA * delta_h2[0] * h1[9];
+        w[59] += ETA * delta_h2[0] * h1[10];
+        w[60] += ETA * delta_h2[0] * h1[11];
+        w[48] += ETA * delta_h2[0];
+        delta_h2[1] = delta_output * w[154] * (h2[1] > 0.0f ? 1.0f : 0.0f);
+        w[62] += ETA * delta_h2[1] * h1[0];
+        w[63] += ETA * delta_h2[1] * h1[1];
+        w[64] += ETA * delta_h2[1] * h1[2];
+        w[65] += ETA * delta_h2[1] * h1[3];
+        w[66] += ETA * delta_h2[1] * h1[4];
+        w[67] += ETA * delta_h2[1] * h1[5];
+        w[68] += ETA * delta_h2[1] * h1[6];
+        w[69] += ETA * delta_h2[1] * h1[7];
+        w[70] += ETA * delta_h2[1] * h1[8];
+        w[71] += ETA * delta_h2[1] * h1[9];
+        w[72] += ETA * delta_h2[1] * h1[10];
+        w[73] += ETA * delta_h2[1] * h1[11];
+        w[61] += ETA * delta_h2[1];
+        delta_h2[2] = delta_output * w[155] * (h2[2] > 0.0f ? 1.0f : 0.0f);
+        w[75] += ETA * delta_h2[2] * h1[0];
+        w[76] += ETA * delta_h2[2] * h1[1];
+        w[77] += ETA * delta_h2[2] * h1[2];
+        w[78] += ETA * delta_h2[2] * h1[3];
+        w[79] += ETA * delta_h2[2] * h1[4];
+        w[80] += ETA * delta_h2[2] * h1[5];
+        w[81] += ETA * delta_h2[2] * h1[6];
+        w[82] += ETA * delta_h2[2] * h1[7];
+        w[83] += ETA * delta_h2[2] * h1[8];
+        w[84] += ETA * delta_h2[2] * h1[9];
+        w[85] += ETA * delta_h2[2] * h1[10];
+        w[86] += ETA * delta_h2[2] * h1[11];
+        w[74] += ETA * delta_h2[2];
+        delta_h2[3] = delta_output * w[156] * (h2[3] > 0.0f ? 1.0f : 0.0f);
+        w[88] += ETA * delta_h2[3] * h1[0];
+        w[89] += ETA * delta_h2[3] * h1[1];
+        w[90] += ETA * delta_h2[3] * h1[2];
+        w[91] += ETA * delta_h2[3] * h1[3];
+        w[92] += ETA * delta_h2[3] * h1[4];
+        w[93] += ETA * delta_h2[3] * h1[5];
+        w[94] += ETA * delta_h2[3] * h1[6];
+        w[95] += ETA * delta_h2[3] * h1[7];
+        w[96] += ETA * delta_h2[3] * h1[8];
+        w[97] += ETA * delta_h2[3] * h1[9];
+        w[98] += ETA * delta_h2[3] * h1[10];
+        w[99] += ETA * delta_h2[3] * h1[11];
+        w[87] += ETA * delta_h2[3];
+        delta_h2[4] = delta_output * w[157] * (h2[4] > 0.0f ? 1.0f : 0.0f);
+        w[101] += ETA * delta_h2[4] * h1[0];
+        w[102] += ETA * delta_h2[4] * h1[1];
+        w[103] += ETA * delta_h2[4] * h1[2];
+        w[104] += ETA * delta_h2[4] * h1[3];
+        w[105] += ETA * delta_h2[4] * h1[4];
+        w[106] += ETA * delta_h2[4] * h1[5];
+        w[107] += ETA * delta_h2[4] * h1[6];
+        w[108] += ETA * delta_h2[4] * h1[7];
+        w[109] += ETA * delta_h2[4] * h1[8];
+        w[110] += ETA * delta_h2[4] * h1[9];
+        w[111] += ETA * delta_h2[4] * h1[10];
+        w[112] += ETA * delta_h2[4] * h1[11];
+        w[100] += ETA * delta_h2[4];
+        delta_h2[5] = delta_output * w[158] * (h2[5] > 0.0f ? 1.0f : 0.0f);
+        w[114] += ETA * delta_h2[5] * h1[0];
+        w[115] += ETA * delta_h2[5] * h1[1];
+        w[116] += ETA * delta_h2[5] * h1[2];
+        w[117] += ETA * delta_h2[5] * h1[3];
+        w[118] += ETA * delta_h2[5] * h1[4];
+        w[119] += ETA * delta_h2[5] * h1[5];
+        w[120] += ETA * delta_h2[5] * h1[6];
+        w[121] += ETA * delta_h2[5] * h1[7];
+        w[122] += ETA * delta_h2[5] * h1[8];
+        w[123] += ETA * delta_h2[5] * h1[9];
+        w[124] += ETA * delta_h2[5] * h1[10];
+        w[125] += ETA * delta_h2[5] * h1[11];
+        w[113] += ETA * delta_h2[5];
+        delta_h2[6] = delta_output * w[159] * (h2[6] > 0.0f ? 1.0f : 0.0f);
+        w[127] += ETA * delta_h2[6] * h1[0];
+        w[128] += ETA * delta_h2[6] * h1[1];
+        w[129] += ETA * delta_h2[6] * h1[2];
+        w[130] += ETA * delta_h2[6] * h1[3];
+        w[131] += ETA * delta_h2[6] * h1[4];
+        w[132] += ETA * delta_h2[6] * h1[5];
+        w[133] += ETA * delta_h2[6] * h1[6];
+        w[134] += ETA * delta_h2[6] * h1[7];
+        w[135] += ETA * delta_h2[6] * h1[8];
+        w[136] += ETA * delta_h2[6] * h1[9];
+        w[137] += ETA * delta_h2[6] * h1[10];
+        w[138] += ETA * delta_h2[6] * h1[11];
+        w[126] += ETA * delta_h2[6];
+        delta_h2[7] = delta_output * w[160] * (h2[7] > 0.0f ? 1.0f : 0.0f);
+        w[140] += ETA * delta_h2[7] * h1[0];
+        w[141] += ETA * delta_h2[7] * h1[1];
+        w[142] += ETA * delta_h2[7] * h1[2];
+        w[143] += ETA * delta_h2[7] * h1[3];
+        w[144] += ETA * delta_h2[7] * h1[4];
+        w[145] += ETA * delta_h2[7] * h1[5];
+        w[146] += ETA * delta_h2[7] * h1[6];
+        w[147] += ETA * delta_h2[7] * h1[7];
+        w[148] += ETA * delta_h2[7] * h1[8];
+        w[149] += ETA * delta_h2[7] * h1[9];
+        w[150] += ETA * delta_h2[7] * h1[10];
+        w[151] += ETA * delta_h2[7] * h1[11];
+        w[139] += ETA * delta_h2[7];
+
+        // Update hidden layer 1
+        sum = 0.0f;
+        sum += delta_h2[0] * w[49];
+        sum += delta_h2[1] * w[62];
+        sum += delta_h2[2] * w[75];
+        sum += delta_h2[3] * w[88];
+        sum += delta_h2[4] * w[101];
+        sum += delta_h2[5] * w[114];
+        sum += delta_h2[6] * w[127];
+        sum += delta_h2[7] * w[140];
+        delta_h1 = sum * (h1[0] > 0.0f ? 1.0f : 0.0f);
+        w[1] += ETA * delta_h1 * in[0];
+        w[2] += ETA * delta_h1 * in[1];
+        w[3] += ETA * delta_h1 * in[2];
+        w[0] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[50];
+        sum += delta_h2[1] * w[63];
+        sum += delta_h2[2] * w[76];
+        sum += delta_h2[3] * w[89];
+        sum += delta_h2[4] * w[102];
+        sum += delta_h2[5] * w[115];
+        sum += delta_h2[6] * w[128];
+        sum += delta_h2[7] * w[141];
+        delta_h1 = sum * (h1[1] > 0.0f ? 1.0f : 0.0f);
+        w[5] += ETA * delta_h1 * in[0];
+        w[6] += ETA * delta_h1 * in[1];
+        w[7] += ETA * delta_h1 * in[2];
+        w[4] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[51];
+        sum += delta_h2[1] * w[64];
+        sum += delta_h2[2] * w[77];
+        sum += delta_h2[3] * w[90];
+        sum += delta_h2[4] * w[103];
+        sum += delta_h2[5] * w[116];
+        sum += delta_h2[6] * w[129];
+        sum += delta_h2[7] * w[142];
+        delta_h1 = sum * (h1[2] > 0.0f ? 1.0f : 0.0f);
+        w[9] += ETA * delta_h1 * in[0];
+        w[10] += ETA * delta_h1 * in[1];
+        w[11] += ETA * delta_h1 * in[2];
+        w[8] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[52];
+        sum += delta_h2[1] * w[65];
+        sum += delta_h2[2] * w[78];
+        sum += delta_h2[3] * w[91];
+        sum += delta_h2[4] * w[104];
+        sum += delta_h2[5] * w[117];
+        sum += delta_h2[6] * w[130];
+        sum += delta_h2[7] * w[143];
+        delta_h1 = sum * (h1[3] > 0.0f ? 1.0f : 0.0f);
+        w[13] += ETA * delta_h1 * in[0];
+        w[14] += ETA * delta_h1 * in[1];
+        w[15] += ETA * delta_h1 * in[2];
+        w[12] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[53];
+        sum += delta_h2[1] * w[66];
+        sum += delta_h2[2] * w[79];
+        sum += delta_h2[3] * w[92];
+        sum += delta_h2[4] * w[105];
+        sum += delta_h2[5] * w[118];
+        sum += delta_h2[6] * w[131];
+        sum += delta_h2[7] * w[144];
+        delta_h1 = sum * (h1[4] > 0.0f ? 1.0f : 0.0f);
+        w[17] += ETA * delta_h1 * in[0];
+        w[18] += ETA * delta_h1 * in[1];
+        w[19] += ETA * delta_h1 * in[2];
+        w[16] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[54];
+        sum += delta_h2[1] * w[67];
+        sum += delta_h2[2] * w[80];
+        sum += delta_h2[3] * w[93];
+        sum += delta_h2[4] * w[106];
+        sum += delta_h2[5] * w[119];
+        sum += delta_h2[6] * w[132];
+        sum += delta_h2[7] * w[145];
+        delta_h1 = sum * (h1[5] > 0.0f ? 1.0f : 0.0f);
+        w[21] += ETA * delta_h1 * in[0];
+        w[22] += ETA * delta_h1 * in[1];
+        w[23] += ETA * delta_h1 * in[2];
+        w[20] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[55];
+        sum += delta_h2[1] * w[68];
+        sum += delta_h2[2] * w[81];
+        sum += delta_h2[3] * w[94];
+        sum += delta_h2[4] * w[107];
+        sum += delta_h2[5] * w[120];
+        sum += delta_h2[6] * w[133];
+        sum += delta_h2[7] * w[146];
+        delta_h1 = sum * (h1[6] > 0.0f ? 1.0f : 0.0f);
+        w[25] += ETA * delta_h1 * in[0];
+        w[26] += ETA * delta_h1 * in[1];
+        w[27] += ETA * delta_h1 * in[2];
+        w[24] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[56];
+        sum += delta_h2[1] * w[69];
+        sum += delta_h2[2] * w[82];
+        sum += delta_h2[3] * w[95];
+        sum += delta_h2[4] * w[108];
+        sum += delta_h2[5] * w[121];
+        sum += delta_h2[6] * w[134];
+        sum += delta_h2[7] * w[147];
+        delta_h1 = sum * (h1[7] > 0.0f ? 1.0f : 0.0f);
+        w[29] += ETA * delta_h1 * in[0];
+        w[30] += ETA * delta_h1 * in[1];
+        w[31] += ETA * delta_h1 * in[2];
+        w[28] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[57];
+        sum += delta_h2[1] * w[70];
+        sum += delta_h2[2] * w[83];
+        sum += delta_h2[3] * w[96];
+        sum += delta_h2[4] * w[109];
+        sum += delta_h2[5] * w[122];
+        sum += delta_h2[6] * w[135];
+        sum += delta_h2[7] * w[148];
+        delta_h1 = sum * (h1[8] > 0.0f ? 1.0f : 0.0f);
+        w[33] += ETA * delta_h1 * in[0];
+        w[34] += ETA * delta_h1 * in[1];
+        w[35] += ETA * delta_h1 * in[2];
+        w[32] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[58];
+        sum += delta_h2[1] * w[71];
+        sum += delta_h2[2] * w[84];
+        sum += delta_h2[3] * w[97];
+        sum += delta_h2[4] * w[110];
+        sum += delta_h2[5] * w[123];
+        sum += delta_h2[6] * w[136];
+        sum += delta_h2[7] * w[149];
+        delta_h1 = sum * (h1[9] > 0.0f ? 1.0f : 0.0f);
+        w[37] += ETA * delta_h1 * in[0];
+        w[38] += ETA * delta_h1 * in[1];
+        w[39] += ETA * delta_h1 * in[2];
+        w[36] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[59];
+        sum += delta_h2[1] * w[72];
+        sum += delta_h2[2] * w[85];
+        sum += delta_h2[3] * w[98];
+        sum += delta_h2[4] * w[111];
+        sum += delta_h2[5] * w[124];
+        sum += delta_h2[6] * w[137];
+        sum += delta_h2[7] * w[150];
+        delta_h1 = sum * (h1[10] > 0.0f ? 1.0f : 0.0f);
+        w[41] += ETA * delta_h1 * in[0];
+        w[42] += ETA * delta_h1 * in[1];
+        w[43] += ETA * delta_h1 * in[2];
+        w[40] += ETA * delta_h1;
+        sum = 0.0f;
+        sum += delta_h2[0] * w[60];
+        sum += delta_h2[1] * w[73];
+        sum += delta_h2[2] * w[86];
+        sum += delta_h2[3] * w[99];
+        sum += delta_h2[4] * w[112];
+        sum += delta_h2[5] * w[125];
+        sum += delta_h2[6] * w[138];
+        sum += delta_h2[7] * w[151];
+        delta_h1 = sum * (h1[11] > 0.0f ? 1.0f : 0.0f);
+        w[45] += ETA * delta_h1 * in[0];
+        w[46] += ETA * delta_h1 * in[1];
+        w[47] += ETA * delta_h1 * in[2];
+        w[44] += ETA * delta_h1;
+
+        return;
+    }
+
+    // Kernels of the topology configured in controllers.h
+    #if (INPUT_SIZE == 3) && (HIDDEN1_SIZE == 3) && (HIDDEN2_SIZE == 2)
+        #define nn_forward_unrolled nn_forward_3_3_2
+        #define nn_train_unrolled   nn_train_3_3_2
+    #elif (INPUT_SIZE == 3) && (HIDDEN1_SIZE == 6) && (HIDDEN2_SIZE == 4)
+        #define nn_forward_unrolled nn_forward_3_6_4
+        #define nn_train_unrolled   nn_train_3_6_4
+    #elif (INPUT_SIZE == 3) && (HIDDEN1_SIZE == 12) && (HIDDEN2_SIZE == 8)
+        #define nn_forward_unrolled nn_forward_3_12_8
+        #define nn_train_unrolled   nn_train_3_12_8
+    #else
+        #error "No unrolled kernel for the configured topology, run tools/nn_codegen.py"
+    #endif
+
+#endif /* NN_KERNELS_H */
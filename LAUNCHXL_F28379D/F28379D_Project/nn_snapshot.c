@@ -0,0 +1,328 @@
+/**
+ * @file nn_snapshot.c
+ * @brief Implementation of the Neural Network weight snapshots
+ *        Snapshots are appended to fixed-size slots of two reserved flash
+ *        sectors used in turn: when one sector is full, the other is
+ *        erased and filled, so the last good snapshot survives an
+ *        interrupted erase or write.
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "nn_snapshot.h"
+#include "controllers_fixed.h"
+#include "Libraries/freeRTOS/FreeRTOS.h"
+#include "Libraries/freeRTOS/task.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef NN_SNAPSHOT_ENABLE
+    #include "F021_F2837xD_C28x.h"
+#endif
+
+NNSnapshotStatus nn_snapshot_status = {0};
+
+static uint32_t next_address = NN_SNAPSHOT_SECTOR_A;
+static uint16_t scanned = 0;
+
+#ifdef NN_SNAPSHOT_ENABLE
+static uint16_t flash_api_ready = 0;
+#endif
+
+/**
+ * @brief CRC16-CCITT (polynomial 0x1021) over 16-bit words, low byte first
+ * @param data Words to process
+ * @param length Number of words
+ * @param crc Initial value
+ * @return uint16_t The updated CRC
+ */
+static uint16_t nn_snapshot_crc(const uint16_t *data, uint16_t length, uint16_t crc) {
+    uint16_t x, byte, bit;
+
+    for (x = 0; x < 2 * length; x++) {
+        byte = (x & 1) ? (data[x >> 1] >> 8) : (data[x >> 1] & 0xFF);
+        crc ^= byte << 8;
+
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+
+    return crc;
+}
+
+/**
+ * @brief CRC of a snapshot: header up to the crc field, then the weights
+ * @param header Snapshot header, followed by the weights
+ * @return uint16_t The snapshot CRC
+ */
+static uint16_t nn_snapshot_checksum(const NNSnapshotHeader *header) {
+    uint16_t crc;
+
+    crc = nn_snapshot_crc((const uint16_t *)header, offsetof(NNSnapshotHeader, crc) / sizeof(uint16_t), 0xFFFF);
+    crc = nn_snapshot_crc((const uint16_t *)(header + 1), sizeof(NeuralNetwork) / sizeof(uint16_t), crc);
+
+    return crc;
+}
+
+/**
+ * @brief Check a snapshot written by this firmware topology
+ * @param header Snapshot header
+ * @return 1 if the snapshot is valid, 0 otherwise
+ */
+static uint16_t nn_snapshot_valid(const NNSnapshotHeader *header) {
+    return (header->magic == NN_SNAPSHOT_MAGIC)             &&
+           (header->version == NN_SNAPSHOT_VERSION)         &&
+           (header->topology == NN_SNAPSHOT_TOPOLOGY)       &&
+           (header->length == sizeof(NeuralNetwork))        &&
+           (header->crc == nn_snapshot_checksum(header));
+}
+
+/**
+ * @brief First slot of the sector not containing address
+ */
+static inline uint32_t nn_snapshot_other_sector(uint32_t address) {
+    return (address >= NN_SNAPSHOT_SECTOR_B) ? NN_SNAPSHOT_SECTOR_A : NN_SNAPSHOT_SECTOR_B;
+}
+
+/**
+ * @brief Slot following address, moving to the other sector at the end
+ */
+static inline uint32_t nn_snapshot_next_slot(uint32_t address) {
+    uint32_t sector = (address >= NN_SNAPSHOT_SECTOR_B) ? NN_SNAPSHOT_SECTOR_B : NN_SNAPSHOT_SECTOR_A;
+
+    address += NN_SNAPSHOT_SLOT_SIZE;
+    if (address + NN_SNAPSHOT_SLOT_SIZE > sector + NN_SNAPSHOT_SECTOR_SIZE)
+        return nn_snapshot_other_sector(sector);
+
+    return address;
+}
+
+#ifdef NN_SNAPSHOT_ENABLE
+/**
+ * @brief Erase a snapshot sector
+ * @param address Sector start address
+ * @return 1 on success, 0 on a Flash API error
+ */
+static uint16_t nn_snapshot_erase(uint32_t address) {
+    Fapi_StatusType status;
+
+    EALLOW;
+    status = Fapi_issueAsyncCommandWithAddress(Fapi_EraseSector, (uint32 *)address);
+    while (Fapi_checkFsmForReady() != Fapi_Status_FsmReady);
+    EDIS;
+
+    return (status == Fapi_Status_Success) && (Fapi_getFsmStatus() == 0);
+}
+
+/**
+ * @brief Program words to an erased slot, 8 words at a time
+ * @param address Slot address (128-bit aligned)
+ * @param data Words to program
+ * @param length Number of words (multiple of 8)
+ * @return 1 on success, 0 on a Flash API error
+ */
+static uint16_t nn_snapshot_program(uint32_t address, uint16_t *data, uint16_t length) {
+    Fapi_StatusType status;
+    uint16_t x;
+
+    for (x = 0; x < length; x += 8) {
+        EALLOW;
+        status = Fapi_issueProgrammingCommand((uint32 *)(address + x), data + x, 8, 0, 0, Fapi_AutoEccGeneration);
+        while (Fapi_checkFsmForReady() == Fapi_Status_FsmBusy);
+        EDIS;
+
+        if ((status != Fapi_Status_Success) || (Fapi_getFsmStatus() != 0))
+            return 0;
+    }
+
+    return 1;
+}
+#endif
+
+/**
+ * @brief Find the last good snapshot and the next free slot
+ *        Called on the first load or save
+ * @return void
+ */
+void nn_snapshot_init(void) {
+    const uint32_t sectors[2] = { NN_SNAPSHOT_SECTOR_A, NN_SNAPSHOT_SECTOR_B };
+    const NNSnapshotHeader *header;
+    uint32_t address;
+    uint16_t s, n;
+
+    nn_snapshot_status.address = 0;
+    nn_snapshot_status.sequence = 0;
+
+    // Slots are filled in order, the first erased slot ends a sector
+    for (s = 0; s < 2; s++) {
+        for (n = 0; n < NN_SNAPSHOT_SLOTS; n++) {
+            address = sectors[s] + (uint32_t)n * NN_SNAPSHOT_SLOT_SIZE;
+            header = (const NNSnapshotHeader *)(uintptr_t)address;
+
+            if (header->magic == 0xFFFF)
+                break;
+
+            if (nn_snapshot_valid(header) &&
+                ((nn_snapshot_status.address == 0) || (header->sequence > nn_snapshot_status.sequence))) {
+                nn_snapshot_status.address = address;
+                nn_snapshot_status.sequence = header->sequence;
+            }
+        }
+    }
+
+    if (nn_snapshot_status.address)
+        next_address = nn_snapshot_next_slot(nn_snapshot_status.address);
+    else
+        next_address = NN_SNAPSHOT_SECTOR_A;
+
+    scanned = 1;
+
+    return;
+}
+
+/**
+ * @brief Load the last good snapshot
+ * @param network Destination network
+ * @return 1 if the weights were restored, 0 if there is no valid snapshot
+ */
+uint16_t nn_snapshot_load(NeuralNetwork *network) {
+    const NNSnapshotHeader *header;
+
+    if (!scanned)
+        nn_snapshot_init();
+
+    nn_snapshot_status.loaded = 0;
+
+    if (nn_snapshot_status.address == 0)
+        return 0;
+
+    header = (const NNSnapshotHeader *)(uintptr_t)nn_snapshot_status.address;
+    if (!nn_snapshot_valid(header))
+        return 0;
+
+    memcpy(network, header + 1, sizeof(NeuralNetwork));
+    nn_snapshot_status.loaded = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Write a snapshot to the next free slot
+ *        Blocks for the flash operation (a sector erase when a sector is
+ *        started), so it must run from a task, never from an ISR
+ * @param network Weights to store
+ * @return 1 on success, 0 on error or with NN_SNAPSHOT_ENABLE undefined
+ */
+uint16_t nn_snapshot_save(const NeuralNetwork *network) {
+#ifdef NN_SNAPSHOT_ENABLE
+    static uint16_t slot[NN_SNAPSHOT_SLOT_SIZE];
+    NNSnapshotHeader *header = (NNSnapshotHeader *)slot;
+    uint32_t address, start_cycles;
+    uint16_t ok;
+
+    if (!scanned)
+        nn_snapshot_init();
+
+    // The Flash API needs the final SYSCLK, set up after controller_init
+    if (!flash_api_ready) {
+        EALLOW;
+        Fapi_initializeAPI(F021_CPU0_BASE_ADDRESS, CPU_FREQ / 1000000);
+        Fapi_setActiveFlashBank(Fapi_FlashBank0);
+        EDIS;
+
+        flash_api_ready = 1;
+    }
+
+    start_cycles = read_cycle_counter();
+
+    memset(slot, 0xFF, sizeof(slot));
+    header->magic       = NN_SNAPSHOT_MAGIC;
+    header->version     = NN_SNAPSHOT_VERSION;
+    header->topology    = NN_SNAPSHOT_TOPOLOGY;
+    header->length      = sizeof(NeuralNetwork);
+    header->sequence    = nn_snapshot_status.sequence + 1;
+    memcpy(header + 1, network, sizeof(NeuralNetwork));
+    header->crc         = nn_snapshot_checksum(header);
+
+    // A slot that is not erased (interrupted write) moves to the other sector
+    address = next_address;
+    if ((address != NN_SNAPSHOT_SECTOR_A) && (address != NN_SNAPSHOT_SECTOR_B) &&
+        (*(const uint16_t *)address != 0xFFFF))
+        address = nn_snapshot_other_sector(address);
+
+    SeizeFlashPump();
+
+    ok = 1;
+    if ((address == NN_SNAPSHOT_SECTOR_A) || (address == NN_SNAPSHOT_SECTOR_B))
+        ok = nn_snapshot_erase(address);
+
+    if (ok)
+        ok = nn_snapshot_program(address, slot, NN_SNAPSHOT_SLOT_SIZE);
+
+    ReleaseFlashPump();
+
+    if (ok)
+        ok = nn_snapshot_valid((const NNSnapshotHeader *)address);
+
+    next_address = nn_snapshot_next_slot(address);
+
+    if (!ok) {
+        nn_snapshot_status.errors++;
+        return 0;
+    }
+
+    nn_snapshot_status.address = address;
+    nn_snapshot_status.sequence = header->sequence;
+    nn_snapshot_status.saves++;
+    nn_snapshot_status.save_cycles = read_cycle_counter() - start_cycles;
+
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Take a snapshot of the running network every NN_SNAPSHOT_PERIOD ms
+ *        Called from nn_training_task
+ * @param elapsed_ms Time since the previous call
+ * @return void
+ */
+void nn_snapshot_periodic(uint32_t elapsed_ms) {
+#if defined(NN_SNAPSHOT_ENABLE) && (NN_SNAPSHOT_PERIOD > 0)
+    static uint32_t since_last = 0;
+    NeuralNetwork copy;
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FIXED)
+    int x;
+#endif
+
+    since_last += elapsed_ms;
+    if (since_last < NN_SNAPSHOT_PERIOD)
+        return;
+
+    since_last = 0;
+
+    if (current_controller_type != NNA_CONTROLLER)
+        return;
+
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FIXED)
+    taskENTER_CRITICAL();
+    for (x = 0; x < NN_WEIGHT_COUNT; x++)
+        copy.weights[x] = q24_to_float(neural_network_q.weights[x]);
+    taskEXIT_CRITICAL();
+#elif (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    // The shadow copy belongs to the calling task
+    copy = neural_network;
+#else
+    // Trained by the control path, copy it in one piece
+    taskENTER_CRITICAL();
+    copy = neural_network;
+    taskEXIT_CRITICAL();
+#endif
+
+    nn_snapshot_save(&copy);
+#endif
+
+    return;
+}
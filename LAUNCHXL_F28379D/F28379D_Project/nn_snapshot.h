@@ -0,0 +1,71 @@
+/**
+ * @file nn_snapshot.h
+ * @brief Neural Network weight snapshots in on-chip flash
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef NN_SNAPSHOT_H
+#define NN_SNAPSHOT_H
+
+    #include "controllers.h"
+
+    /**
+     * @brief Snapshot writing
+     *        Erasing and programming need the TI F021 Flash API library
+     *        (F021_API_F2837xD_FPU32.lib and F021_F2837xD_C28x.h from
+     *        C2000Ware). Add it to the project and uncomment the define
+     *        below. Without it, snapshots already in flash are still loaded.
+     */
+    // #define NN_SNAPSHOT_ENABLE
+
+    #define NN_SNAPSHOT_PERIOD      60000       // Periodic snapshot (ms), 0 to disable
+
+    // Snapshot header identification
+    #define NN_SNAPSHOT_MAGIC       0x4E4E      // "NN"
+    #define NN_SNAPSHOT_VERSION     1
+    #define NN_SNAPSHOT_TOPOLOGY    ((INPUT_SIZE << 10) | (HIDDEN1_SIZE << 5) | HIDDEN2_SIZE)
+
+    // Reserved flash sectors (bank 0), see 2837xD_RAM_lnk_cpu1.cmd
+    #define NN_SNAPSHOT_SECTOR_A    0x0BC000UL  // FLASHM
+    #define NN_SNAPSHOT_SECTOR_B    0x0BE000UL  // FLASHN
+    #define NN_SNAPSHOT_SECTOR_SIZE 0x1FF0UL    // Words, FLASHN without its reserved tail
+
+    /**
+     * @brief Snapshot header, followed by the NeuralNetwork structure
+     */
+    typedef struct {
+        uint16_t magic;
+        uint16_t version;
+        uint16_t topology;          // NN_SNAPSHOT_TOPOLOGY of the writer
+        uint16_t length;            // sizeof(NeuralNetwork)
+        uint32_t sequence;          // Incremented on every snapshot
+        uint16_t crc;               // CRC16-CCITT of the header up to here and the weights
+        uint16_t reserved;
+    } NNSnapshotHeader;
+
+    // Snapshots are written in 128-bit (8 word) aligned slots
+    #define NN_SNAPSHOT_SLOT_SIZE   ((sizeof(NNSnapshotHeader) + sizeof(NeuralNetwork) + 7) & ~7UL)
+    #define NN_SNAPSHOT_SLOTS       (NN_SNAPSHOT_SECTOR_SIZE / NN_SNAPSHOT_SLOT_SIZE)
+
+    /**
+     * @brief Snapshot status
+     */
+    typedef struct {
+        uint32_t address;           // Last good snapshot, 0 if none
+        uint32_t sequence;          // Sequence of the last good snapshot
+        uint16_t loaded;            // Weights restored from flash at the last init
+        uint16_t saves;
+        uint16_t errors;            // Flash API or verification errors
+        uint32_t save_cycles;       // Duration of the last save
+    } NNSnapshotStatus;
+
+    extern NNSnapshotStatus nn_snapshot_status;
+
+    // Snapshot functions
+    void nn_snapshot_init(void);
+    uint16_t nn_snapshot_load(NeuralNetwork *network);
+    uint16_t nn_snapshot_save(const NeuralNetwork *network);
+    void nn_snapshot_periodic(uint32_t elapsed_ms);
+
+#endif /* NN_SNAPSHOT_H */
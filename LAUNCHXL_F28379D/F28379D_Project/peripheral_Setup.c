@@ -6,9 +6,28 @@
  */
 
 #include "peripheral_Setup.h"
+#include "controllers.h"
+#include "waveform.h"
+#include "timebase.h"
+#include "profile.h"
+#include "cla_control.h"
+#include "adc_dma.h"
+#include "adc_burst.h"
+#include "adc_channels.h"
+#include "measurement_stats.h"
 
 // Global variables
-Int_Vect int_vectors = { { {grupo_1, interrupt_7} } };
+Int_Vect int_vectors = { {
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    {grupo_11, interrupt_1},    // CLA1 Task 1 end
+#elif (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    {grupo_7, interrupt_1},     // DMA CH1 transfer start
+#else
+    {grupo_1, interrupt_3},     // ADCC1
+#endif
+    {grupo_8, interrupt_6},     // SCIC TX
+    {grupo_8, interrupt_3}      // I2CB
+} };
 
 MEDIDA medidasADC;
 uint16_t i2c_status = 0;
@@ -28,6 +47,8 @@ char system_state = OFF;
 
 
 SetpointFilter setpoint_filter = {
+    .raw = 0,
+    .sample = 0.0f,
     .pos = 0,
     .values = {0.0f},
     .setpoint = 0.0f
@@ -39,20 +60,89 @@ InputMonitor input_monitor = {
     .voltage = 0.0f
 };
 
+AcquisitionStats acquisition_stats = {0};
+MeasurementSnapshot measurement_snapshot = {0};
+
+UartTxRing uart_tx_ring = {0};
+UartTxStats uart_tx_stats = {0};
+
+uint32_t uart_baud = SCI_FREQ;
+
+I2cTransfer i2c_transfer = {0};
+RtcStats rtc_stats = {0};
+
 /**
- * @brief Timer 0 interrupt service routine
- * Handles ADC reading, button monitoring, and setpoint calculation
+ * @brief Cycles elapsed since the conversion trigger
+ *        Timer0 counts down from PRD at SYSCLK; the EPWM1 up-down carrier
+ *        counts at TBCLK = SYSCLK / 2 and triggers at zero or period
+ * @return Elapsed SYSCLK cycles
  */
-interrupt void timer0_isr(void) {
-    ServiceDog();
+static inline uint32_t cycles_since_trigger(void) {
+#if (ADC_TRIGGER_SOURCE == ADC_TRIGGER_EPWM1_SOCA)
+    if (EPwm1Regs.TBSTS.bit.CTRDIR)
+        return 2UL * EPwm1Regs.TBCTR;
+
+    return 2UL * (EPwm1Regs.TBPRD - EPwm1Regs.TBCTR);
+#else
+    return CpuTimer0Regs.PRD.all - CpuTimer0Regs.TIM.all;
+#endif
+}
+
+/**
+ * @brief Publish the measurements of this conversion (measurement_snapshot)
+ *        Called by adcc1_isr once acquisition_step has applied the filter
+ *        and the safety limit, so readers never see them half done
+ * @param timestamp Timebase at the trigger of the conversion (us)
+ * @return void
+ */
+static inline void measurement_publish(uint32_t timestamp) {
+    Measurements measurements;
+
+    measurements.sample = acquisition_stats.samples;
+    measurements.timestamp = timestamp;
+    measurements.setpoint_code = setpoint_filter.raw;
+    measurements.voltage_code = medidasADC.leituras_dig[Tensao_DC];
+    measurements.current_code = medidasADC.leituras_dig[Corrente_carga];
+    measurements.input_code = input_monitor.raw;
+    measurements.setpoint = setpoint_filter.setpoint;
+    measurements.voltage = medidasADC.valor_real[Tensao_DC];
+    measurements.current = medidasADC.valor_real[Corrente_carga];
+    measurements.input_voltage = input_monitor.voltage;
+    measurements.system_state = system_state;
+
+    measurement_snapshot.sequence++;
+    measurement_snapshot.data = measurements;
+    measurement_snapshot.sequence++;
+
+    return;
+}
+
+/**
+ * @brief Hand the setpoint, input voltage and state to the CLA task for
+ *        the next conversion (CONTROL_LOOP_CLA)
+ *        The CLA task has ended before adcc1_isr runs, so the message RAM
+ *        is never written while the CLA reads it
+ * @return void
+ */
+static inline void cla_control_feed(void) {
+    cla_control_input.setpoint = setpoint_filter.setpoint;
+    cla_control_input.input_voltage = input_monitor.voltage;
+    cla_control_input.run = system_state;
+
+    duty_cycle = cla_control_output.duty;
 
+    return;
+}
+
+/**
+ * @brief Acquisition step executed on every ADC completion
+ *        Handles button monitoring and setpoint calculation, from the
+ *        results adc_channels_sample has written
+ */
+static inline void acquisition_step(void) {
     static const int filter_size = sizeof(setpoint_filter.values) / sizeof(setpoint_filter.values[0]);
     int index;
 
-    // Wait for ADC completion
-    while (!AdccRegs.ADCINTFLG.bit.ADCINT1);
-    AdccRegs.ADCINTFLGCLR.bit.ADCINT1 = 1;
-
     // Button monitoring
     if (!GpioDataRegs.GPCDAT.bit.GPIO67)
         system_state = ON;
@@ -63,23 +153,19 @@ interrupt void timer0_isr(void) {
         system_state = OFF;
     }
 
-    // ADC data processing
-    if (system_state) {
-        medidasADC.leituras_dig[Tensao_DC] = AdcbResultRegs.ADCRESULT0;
-        medidasADC.valor_real[Tensao_DC] = medidasADC.leituras_dig[Tensao_DC] * VOLTAGE_CONVERSION_FACTOR;
-
-        medidasADC.leituras_dig[Corrente_carga] = AdccResultRegs.ADCRESULT0;
-        medidasADC.valor_real[Corrente_carga] = medidasADC.leituras_dig[Corrente_carga] * CURRENT_CONVERSION_FACTOR;
-    }
-
-    // Input voltage monitoring
-    input_monitor.raw = AdcbResultRegs.ADCRESULT1;
-    input_monitor.voltage = (input_monitor.raw * input_monitor.conv_factor);
+    // MEDIDA, input_monitor and the setpoint sample are written by
+    // adc_channels_sample. valor_real keeps the bits the oversampling adds,
+    // leituras_dig is the 12-bit average
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    // The values the CLA task controlled on
+    medidasADC.valor_real[Tensao_DC] = cla_control_output.voltage;
+    medidasADC.valor_real[Corrente_carga] = cla_control_output.current;
+#endif
 
     // Setpoint calculation with rolling average
     setpoint_filter.setpoint -= setpoint_filter.values[setpoint_filter.pos];
 
-    setpoint_filter.values[setpoint_filter.pos] = ((AdcaResultRegs.ADCRESULT0 / MAX_ADC) * MAX_VOLTAGE) / filter_size;
+    setpoint_filter.values[setpoint_filter.pos] = setpoint_filter.sample / filter_size;
     setpoint_filter.setpoint += setpoint_filter.values[setpoint_filter.pos];
 
     setpoint_filter.pos = (setpoint_filter.pos + 1) % filter_size;
@@ -92,7 +178,171 @@ interrupt void timer0_isr(void) {
             setpoint_filter.values[index] = input_monitor.voltage / filter_size;
     }
 
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP1;
+    return;
+}
+
+/**
+ * @brief ADCC interrupt 1 service routine
+ *        Entered on ADC completion, so results are read without waiting.
+ *        With CONTROL_LOOP_ISR the control law also runs here: sample,
+ *        convert, compute, clamp and write CMPA in a single pass.
+ *        With CONTROL_LOOP_CLA it is entered at the end of CLA Task 1,
+ *        which has already written CMPA, and takes the scaled values from it.
+ *        With ADC_ACQUISITION_DMA it is entered at the start of every DMA
+ *        CH1 transfer, once per carrier period, and takes the Tensao_DC
+ *        block of the previous period (adc_dma_block).
+ *        With ADC_ACQUISITION_BURST it is entered at the end of the
+ *        Corrente_carga burst.
+ *        Every channel of the table is averaged and scaled first
+ *        (adc_channels_sample).
+ *        With ADC_NOISE_CHARACTERIZATION the codes of every channel are
+ *        accumulated for the noise statistics (adc_noise_step).
+ *        With WAVEFORM_STREAM_ENABLED the sample is also recorded for streaming.
+ *        The MEDIDA codes feed the streaming statistics (measurement_stats).
+ *        The measurements are published to the tasks in measurement_snapshot.
+ */
+interrupt void adcc1_isr(void) {
+    uint32_t isr_start = read_cycle_counter();
+    uint32_t wait_cycles = cycles_since_trigger();
+    uint32_t trigger_time = timebase_now_us32() - wait_cycles / (uint32_t)(CPU_FREQ / TIMEBASE_FREQ);
+
+    profile_begin(PROFILE_ADC_ISR);
+
+    ServiceDog();
+
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    adc_dma_block();
+#endif
+
+    adc_channels_sample();
+
+#ifdef ADC_NOISE_CHARACTERIZATION
+    adc_noise_step();
+#endif
+
+    acquisition_step();
+    measurement_stats_update(&medidasADC);
+    measurement_publish(trigger_time);
+
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_ISR)
+    controller_step();
+#elif (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    cla_control_feed();
+#endif
+
+#if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED)
+    waveform_capture();
+#endif
+
+    // A conversion completed while the previous one was still pending
+    if (AdccRegs.ADCINTOVF.bit.ADCINT1) {
+        AdccRegs.ADCINTOVFCLR.bit.ADCINT1 = 1;
+        acquisition_stats.missed_samples++;
+    }
+
+    AdccRegs.ADCINTFLGCLR.bit.ADCINT1 = 1;
+
+    // Instrumentation
+    acquisition_stats.samples++;
+
+    acquisition_stats.timestamp = trigger_time;
+    acquisition_stats.wait_cycles = wait_cycles;
+    if (wait_cycles > acquisition_stats.wait_cycles_max)
+        acquisition_stats.wait_cycles_max = wait_cycles;
+
+    acquisition_stats.isr_cycles = read_cycle_counter() - isr_start;
+    if (acquisition_stats.isr_cycles > acquisition_stats.isr_cycles_max)
+        acquisition_stats.isr_cycles_max = acquisition_stats.isr_cycles;
+
+    profile_end(PROFILE_ADC_ISR);
+
+    if (measurement_snapshot.notify != NULL)
+        measurement_snapshot.notify();
+
+    PieCtrlRegs.PIEACK.all = ADC_ISR_PIEACK;
+}
+
+/**
+ * @brief SCIC transmit FIFO interrupt service routine
+ *        Entered while the TX FIFO holds UART_TX_FIFO_LEVEL characters or
+ *        fewer; refills it from uart_tx_ring and disables itself once the
+ *        ring is empty (uart_send_char enables it again)
+ */
+interrupt void scic_tx_isr(void) {
+    uint16_t tail = uart_tx_ring.tail;
+
+    while ((tail != uart_tx_ring.head) && (ScicRegs.SCIFFTX.bit.TXFFST < UART_TX_FIFO_DEPTH)) {
+        ScicRegs.SCITXBUF.all = uart_tx_ring.buffer[tail];
+        tail = (tail + 1) & (UART_TX_BUFFER_SIZE - 1);
+    }
+
+    uart_tx_ring.tail = tail;
+
+    if (tail == uart_tx_ring.head)
+        ScicRegs.SCIFFTX.bit.TXFFIENA = 0;
+
+    ScicRegs.SCIFFTX.bit.TXFFINTCLR = 1;
+
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP8;
+}
+
+/**
+ * @brief I2C-B interrupt, advances the DS3231 burst read
+ *        ARDY after the register pointer: repeated start as receiver for
+ *        DS3231_BURST_SIZE bytes with stop. SCD: the bytes are in the RX
+ *        FIFO, the transfer is complete. NACK or arbitration loss: stop
+ *        and complete with the error once the stop is on the bus.
+ */
+interrupt void i2cb_isr(void) {
+    uint32_t start = read_cycle_counter();
+    uint16_t done = 0, x;
+
+    switch (I2cbRegs.I2CISRC.bit.INTCODE) {
+        case I2C_ARDY_ISRC:
+            I2cbRegs.I2CSTR.all = I2C_CLR_ARDY_BIT;
+
+            if (i2c_transfer.state == I2C_TRANSFER_ADDRESS) {
+                I2cbRegs.I2CCNT = DS3231_BURST_SIZE;
+                I2cbRegs.I2CMDR.all = 0x2C20;           // Restart as master receiver with stop
+                i2c_transfer.state = I2C_TRANSFER_DATA;
+            }
+            break;
+
+        case I2C_NACK_ISRC:
+        case I2C_ARB_ISRC:
+            I2cbRegs.I2CSTR.all = I2C_CLR_NACK_BIT | I2C_CLR_AL_BIT;
+            I2cbRegs.I2CMDR.bit.STP = 1;
+
+            i2c_transfer.status = I2C_NACK_ERROR;
+            i2c_transfer.state = I2C_TRANSFER_STOP;
+            break;
+
+        case I2C_SCD_ISRC:
+            if (i2c_transfer.state == I2C_TRANSFER_DATA) {
+                if (I2cbRegs.I2CFFRX.bit.RXFFST >= DS3231_BURST_SIZE) {
+                    for (x = 0; x < DS3231_BURST_SIZE; x++)
+                        i2c_transfer.data[x] = I2cbRegs.I2CDRR.all;
+
+                    i2c_transfer.status = I2C_SUCCESS;
+                }
+                else
+                    i2c_transfer.status = I2C_ERROR;
+            }
+
+            done = (i2c_transfer.state != I2C_TRANSFER_IDLE);
+            i2c_transfer.state = I2C_TRANSFER_IDLE;
+            break;
+
+        default:
+            break;
+    }
+
+    i2c_transfer.isr_cycles += read_cycle_counter() - start;
+
+    if (done && i2c_transfer.complete)
+        i2c_transfer.complete();
+
+    PieCtrlRegs.PIEACK.all = PIEACK_GROUP8;
 }
 
 /**
@@ -103,10 +353,10 @@ void gpio_init(void) {
     InitGpio();
 
     // Status LEDs (active low)
-    ConfigGPIO(31, SAIDA, NULL, NULL, NULL, NULL, NULL);
+    ConfigGPIO(31, SAIDA, 0, 0, 0, 0, 0);
     GpioDataRegs.GPASET.bit.GPIO31 = 1;
 
-    ConfigGPIO(34, SAIDA, NULL, NULL, NULL, NULL, NULL);
+    ConfigGPIO(34, SAIDA, 0, 0, 0, 0, 0);
     GpioDataRegs.GPBSET.bit.GPIO34 = 1;
 
     // Buttons (with pull-up)
@@ -118,24 +368,40 @@ void gpio_init(void) {
 
 /**
  * @brief Initialize ADC modules
+ *        Every channel gets its own acquisition window (ADC_ACQPS_*).
+ *        Tensao_DC and Corrente_carga take ADC_BURST_SIZE SOCs from SOC0,
+ *        one unless ADC_ACQUISITION_BURST; the input voltage follows them
+ *        on ADCB. ADCINT1 is set at the last Corrente_carga EOC
  */
 void adc_init(void) {
     InitADC();
 
-    SetupADC(CONV_ADC_A, ADCIN2, RESULT0, TRIG_CPU1_TIMER0, ADC_INT_OFF, INT_OFF);  // Setpoint
-    SetupADC(CONV_ADC_B, ADCIN2, RESULT1, TRIG_CPU1_TIMER0, ADC_INT_OFF, INT_OFF);  // Input voltage
-    SetupADC(CONV_ADC_B, ADCIN3, RESULT0, TRIG_CPU1_TIMER0, ADC_INT_OFF, INT_OFF);  // Voltage
-    SetupADC(CONV_ADC_C, ADCIN3, RESULT0, TRIG_CPU1_TIMER0, ADC_INT1, INT_EOC0);    // Current
+    // ADC, channel, first SOC, SOCs, trigger, acquisition window, interrupt
+    adc_channel_setup(CONV_ADC_A, ADCIN2, RESULT0, 1, ADC_SOC_TRIGGER, ADC_ACQPS_SETPOINT, ADC_INT_OFF);                       // Setpoint
+    adc_channel_setup(CONV_ADC_B, ADCIN2, (Resultados_ADC)ADC_INPUT_SOC, 1, ADC_SOC_TRIGGER, ADC_ACQPS_INPUT, ADC_INT_OFF);    // Input voltage
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    adc_channel_setup(CONV_ADC_B, ADCIN3, RESULT0, 1, TRIG_EPWM2_ADCSOCA, ADC_ACQPS_VOLTAGE, ADC_INT2);                        // Voltage, DMA CH1 (adc_dma_init)
+#else
+    adc_channel_setup(CONV_ADC_B, ADCIN3, RESULT0, ADC_BURST_SIZE, ADC_SOC_TRIGGER, ADC_ACQPS_VOLTAGE, ADC_INT_OFF);           // Voltage
+#endif
+    adc_channel_setup(CONV_ADC_C, ADCIN3, RESULT0, ADC_BURST_SIZE, ADC_SOC_TRIGGER, ADC_ACQPS_CURRENT, ADC_INT1);              // Current
 
     InitMedidas(&medidasADC);
-    medidasADC.tipo[Tensao_DC] = DC;
-    medidasADC.tipo[Corrente_carga] = AC;
+    medidasADC.tipo[Tensao_DC] = adc_channel_coupling[ADC_CHANNEL_VOLTAGE];
+    medidasADC.tipo[Corrente_carga] = adc_channel_coupling[ADC_CHANNEL_CURRENT];
+
+    measurement_stats_init();
 
     return;
 }
 
 /**
  * @brief Initialize PWM module for 20kHz switching
+ *        With ADC_TRIGGER_EPWM1_SOCA, EPWM1 also starts the ADC conversions
+ *        aligned to the carrier. With ADC_ACQUISITION_DMA, EPWM2 runs
+ *        ADC_DMA_OVERSAMPLING times faster, synchronized at the carrier
+ *        zero, and starts the Tensao_DC conversions at its period, half a
+ *        sample into each slot
  */
 void pwm_init(void) {
     StartEPWMConfig();
@@ -143,6 +409,16 @@ void pwm_init(void) {
     ConfigEPwm_REF(EPWM1, ePWM_HSPCLKDIV_1, ePWM_CLKDIV_1, 20000);
     pwm_factor = DutyCycle(ePWM_HSPCLKDIV_1, ePWM_CLKDIV_1, 20000);
 
+#if (ADC_TRIGGER_SOURCE == ADC_TRIGGER_EPWM1_SOCA)
+    ConfigSocPWM(EPWM1, ADC_SOCA_EVENT, ADC_SOCA_PRESCALE);
+#endif
+
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    ConfigEPwm_REF(EPWM2, ePWM_HSPCLKDIV_1, ePWM_CLKDIV_1, 20000);
+    EPwm2Regs.TBPRD = pwm_factor >> ADC_DMA_SHIFT;
+    ConfigSocPWM(EPWM2, SOC_CTR_PRD, 1);
+#endif
+
     ConfigSyncPWMs();
     InitEPwmGpio();
     EndEPWMConfig();
@@ -171,7 +447,8 @@ void dac_init(void) {
 }
 
 /**
- * @brief Initialize UART communication (9600 baud)
+ * @brief Initialize UART communication (SCI_FREQ baud)
+ *        With UART_TX_INTERRUPT, transmission is driven by scic_tx_isr
  */
 void uart_init(void) {
     EALLOW;
@@ -192,6 +469,9 @@ void uart_init(void) {
         GpioCtrlRegs.GPEDIR.bit.GPIO139 = 0;
         GpioCtrlRegs.GPEQSEL1.bit.GPIO139 = 3;
 
+        // LSPCLK = SYSCLK / 1 (see LSPCLK_DIV_SEL)
+        ClkCfgRegs.LOSPCP.bit.LSPCLKDIV = LSPCLK_DIV_SEL;
+
         // Enable SCI_C peripheral clock
         CpuSysRegs.PCLKCR7.bit.SCI_C = 1;
 
@@ -212,13 +492,12 @@ void uart_init(void) {
     ScicRegs.SCICTL2.bit.TXINTENA = 0;
     ScicRegs.SCICTL2.bit.RXBKINTENA = 0;
 
-    // SCIC at 9600 baud
-    // @LSPCLK = 50 MHz (200 MHz SYSCLK) HBAUD = 0x02 and LBAUD = 0x8B.
-    ScicRegs.SCIHBAUD.all = 0x02;
-    ScicRegs.SCILBAUD.all = 0x8B;
+    // SCIC at SCI_FREQ baud, raised later by the link negotiation
+    uart_set_baud(SCI_FREQ);
 
     // Initialize the SCI FIFO
-    ScicRegs.SCIFFTX.all = 0xC022;
+    // TX FIFO interrupt level UART_TX_FIFO_LEVEL, enabled by uart_send_char
+    ScicRegs.SCIFFTX.all = 0xC000 | UART_TX_FIFO_LEVEL;
     ScicRegs.SCIFFRX.all = 0x0028;
     ScicRegs.SCIFFCT.all = 0x0000;
 
@@ -230,6 +509,47 @@ void uart_init(void) {
     return;
 }
 
+/**
+ * @brief Error of the closest rate SCI-C can generate
+ *        Baud = LSPCLK / ((BRR + 1) * 8)
+ * @param baud Requested rate
+ * @return uint16_t Rate error (per mille), UART_BAUD_INVALID when above
+ *         SCI_BAUD_MAX or SCI_BAUD_TOLERANCE
+ */
+uint16_t uart_baud_error(uint32_t baud) {
+    uint32_t divisor, actual, error;
+
+    if ((baud == 0) || (baud > SCI_BAUD_MAX))
+        return UART_BAUD_INVALID;
+
+    // BRR + 1, rounded to the nearest rate
+    divisor = ((uint32_t)LSPCLK_FREQ + 4 * baud) / (8 * baud);
+    if ((divisor < 2) || (divisor > 65536UL))
+        return UART_BAUD_INVALID;
+
+    actual = (uint32_t)LSPCLK_FREQ / (8 * divisor);
+    error = ((actual > baud) ? (actual - baud) : (baud - actual)) * 1000 / baud;
+
+    return (error > SCI_BAUD_TOLERANCE) ? UART_BAUD_INVALID : (uint16_t)error;
+}
+
+/**
+ * @brief Set the SCI-C rate
+ *        Call with the transmitter idle, a character in flight is corrupted
+ * @param baud Rate accepted by uart_baud_error
+ * @return void
+ */
+void uart_set_baud(uint32_t baud) {
+    uint32_t divisor = ((uint32_t)LSPCLK_FREQ + 4 * baud) / (8 * baud);
+
+    ScicRegs.SCIHBAUD.all = (uint16_t)((divisor - 1) >> 8);
+    ScicRegs.SCILBAUD.all = (uint16_t)((divisor - 1) & 0xFF);
+
+    uart_baud = baud;
+
+    return;
+}
+
 /**
  * @brief Initialize SPI module
  */
@@ -269,12 +589,12 @@ void i2c_init(void) {
 
     // I2C Module Configuration
     // Set prescaler for 7-12MHz module clock
-    I2cbRegs.I2CPSC.all = 6;                    // (200MHz / (6+1)) = ~28.6MHz, need to reduce further
+    I2cbRegs.I2CPSC.all = 19;                   // 200MHz / (19+1) = 10MHz
 
-    // Set clock dividers for ~100kHz I2C clock
+    // Set clock dividers for 400kHz I2C clock (DS3231 fast mode)
     // I2C_CLK = Module_CLK / ((CLKL + d) + (CLKH + d)) where d=5 for prescaler >= 1
-    I2cbRegs.I2CCLKL = 10;                      // Low period
-    I2cbRegs.I2CCLKH = 5;                       // High period
+    I2cbRegs.I2CCLKL = 10;                      // Low period, 1.5us
+    I2cbRegs.I2CCLKH = 5;                       // High period, 1.0us
 
     // Disable all interrupts initially
     I2cbRegs.I2CIER.all = 0x0000;
@@ -296,7 +616,129 @@ void i2c_init(void) {
 }
 
 /**
- * @brief Initialize interrupt system and Timer0 (50ms period)
+ * @brief Start the burst read of the DS3231 time registers
+ *        Writes the register pointer (DS3231_REG_SECONDS) and returns;
+ *        i2cb_isr reads seconds, minutes and hours, the pointer
+ *        auto-incrementing, and calls complete()
+ * @param complete Called from i2cb_isr when the transfer has ended
+ * @return I2C_SUCCESS if started, error code otherwise
+ */
+uint16_t ds3231_read_time_start(void (*complete)(void)) {
+    uint16_t status;
+
+    if (i2c_transfer.state != I2C_TRANSFER_IDLE)
+        return I2C_BUS_BUSY_ERROR;
+
+    status = i2c_wait_bus_ready();
+    if (status != I2C_SUCCESS)
+        return status;
+
+    i2c_transfer.status = I2C_ERROR;
+    i2c_transfer.isr_cycles = 0;
+    i2c_transfer.complete = complete;
+    i2c_transfer.state = I2C_TRANSFER_ADDRESS;
+
+    // Stale flags and bytes of a previous transfer
+    I2cbRegs.I2CSTR.all = I2C_CLR_AL_BIT | I2C_CLR_NACK_BIT | I2C_CLR_ARDY_BIT | I2C_CLR_SCD_BIT;
+    I2cbRegs.I2CFFRX.bit.RXFFRST = 0;
+    I2cbRegs.I2CFFRX.bit.RXFFRST = 1;
+
+    I2cbRegs.I2CIER.all = 0x0027;               // SCD, ARDY, NACK, ARBL
+
+    I2cbRegs.I2CSAR.all = DS3231_I2C_ADDR;
+    I2cbRegs.I2CCNT = 1;
+    I2cbRegs.I2CDXR.all = DS3231_REG_SECONDS;
+
+    // Start condition, master transmitter, no stop
+    I2cbRegs.I2CMDR.all = 0x2620;
+
+    return I2C_SUCCESS;
+}
+
+/**
+ * @brief Time read by the last burst read
+ * @param hours Pointer to store hours (BCD)
+ * @param minutes Pointer to store minutes (BCD)
+ * @param seconds Pointer to store seconds (BCD)
+ * @return I2C_SUCCESS if the read completed, error code otherwise
+ */
+uint16_t ds3231_read_time_result(Uint16* hours, Uint16* minutes, Uint16* seconds) {
+    if (i2c_transfer.state != I2C_TRANSFER_IDLE)
+        return I2C_BUS_BUSY_ERROR;
+
+    if (i2c_transfer.status != I2C_SUCCESS)
+        return i2c_transfer.status;
+
+    *seconds = i2c_transfer.data[0];
+    *minutes = i2c_transfer.data[1];
+    *hours = i2c_transfer.data[2];
+
+    return I2C_SUCCESS;
+}
+
+/**
+ * @brief Abandon a transfer that did not complete
+ *        Resets the module (the clock setup is kept) and the FIFOs
+ */
+void i2c_abort(void) {
+    I2cbRegs.I2CIER.all = 0x0000;
+
+    I2cbRegs.I2CMDR.bit.IRS = 0;
+    I2cbRegs.I2CFFTX.bit.TXFFRST = 0;
+    I2cbRegs.I2CFFRX.bit.RXFFRST = 0;
+
+    I2cbRegs.I2CMDR.all = 0x0020;
+    I2cbRegs.I2CFFTX.bit.TXFFRST = 1;
+    I2cbRegs.I2CFFRX.bit.RXFFRST = 1;
+
+    i2c_transfer.status = I2C_TIMEOUT_ERROR;
+    i2c_transfer.state = I2C_TRANSFER_IDLE;
+
+    return;
+}
+
+/**
+ * @brief Initialize CLA1 for CONTROL_LOOP_CLA
+ *        LS4 holds the CLA program and LS3 its data (2837xD_RAM_lnk_cpu1.cmd).
+ *        Task 1 is started by ADCC ADCINT1, its end of task interrupt
+ *        (CLA1_1) enters adcc1_isr. Called after pwm_init
+ */
+void cla_init(void) {
+    EALLOW;
+        // Clear the message RAMs
+        MemCfgRegs.MSGxINIT.bit.INIT_CPUTOCLA1 = 1;
+        while (!MemCfgRegs.MSGxINITDONE.bit.INITDONE_CPUTOCLA1);
+        MemCfgRegs.MSGxINIT.bit.INIT_CLA1TOCPU = 1;
+        while (!MemCfgRegs.MSGxINITDONE.bit.INITDONE_CLA1TOCPU);
+
+        // LS4: CLA program, LS3: CLA data shared with the CPU
+        MemCfgRegs.LSxMSEL.bit.MSEL_LS4 = 1;
+        MemCfgRegs.LSxCLAPGM.bit.CLAPGM_LS4 = 1;
+        MemCfgRegs.LSxMSEL.bit.MSEL_LS3 = 1;
+        MemCfgRegs.LSxCLAPGM.bit.CLAPGM_LS3 = 0;
+
+        CpuSysRegs.PCLKCR0.bit.CLA1 = 1;
+    EDIS;
+
+    cla_control_load();
+
+    EALLOW;
+        // CLA program addresses fit in 16 bits (LS4)
+        Cla1Regs.MVECT1 = (uint16_t)(uintptr_t)&Cla1Task1;
+        DmaClaSrcSelRegs.CLA1TASKSRCSEL1.bit.TASK1 = CLA_TRIG_ADCCINT1;
+        Cla1Regs.MIER.all = M_INT1;
+    EDIS;
+
+    return;
+}
+
+/**
+ * @brief Initialize interrupt system, Timer0 (50us period) and the
+ *        Timer1 timebase
+ *        Timer0 is only started when it triggers the ADC SOCs
+ *        (ADC_TRIGGER_TIMER0); acquisition runs from the ADCC1 interrupt,
+ *        from the CLA1_1 interrupt with CONTROL_LOOP_CLA, or from the
+ *        DMA_CH1 interrupt with ADC_ACQUISITION_DMA
  */
 void interrupt_init(void) {
     InitPieCtrl();
@@ -305,13 +747,38 @@ void interrupt_init(void) {
     InitPieVectTable();
 
     EALLOW;
-        PieVectTable.TIMER0_INT = &timer0_isr;
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+        PieVectTable.CLA1_1_INT = &adcc1_isr;
+#elif (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+        PieVectTable.DMA_CH1_INT = &adcc1_isr;
+#else
+        PieVectTable.ADCC1_INT = &adcc1_isr;
+#endif
+        PieVectTable.SCIC_TX_INT = &scic_tx_isr;
+        PieVectTable.I2CB_INT = &i2cb_isr;
+        PieVectTable.TIMER1_INT = &timer1_isr;
     EDIS;
 
     InitCpuTimers();
     ConfigCpuTimer(&CpuTimer0, 100, 50);
+
+    // Timebase, Timer1 interrupt goes straight to INT13 (no PIE group)
+    timebase_init();
+    IER |= M_INT13;
+
+    profile_init(PROFILE_ADC_ISR, ADC_SAMPLE_PERIOD, 10, 6);
+
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    IER |= M_INT11;
+#elif (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    IER |= M_INT7;
+#endif
+
     ConfigInterrupt(int_vectors);
+
+#if (ADC_TRIGGER_SOURCE == ADC_TRIGGER_TIMER0)
     StartCpuTimer0();
+#endif
 
     return;
 }
@@ -323,6 +790,15 @@ void peripheral_Setup(void) {
     gpio_init();
     adc_init();
     pwm_init();
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    adc_dma_init();
+#endif
+#ifdef CLA_ERROR_CHECK
+    controller_cla_error_check();
+#endif
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    cla_init();
+#endif
     watchdog_init();
     dac_init();
     uart_init();
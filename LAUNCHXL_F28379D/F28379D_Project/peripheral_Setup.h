@@ -46,13 +46,140 @@
     #define SIZE_ADC_READINGS           10
 
     #define CPU_FREQ                    200E6
-    #define LSPCLK_FREQ                 (CPU_FREQ/4)
-    #define SCI_FREQ                    9600
-    #define SCI_PRD                     ((LSPCLK_FREQ/(SCI_FREQ*8))-1)
+
+    // Low-speed peripheral clock (SCI-C): SYSCLK / 1 keeps every standard rate
+    // up to 921600 baud within 0.5 % (at the reset value, /4, 921600 is 3 % off)
+    #define LSPCLK_DIV_SEL              0       // LOSPCP.LSPCLKDIV: 0 = /1, 1 = /2, 2 = /4
+    #define LSPCLK_FREQ                 (CPU_FREQ/1)
+
+    // Waveform streaming (waveform.c)
+    //  WAVEFORM_STREAM_DISABLED: SCI-C carries the telemetry of communication_task only
+    //  WAVEFORM_STREAM_ENABLED:  adcc1_isr also records every sample and waveform_task
+    //                            streams them, SCI-C runs at the higher rate
+    #define WAVEFORM_STREAM_DISABLED    0
+    #define WAVEFORM_STREAM_ENABLED     1
+    #define WAVEFORM_STREAM_MODE        WAVEFORM_STREAM_DISABLED
+
+    // SCI-C rate at power-up, and the rate the link falls back to when a
+    // faster one fails (uart_link.c). The BeagleBone monitor starts at the
+    // same rate: build it with the waveform_stream feature for 230400
+    #if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED)
+        #define SCI_FREQ                230400
+    #else
+        #define SCI_FREQ                9600
+    #endif
+
+    #define SCI_BAUD_MAX                921600
+    #define SCI_BAUD_TOLERANCE          20      // Largest rate error accepted (per mille)
+    #define UART_BAUD_INVALID           0xFFFF
 
     #define ON                          1
     #define OFF                         0
 
+    // Control loop execution mode
+    //  CONTROL_LOOP_TASK: control_task runs the controller from the latest samples
+    //  CONTROL_LOOP_ISR:  adcc1_isr also computes and writes CMPA every conversion
+    //  CONTROL_LOOP_CLA:  CLA Task 1 scales, runs the PI and writes CMPA every conversion
+    //                     (cla_control.h), adcc1_isr follows at its end of task
+    #define CONTROL_LOOP_TASK           0
+    #define CONTROL_LOOP_ISR            1
+    #define CONTROL_LOOP_CLA            2
+    #define CONTROL_LOOP_MODE           CONTROL_LOOP_ISR
+
+    // ADC acquisition mode
+    //  ADC_ACQUISITION_SINGLE: adcc1_isr reads one conversion of every channel per carrier period
+    //  ADC_ACQUISITION_DMA:    Tensao_DC is converted ADC_DMA_OVERSAMPLING times per carrier
+    //                          period and moved by DMA CH1 (adc_dma.h), adcc1_isr takes the
+    //                          block average at the start of the next block
+    //  ADC_ACQUISITION_BURST:  Tensao_DC and Corrente_carga take ADC_BURST_SIZE consecutive SOCs
+    //                          each per conversion (adc_burst.h), adcc1_isr sums the results
+    //                          at the end of the Corrente_carga burst
+    #define ADC_ACQUISITION_SINGLE      0
+    #define ADC_ACQUISITION_DMA         1
+    #define ADC_ACQUISITION_BURST       2
+    #define ADC_ACQUISITION_MODE        ADC_ACQUISITION_SINGLE
+
+    #if (ADC_ACQUISITION_MODE != ADC_ACQUISITION_SINGLE) && (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+        #error "CONTROL_LOOP_CLA reads one result register per channel, use ADC_ACQUISITION_SINGLE"
+    #endif
+
+    // ADC acquisition window of every channel (ACQPS, the window is ACQPS + 1
+    // SYSCLK cycles), long enough for the source impedance to settle the
+    // sample-and-hold. ADC_ACQPS_MIN (75 ns) is the 12-bit minimum
+    #define ADC_ACQPS_MIN               14
+    #define ADC_ACQPS_SETPOINT          14
+    #define ADC_ACQPS_INPUT             14
+    #define ADC_ACQPS_VOLTAGE           14
+    #define ADC_ACQPS_CURRENT           14
+
+    #if (ADC_ACQPS_SETPOINT < ADC_ACQPS_MIN) || (ADC_ACQPS_INPUT < ADC_ACQPS_MIN) || \
+        (ADC_ACQPS_VOLTAGE < ADC_ACQPS_MIN) || (ADC_ACQPS_CURRENT < ADC_ACQPS_MIN)
+        #error "ADC acquisition window below the 12-bit minimum"
+    #endif
+
+    // adcc1_isr follows the last Corrente_carga conversion, the Tensao_DC ones
+    // on ADCB must not end later
+    #if (ADC_ACQUISITION_MODE != ADC_ACQUISITION_DMA) && (ADC_ACQPS_VOLTAGE > ADC_ACQPS_CURRENT)
+        #error "ADC_ACQPS_VOLTAGE longer than ADC_ACQPS_CURRENT, Tensao_DC ends after adcc1_isr"
+    #endif
+
+    // adcc1_isr is entered from ADCC1 (PIE group 1), from CLA1_1 (group 11) with
+    // CONTROL_LOOP_CLA, or from DMA_CH1 (group 7) with ADC_ACQUISITION_DMA
+    #if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+        #define ADC_ISR_PIEACK          PIEACK_GROUP11
+    #elif (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+        #define ADC_ISR_PIEACK          PIEACK_GROUP7
+    #else
+        #define ADC_ISR_PIEACK          PIEACK_GROUP1
+    #endif
+
+    // ADC start-of-conversion source
+    //  ADC_TRIGGER_TIMER0:     free-running CPU Timer0 (50 us), not synchronized to the carrier
+    //  ADC_TRIGGER_EPWM1_SOCA: EPWM1 SOCA at ADC_SOCA_EVENT, every ADC_SOCA_PRESCALE events
+    #define ADC_TRIGGER_TIMER0          0
+    #define ADC_TRIGGER_EPWM1_SOCA      1
+    #define ADC_TRIGGER_SOURCE          ADC_TRIGGER_EPWM1_SOCA
+
+    #define ADC_SOCA_EVENT              SOC_CTR_ZERO
+    #define ADC_SOCA_PRESCALE           1
+
+    #if (ADC_TRIGGER_SOURCE == ADC_TRIGGER_EPWM1_SOCA)
+        #define ADC_SOC_TRIGGER         TRIG_EPWM1_ADCSOCA
+        #define ADC_SAMPLE_PERIOD       (50 * ADC_SOCA_PRESCALE)    // us, 20 kHz carrier
+    #else
+        #define ADC_SOC_TRIGGER         TRIG_CPU1_TIMER0
+        #define ADC_SAMPLE_PERIOD       50                          // us
+    #endif
+
+    // The Tensao_DC blocks follow the carrier (EPWM2 is synchronized to EPWM1)
+    #if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA) && ((ADC_TRIGGER_SOURCE != ADC_TRIGGER_EPWM1_SOCA) || (ADC_SOCA_PRESCALE != 1))
+        #error "ADC_ACQUISITION_DMA needs ADC_TRIGGER_EPWM1_SOCA on every carrier period"
+    #endif
+
+    // UART transmission
+    //  UART_TX_POLLED:    uart_send_char waits for the SCI-C transmitter on every character
+    //  UART_TX_INTERRUPT: uart_send_char queues the character, scic_tx_isr feeds the TX FIFO
+    #define UART_TX_POLLED              0
+    #define UART_TX_INTERRUPT           1
+    #define UART_TX_MODE                UART_TX_INTERRUPT
+
+    #define UART_TX_BUFFER_SIZE         256     // Power of two, holds two telemetry frames
+    #define UART_TX_FIFO_DEPTH          16
+    #define UART_TX_FIFO_LEVEL          2       // TX FIFO interrupt at this many characters or fewer
+
+    // DS3231 time read (update_time_task)
+    //  I2C_READ_POLLED:    three single-register reads, spinning on the I2C status bits
+    //  I2C_READ_INTERRUPT: one burst read driven by i2cb_isr, the task sleeps until it completes
+    #define I2C_READ_POLLED             0
+    #define I2C_READ_INTERRUPT          1
+    #define I2C_READ_MODE               I2C_READ_INTERRUPT
+
+    // I2C-B transfer states (i2cb_isr)
+    #define I2C_TRANSFER_IDLE           0
+    #define I2C_TRANSFER_ADDRESS        1       // Writing the register pointer
+    #define I2C_TRANSFER_DATA           2       // Repeated start, reading DS3231_BURST_SIZE bytes
+    #define I2C_TRANSFER_STOP           3       // Error, waiting for the stop condition
+
     // DS3231 I2C Address and Register Definitions
     #define DS3231_I2C_ADDR             0x68
     #define DS3231_REG_SECONDS          0x00
@@ -60,12 +187,15 @@
     #define DS3231_REG_HOURS            0x02
     #define DS3231_REG_CONTROL          0x0E
     #define DS3231_REG_STATUS           0x0F
+    #define DS3231_BURST_SIZE           3       // Seconds, minutes, hours
     #define I2C_TIMEOUT_ERROR           0x04
 
     /**
      * @brief Setpoint with rolling average filter
      */
     typedef struct {
+        unsigned int raw;               // ADC code of the last conversion
+        float sample;                   // Its value, averaged into setpoint
         unsigned int pos;
         float values[SIZE_ADC_READINGS];
         float setpoint;
@@ -80,12 +210,122 @@
         float voltage;
     } InputMonitor;
 
+    /**
+     * @brief ADC acquisition statistics
+     *        wait_cycles is the trigger-to-ISR time, i.e. the time the former
+     *        timer0_isr spent spinning on ADCINT1 before it could read results
+     */
+    typedef struct {
+        uint32_t samples;
+        uint32_t missed_samples;
+        uint32_t wait_cycles;
+        uint32_t wait_cycles_max;
+        uint32_t isr_cycles;
+        uint32_t isr_cycles_max;
+        uint32_t timestamp;             // Timebase (us, low 32 bits) at the trigger of the last conversion
+    } AcquisitionStats;
+
+    /**
+     * @brief One coherent set of measurements, from a single conversion
+     */
+    typedef struct {
+        uint32_t sample;                // acquisition_stats.samples of the conversion
+        uint32_t timestamp;             // Timebase (us, low 32 bits) at its trigger
+        uint16_t setpoint_code;         // Raw ADC codes
+        uint16_t voltage_code;
+        uint16_t current_code;
+        uint16_t input_code;
+        float setpoint;                 // Filtered and limited setpoint (V)
+        float voltage;                  // Output voltage (V)
+        float current;                  // Load current
+        float input_voltage;            // Input voltage (V)
+        uint16_t system_state;
+    } Measurements;
+
+    /**
+     * @brief Measurements published by adcc1_isr, read with measurement_read
+     *        Sequence lock: the ISR makes sequence odd, writes the set and
+     *        makes it even again. A reader copies the set and retries when
+     *        sequence was odd or changed meanwhile, so tasks get one
+     *        conversion without disabling interrupts. adcc1_isr is the only
+     *        writer and is never preempted by a reader.
+     *        notify, when set, is called by adcc1_isr after every publication
+     */
+    typedef struct {
+        volatile uint16_t sequence;
+        volatile Measurements data;
+        void (*notify)(void);
+        uint32_t retries;               // Reads that overlapped a publication
+    } MeasurementSnapshot;
+
+    /**
+     * @brief UART transmit ring buffer
+     *        Single producer (communication_task), single consumer (scic_tx_isr)
+     */
+    typedef struct {
+        char buffer[UART_TX_BUFFER_SIZE];
+        volatile uint16_t head;         // Next free slot, written by the producer
+        volatile uint16_t tail;         // Next character to send, written by scic_tx_isr
+    } UartTxRing;
+
+    /**
+     * @brief UART transmit statistics
+     *        frame_cycles is the CPU time communication_task spends on a frame
+     */
+    typedef struct {
+        uint32_t frames;
+        uint32_t frame_cycles;
+        uint32_t frame_cycles_max;
+        uint32_t dropped;               // Characters lost to a full ring
+    } UartTxStats;
+
+    /**
+     * @brief I2C-B transfer in progress
+     *        Started by ds3231_read_time_start, advanced by i2cb_isr, which
+     *        calls complete() once the stop condition has been sent
+     */
+    typedef struct {
+        volatile uint16_t state;
+        volatile uint16_t status;           // I2C_SUCCESS or the error of the last transfer
+        uint16_t data[DS3231_BURST_SIZE];
+        uint32_t isr_cycles;                // CPU time spent in i2cb_isr on this transfer
+        void (*complete)(void);             // Called from i2cb_isr
+    } I2cTransfer;
+
+    /**
+     * @brief RTC read statistics
+     *        cycles is the CPU time of one time read: the whole call with
+     *        I2C_READ_POLLED, the task and i2cb_isr time with I2C_READ_INTERRUPT
+     */
+    typedef struct {
+        uint32_t reads;
+        uint32_t errors;
+        uint32_t timeouts;
+        uint32_t cycles;
+        uint32_t cycles_max;
+    } RtcStats;
+
     // Global variables
     extern SetpointFilter setpoint_filter;
     extern InputMonitor input_monitor;
+    extern MEDIDA medidasADC;
+    extern AcquisitionStats acquisition_stats;
+    extern MeasurementSnapshot measurement_snapshot;
+    extern UartTxRing uart_tx_ring;
+    extern UartTxStats uart_tx_stats;
+    extern I2cTransfer i2c_transfer;
+    extern RtcStats rtc_stats;
+
+    extern uint32_t uart_baud;
+
+    extern uint16_t pwm_factor;
+    extern float duty_cycle;
+    extern char system_state;
 
     // Function prototypes
-    interrupt void timer0_isr(void);
+    interrupt void adcc1_isr(void);
+    interrupt void scic_tx_isr(void);
+    interrupt void i2cb_isr(void);
 
     void gpio_init(void);
 
@@ -98,10 +338,17 @@
     void dac_init(void);
 
     void uart_init(void);
+    uint16_t uart_baud_error(uint32_t baud);
+    void uart_set_baud(uint32_t baud);
 
     void spi_init(void);
 
     void i2c_init(void);
+    uint16_t ds3231_read_time_start(void (*complete)(void));
+    uint16_t ds3231_read_time_result(Uint16* hours, Uint16* minutes, Uint16* seconds);
+    void i2c_abort(void);
+
+    void cla_init(void);
 
     void interrupt_init(void);
 
@@ -109,6 +356,15 @@
 
     // Auxiliary inline functions
 
+    /**
+     * @brief Read the free-running 64-bit IPC counter (low word)
+     *        Counts SYSCLK cycles, wraps every ~21 s at 200 MHz
+     * @return Current cycle count
+     */
+    inline uint32_t read_cycle_counter(void) {
+        return IpcRegs.IPCCOUNTERL;
+    }
+
     /**
      * @brief Convert BCD to decimal
      * @param bcd BCD value
@@ -158,15 +414,64 @@
         return i;
     }
 
+    /**
+     * @brief Copy the measurements of the last conversion
+     *        Retries while adcc1_isr publishes; from adcc1_isr itself it
+     *        never retries
+     * @param measurements Destination
+     */
+    inline void measurement_read(Measurements *measurements) {
+        uint16_t sequence;
+
+        while (1) {
+            sequence = measurement_snapshot.sequence;
+            *measurements = measurement_snapshot.data;
+
+            if (!(sequence & 1) && (sequence == measurement_snapshot.sequence))
+                return;
+
+            measurement_snapshot.retries++;
+        }
+    }
+
     // UART inline functions
 
+    /**
+     * @brief Free space in the UART transmit ring
+     * @return uint16_t Characters uart_send_char can queue without dropping
+     */
+    inline uint16_t uart_tx_free(void) {
+#if (UART_TX_MODE == UART_TX_INTERRUPT)
+        return (uart_tx_ring.tail - uart_tx_ring.head - 1) & (UART_TX_BUFFER_SIZE - 1);
+#else
+        return UART_TX_BUFFER_SIZE;
+#endif
+    }
+
     /**
      * @brief Send a character over UART
+     *        With UART_TX_INTERRUPT the character is queued and the call
+     *        returns at once; it is dropped if the ring is full
      * @param data Character to send
      */
     inline void uart_send_char(char data) {
+#if (UART_TX_MODE == UART_TX_INTERRUPT)
+        uint16_t next = (uart_tx_ring.head + 1) & (UART_TX_BUFFER_SIZE - 1);
+
+        if (next == uart_tx_ring.tail) {
+            uart_tx_stats.dropped++;
+            return;
+        }
+
+        uart_tx_ring.buffer[uart_tx_ring.head] = data;
+        uart_tx_ring.head = next;
+
+        // Interrupts while the FIFO is at or below UART_TX_FIFO_LEVEL
+        ScicRegs.SCIFFTX.bit.TXFFIENA = 1;
+#else
         while (!ScicRegs.SCICTL2.bit.TXRDY);
         ScicRegs.SCITXBUF.all = data;
+#endif
 
         return;
     }
@@ -399,7 +704,9 @@
     }
 
     /**
-     * @brief Read current time from DS3231
+     * @brief Read current time from DS3231, one register at a time
+     *        Blocks until the three reads are done (I2C_READ_POLLED); see
+     *        ds3231_read_time_start for the interrupt-driven burst read
      * @param hours Pointer to store hours
      * @param minutes Pointer to store minutes  
      * @param seconds Pointer to store seconds
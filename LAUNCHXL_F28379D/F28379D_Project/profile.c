@@ -0,0 +1,120 @@
+/**
+ * @file profile.c
+ * @brief Implementation of the ISR and task loop profiling
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "profile.h"
+
+#include "Libraries/freeRTOS/FreeRTOS.h"
+#include "Libraries/freeRTOS/task.h"
+
+ProfileSlot profile_slots[PROFILE_SLOTS] = {0};
+volatile uint16_t profile_dump_request = 0;
+
+/**
+ * @brief Set the nominal period and histogram resolution of a slot
+ *        Called before the ISR or task starts, the slot is cleared
+ * @param slot PROFILE_x
+ * @param period_us Nominal period of the ISR or task loop (us)
+ * @param exec_shift Execution time bucket width, 2^exec_shift cycles
+ * @param jitter_shift Jitter bucket width, 2^jitter_shift cycles
+ * @return void
+ */
+void profile_init(uint16_t slot, uint32_t period_us, uint16_t exec_shift, uint16_t jitter_shift) {
+    ProfileSlot clear = {0};
+
+    clear.period = period_us * (uint32_t)(CPU_FREQ / 1000000);
+    clear.exec_shift = exec_shift;
+    clear.jitter_shift = jitter_shift;
+
+    profile_slots[slot] = clear;
+
+    return;
+}
+
+/**
+ * @brief Ask for a dump, from the PROFILE_REQUEST frame of the monitor
+ *        uart_link_task sends it when SCI-C is free
+ * @return void
+ */
+void profile_request_dump(void) {
+    profile_dump_request = 1;
+
+    return;
+}
+
+/**
+ * @brief Send the record of one slot as a PROFILE frame
+ *        The slot is copied with interrupts disabled, so the frame never
+ *        holds half of a run. Callers hold communication_semaphore.
+ * @param slot PROFILE_x
+ * @return void
+ */
+void profile_send_slot(uint16_t slot) {
+    uint16_t payload[PROFILE_FRAME_SIZE];
+    ProfileSlot copy;
+    uint16_t x;
+
+    taskENTER_CRITICAL();
+    copy = profile_slots[slot];
+    taskEXIT_CRITICAL();
+
+    payload[0] = slot;
+    payload[1] = PROFILE_BUCKETS;
+    payload[2] = copy.exec_shift;
+    payload[3] = copy.jitter_shift;
+
+    telemetry_put_u32(payload + 4, copy.period);
+    telemetry_put_u32(payload + 8, copy.runs);
+    telemetry_put_u32(payload + 12, copy.misses);
+    telemetry_put_u32(payload + 16, copy.exec_last);
+    telemetry_put_u32(payload + 20, copy.exec_max);
+    telemetry_put_u32(payload + 24, copy.jitter_max);
+
+    for (x = 0; x < PROFILE_BUCKETS; x++) {
+        telemetry_put_u16(payload + 28 + 2 * x, copy.exec_hist[x]);
+        telemetry_put_u16(payload + 28 + 2 * (PROFILE_BUCKETS + x), copy.jitter_hist[x]);
+    }
+
+    telemetry_send_frame(TELEMETRY_FRAME_PROFILE, payload, PROFILE_FRAME_SIZE);
+
+    return;
+}
+
+/**
+ * @brief Send the FreeRTOS run time statistics of one task as a
+ *        TASK_STATS frame. Callers hold communication_semaphore.
+ * @param number Task number
+ * @param name Task name, truncated to PROFILE_NAME_SIZE characters
+ * @param state eTaskState of the task
+ * @param priority Base priority
+ * @param run_time Run time of the task (us, wraps with the timebase)
+ * @param total_run_time Run time counter when the state was taken (us)
+ * @param stack_free Stack high water mark (words)
+ * @return void
+ */
+void profile_send_task(uint16_t number, const char *name, uint16_t state, uint16_t priority,
+                       uint32_t run_time, uint32_t total_run_time, uint16_t stack_free) {
+    uint16_t payload[PROFILE_TASK_FRAME_SIZE];
+    uint16_t x, end = 0;
+
+    payload[0] = number;
+    payload[1] = state;
+    payload[2] = priority;
+
+    for (x = 0; x < PROFILE_NAME_SIZE; x++) {
+        if (!end && (name[x] == '\0'))
+            end = 1;
+        payload[3 + x] = end ? 0 : (name[x] & 0xFF);
+    }
+
+    telemetry_put_u32(payload + 11, run_time);
+    telemetry_put_u32(payload + 15, total_run_time);
+    telemetry_put_u16(payload + 19, stack_free);
+
+    telemetry_send_frame(TELEMETRY_FRAME_TASK_STATS, payload, PROFILE_TASK_FRAME_SIZE);
+
+    return;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file profile.h
+ * @brief Execution time, release jitter and deadline misses of adcc1_isr
+ *        and the task loops, dumped over SCI-C on request
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+    #include "peripheral_Setup.h"
+    #include "telemetry.h"
+
+    /**
+     * @brief Profiling
+     *        PROFILE_DISABLED: profile_begin/profile_end compile to nothing
+     *        PROFILE_ENABLED:  every run is recorded, about 60 cycles per run
+     *                          (0.6 % of the CPU for adcc1_isr at 20 kHz)
+     */
+    #define PROFILE_DISABLED        0
+    #define PROFILE_ENABLED         1
+    #define PROFILE_MODE            PROFILE_ENABLED
+
+    // Profiled code
+    #define PROFILE_ADC_ISR         0
+    #define PROFILE_CONTROL         1
+    #define PROFILE_COMMUNICATION   2
+    #define PROFILE_UPDATE_TIME     3
+    #define PROFILE_NN_TRAINING     4
+    #define PROFILE_UART_LINK       5
+    #define PROFILE_WAVEFORM        6
+    #define PROFILE_SLOTS           7
+
+    /**
+     * @brief Histograms
+     *        PROFILE_BUCKETS buckets of 2^shift SYSCLK cycles each, the last
+     *        one also counts everything above. A bucket reaching 0xFFFF
+     *        halves the whole histogram, so it keeps the shape of the
+     *        distribution with the recent runs weighing more
+     */
+    #define PROFILE_BUCKETS         8
+
+    /**
+     * @brief Timing of one ISR or task loop, all times in SYSCLK cycles
+     *        release: when the run was due, the previous start + period
+     *        jitter:  |start - release|
+     *        miss:    the run ended more than one period after its release
+     *        Execution time is measured from profile_begin to profile_end
+     *        and includes preemption by higher priority tasks and ISRs
+     */
+    typedef struct {
+        uint32_t period;
+        uint16_t exec_shift;
+        uint16_t jitter_shift;
+        uint32_t runs;
+        uint32_t misses;
+        uint32_t start;
+        uint32_t release;
+        uint32_t exec_last;
+        uint32_t exec_max;
+        uint32_t jitter_max;
+        uint16_t exec_hist[PROFILE_BUCKETS];
+        uint16_t jitter_hist[PROFILE_BUCKETS];
+    } ProfileSlot;
+
+    /**
+     * @brief PROFILE frame payload, bytes
+     *        [0]      slot
+     *        [1]      PROFILE_BUCKETS
+     *        [2..3]   exec and jitter bucket shift
+     *        [4..27]  period, runs, misses, last and max execution time,
+     *                 max jitter (u32 each)
+     *        [28..59] execution and jitter histograms (u16 per bucket)
+     *
+     *        TASK_STATS frame payload, one per FreeRTOS task, bytes
+     *        [0]      task number
+     *        [1]      state (eTaskState)
+     *        [2]      base priority
+     *        [3..10]  name, zero padded
+     *        [11..14] run time of the task (us)
+     *        [15..18] total run time (us)
+     *        [19..20] stack high water mark (words)
+     */
+    #define PROFILE_FRAME_SIZE      60
+    #define PROFILE_TASK_FRAME_SIZE 21
+    #define PROFILE_NAME_SIZE       8
+
+    extern ProfileSlot profile_slots[PROFILE_SLOTS];
+    extern volatile uint16_t profile_dump_request;
+
+    static inline void profile_histogram(uint16_t *histogram, uint32_t value, uint16_t shift) {
+        uint32_t bucket = value >> shift;
+        uint16_t x;
+
+        if (bucket >= PROFILE_BUCKETS)
+            bucket = PROFILE_BUCKETS - 1;
+
+        if (++histogram[bucket] == 0xFFFF)
+            for (x = 0; x < PROFILE_BUCKETS; x++)
+                histogram[x] >>= 1;
+
+        return;
+    }
+
+    /**
+     * @brief Start of a run: release jitter
+     * @param slot PROFILE_x
+     */
+    static inline void profile_begin(uint16_t slot) {
+#if (PROFILE_MODE == PROFILE_ENABLED)
+        ProfileSlot *profile = &profile_slots[slot];
+        uint32_t now = read_cycle_counter();
+        int32_t jitter;
+
+        profile->release = profile->start + profile->period;
+        profile->start = now;
+
+        if (profile->runs == 0) {
+            profile->release = now;
+            return;
+        }
+
+        jitter = (int32_t)(now - profile->release);
+        if (jitter < 0)
+            jitter = -jitter;
+
+        if ((uint32_t)jitter > profile->jitter_max)
+            profile->jitter_max = jitter;
+        profile_histogram(profile->jitter_hist, jitter, profile->jitter_shift);
+#endif
+
+        return;
+    }
+
+    /**
+     * @brief End of a run: execution time and deadline
+     * @param slot PROFILE_x
+     */
+    static inline void profile_end(uint16_t slot) {
+#if (PROFILE_MODE == PROFILE_ENABLED)
+        ProfileSlot *profile = &profile_slots[slot];
+        uint32_t now = read_cycle_counter();
+
+        profile->exec_last = now - profile->start;
+        if (profile->exec_last > profile->exec_max)
+            profile->exec_max = profile->exec_last;
+        profile_histogram(profile->exec_hist, profile->exec_last, profile->exec_shift);
+
+        if ((int32_t)(now - profile->release) > (int32_t)profile->period)
+            profile->misses++;
+
+        profile->runs++;
+#endif
+
+        return;
+    }
+
+    // Profile functions
+    void profile_init(uint16_t slot, uint32_t period_us, uint16_t exec_shift, uint16_t jitter_shift);
+    void profile_request_dump(void);
+    void profile_send_slot(uint16_t slot);
+    void profile_send_task(uint16_t number, const char *name, uint16_t state, uint16_t priority,
+                           uint32_t run_time, uint32_t total_run_time, uint16_t stack_free);
+
+#endif /* PROFILE_H */
@@ -0,0 +1,166 @@
+/**
+ * @file telemetry.c
+ * @brief Implementation of the binary telemetry frames
+ *        Bytes are held in the low 8 bits of 16-bit words (the C28x char)
+ *        and written to the UART as they are COBS encoded, so no encoded
+ *        copy of the frame is kept.
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "telemetry.h"
+#include "controllers.h"
+
+TelemetryStats telemetry_stats = {0};
+
+/**
+ * @brief Store a float as its IEEE 754 bits, little-endian
+ */
+static inline void telemetry_put_float(uint16_t *buffer, float value) {
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+
+    bits.f = value;
+    telemetry_put_u32(buffer, bits.u);
+
+    return;
+}
+
+/**
+ * @brief CRC16-CCITT (polynomial 0x1021), one byte per word
+ * @param data Bytes to process
+ * @param length Number of bytes
+ * @param crc Initial value, 0xFFFF for a new frame
+ * @return uint16_t The updated CRC
+ */
+uint16_t telemetry_crc16(const uint16_t *data, uint16_t length, uint16_t crc) {
+    uint16_t x, bit;
+
+    for (x = 0; x < length; x++) {
+        crc ^= (data[x] & 0xFF) << 8;
+
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+
+    return crc;
+}
+
+/**
+ * @brief COBS encode bytes to the UART, followed by the 0x00 delimiter
+ *        Each block is a code byte (block length + 1) and up to 254 non-zero
+ *        bytes; a code below 0xFF stands for a zero after the block
+ * @param data Bytes to send
+ * @param length Number of bytes
+ * @return uint16_t Bytes written to the UART
+ */
+static uint16_t telemetry_cobs_send(const uint16_t *data, uint16_t length) {
+    uint16_t start = 0, end, x;
+    uint16_t sent = 0;
+
+    do {
+        end = start;
+        while ((end < length) && ((data[end] & 0xFF) != 0) && (end - start < 254))
+            end++;
+
+        uart_send_char((char)(end - start + 1));
+        for (x = start; x < end; x++)
+            uart_send_char((char)data[x]);
+
+        sent += end - start + 1;
+
+        // A zero ends the block, a full block does not consume one
+        start = ((end < length) && ((data[end] & 0xFF) == 0)) ? end + 1 : end;
+    } while (end < length);
+
+    uart_send_char(0);
+
+    return sent + 1;
+}
+
+/**
+ * @brief Send a frame: header, payload and CRC, COBS encoded
+ *        Not reentrant, callers hold communication_semaphore
+ * @param type Frame type (TELEMETRY_FRAME_x)
+ * @param payload Payload bytes
+ * @param length Payload length, at most TELEMETRY_MAX_PAYLOAD
+ * @return void
+ */
+void telemetry_send_frame(uint16_t type, const uint16_t *payload, uint16_t length) {
+    static uint16_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE];
+    uint16_t x, size;
+
+    if (length > TELEMETRY_MAX_PAYLOAD)
+        return;
+
+    frame[0] = (TELEMETRY_VERSION << 4) | (type & 0x0F);
+    frame[1] = telemetry_stats.sequence & 0xFF;
+
+    for (x = 0; x < length; x++)
+        frame[TELEMETRY_HEADER_SIZE + x] = payload[x] & 0xFF;
+
+    size = TELEMETRY_HEADER_SIZE + length;
+    telemetry_put_u16(frame + size, telemetry_crc16(frame, size, 0xFFFF));
+    size += TELEMETRY_CRC_SIZE;
+
+    telemetry_stats.bytes += telemetry_cobs_send(frame, size);
+    telemetry_stats.sequence++;
+    telemetry_stats.frames++;
+
+    return;
+}
+
+/**
+ * @brief Send the scale factors of the status frame and the time
+ * @param tick Tick count (ms), the full value of the STATUS frame ticks
+ * @return void
+ */
+void telemetry_send_info(uint32_t tick) {
+    uint16_t payload[TELEMETRY_INFO_SIZE];
+
+    telemetry_put_float(payload + 0, MAX_VOLTAGE / MAX_ADC);
+    telemetry_put_float(payload + 4, VOLTAGE_CONVERSION_FACTOR);
+    telemetry_put_float(payload + 8, CURRENT_CONVERSION_FACTOR);
+    telemetry_put_float(payload + 12, input_monitor.conv_factor);
+    telemetry_put_u16(payload + 16, pwm_factor);
+    telemetry_put_u32(payload + 18, tick);
+
+    telemetry_send_frame(TELEMETRY_FRAME_INFO, payload, TELEMETRY_INFO_SIZE);
+
+    return;
+}
+
+/**
+ * @brief Send the latest ADC results, duty cycle and controller state
+ *        The ADC codes and the state come from one conversion
+ *        (measurement_read)
+ * @param tick Tick count (ms), low 16 bits sent
+ * @return void
+ */
+void telemetry_send_status(uint32_t tick) {
+    uint16_t payload[TELEMETRY_STATUS_SIZE];
+    Measurements measurements;
+    uint64_t bits;
+    uint16_t x;
+
+    measurement_read(&measurements);
+
+    bits  = (uint64_t)(measurements.setpoint_code & 0x0FFF);
+    bits |= (uint64_t)(measurements.voltage_code & 0x0FFF) << 12;
+    bits |= (uint64_t)(measurements.current_code & 0x0FFF) << 24;
+    bits |= (uint64_t)(measurements.input_code & 0x0FFF) << 36;
+    bits |= (uint64_t)(EPWM1_Modulante_CMPA & 0x0FFF) << 48;
+    bits |= (uint64_t)(measurements.system_state ? 1 : 0) << 60;
+    bits |= (uint64_t)(current_controller_type & 0x07) << 61;
+
+    for (x = 0; x < 8; x++)
+        payload[x] = (uint16_t)(bits >> (8 * x)) & 0xFF;
+
+    telemetry_put_u16(payload + 8, (uint16_t)(tick & 0xFFFF));
+
+    telemetry_send_frame(TELEMETRY_FRAME_STATUS, payload, TELEMETRY_STATUS_SIZE);
+
+    return;
+}
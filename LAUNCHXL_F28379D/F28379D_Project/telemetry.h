@@ -0,0 +1,124 @@
+/**
+ * @file telemetry.h
+ * @brief Binary telemetry frames over SCI-C
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+    #include "peripheral_Setup.h"
+
+    /**
+     * @brief Telemetry format
+     *        Set to TELEMETRY_ASCII for the CSV report of former versions
+     *        (SETPOINT,VOLTAGE,CURRENT,HH:MM:SS), readable on a terminal
+     *        Set to TELEMETRY_BINARY for COBS framed binary frames, decoded
+     *        by the BeagleBone monitor (telemetry.rs)
+     */
+    #define TELEMETRY_ASCII         0
+    #define TELEMETRY_BINARY        1
+    #define TELEMETRY_FORMAT        TELEMETRY_BINARY
+
+    /**
+     * @brief Frame layout, bytes, multi-byte fields little-endian
+     *        [0]     version (high nibble) and frame type (low nibble)
+     *        [1]     sequence number, incremented on every frame
+     *        [2..]   payload of the frame type
+     *        [n..]   CRC16-CCITT (0x1021, initial 0xFFFF) of the bytes above
+     *        The frame is COBS encoded and terminated by a 0x00 byte, so a
+     *        receiver resynchronizes on the next 0x00 after any corruption.
+     *        STATUS frames carry the low 16 bits of the tick count, which
+     *        the receiver extends from the full count of the INFO frames.
+     *        A STATUS frame is 16 bytes on the line against about 25 for
+     *        the CSV line
+     */
+    #define TELEMETRY_VERSION       2
+    #define TELEMETRY_HEADER_SIZE   2
+    #define TELEMETRY_CRC_SIZE      2
+    #define TELEMETRY_MAX_PAYLOAD   64
+
+    // COBS adds one byte per 254 and the delimiter
+    #define TELEMETRY_MAX_FRAME     (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE + 2)
+
+    /**
+     * @brief Frame types
+     *        INFO:   scale factors of the ADC codes, the PWM period and
+     *                the time, sent on start and every
+     *                TELEMETRY_INFO_PERIOD STATUS frames
+     *                  float32 setpoint, voltage, current and input scale
+     *                  (value per ADC code), uint16 PWM period (CMPA counts),
+     *                  uint32 FreeRTOS tick count (ms)
+     *        STATUS: raw measurements and controller state, 64 bits,
+     *                and uint16 FreeRTOS tick count (ms, wraps every 65.5 s)
+     *                  bits  0..11 setpoint ADC code
+     *                  bits 12..23 output voltage ADC code
+     *                  bits 24..35 load current ADC code
+     *                  bits 36..47 input voltage ADC code
+     *                  bits 48..59 EPWM1 CMPA (duty cycle = CMPA / PWM period)
+     *                  bit  60     system state (1 = ON)
+     *                  bits 61..63 controller type
+     *        WAVEFORM: block of streamed samples (see waveform.h)
+     *        LINK_x:   baud rate negotiation with the monitor (see uart_link.h)
+     *        PROFILE_REQUEST: from the monitor, no payload, asks for a dump
+     *                  of PROFILE and TASK_STATS frames (see profile.h)
+     *        PROFILE:  timing record of adcc1_isr or a task loop
+     *        TASK_STATS: FreeRTOS run time statistics of one task
+     */
+    #define TELEMETRY_FRAME_INFO            0
+    #define TELEMETRY_FRAME_STATUS          1
+    #define TELEMETRY_FRAME_WAVEFORM        2
+    #define TELEMETRY_FRAME_LINK_REQUEST    3
+    #define TELEMETRY_FRAME_LINK_ACK        4
+    #define TELEMETRY_FRAME_LINK_TEST       5
+    #define TELEMETRY_FRAME_LINK_CONFIRM    6
+    #define TELEMETRY_FRAME_PROFILE_REQUEST 7
+    #define TELEMETRY_FRAME_PROFILE         8
+    #define TELEMETRY_FRAME_TASK_STATS      9
+
+    #define TELEMETRY_INFO_SIZE     22
+    #define TELEMETRY_STATUS_SIZE   10
+
+    #define TELEMETRY_INFO_PERIOD   16
+
+    /**
+     * @brief Telemetry statistics
+     */
+    typedef struct {
+        uint16_t sequence;          // Sequence number of the next frame, 8 bits sent
+        uint32_t frames;
+        uint32_t bytes;             // Bytes on the line, framing included
+    } TelemetryStats;
+
+    extern TelemetryStats telemetry_stats;
+
+    /**
+     * @brief Store and read little-endian fields in a byte buffer
+     */
+    static inline void telemetry_put_u16(uint16_t *buffer, uint16_t value) {
+        buffer[0] = value & 0xFF;
+        buffer[1] = (value >> 8) & 0xFF;
+
+        return;
+    }
+
+    static inline void telemetry_put_u32(uint16_t *buffer, uint32_t value) {
+        telemetry_put_u16(buffer, (uint16_t)(value & 0xFFFF));
+        telemetry_put_u16(buffer + 2, (uint16_t)(value >> 16));
+
+        return;
+    }
+
+    static inline uint32_t telemetry_get_u32(const uint16_t *buffer) {
+        return ((uint32_t)(buffer[0] & 0xFF)) | ((uint32_t)(buffer[1] & 0xFF) << 8) |
+               ((uint32_t)(buffer[2] & 0xFF) << 16) | ((uint32_t)(buffer[3] & 0xFF) << 24);
+    }
+
+    // Telemetry functions
+    uint16_t telemetry_crc16(const uint16_t *data, uint16_t length, uint16_t crc);
+    void telemetry_send_frame(uint16_t type, const uint16_t *payload, uint16_t length);
+    void telemetry_send_info(uint32_t tick);
+    void telemetry_send_status(uint32_t tick);
+
+#endif /* TELEMETRY_H */
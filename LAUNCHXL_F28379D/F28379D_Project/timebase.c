@@ -0,0 +1,165 @@
+/**
+ * @file timebase.c
+ * @brief Implementation of the CPU Timer1 timebase and the wall clock
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "timebase.h"
+
+volatile uint32_t timebase_high = 0;
+WallClock wall_clock = {0};
+
+/**
+ * @brief CPU Timer1 interrupt (INT13), once per wrap of the counter
+ */
+interrupt void timer1_isr(void) {
+    timebase_high++;
+
+    CpuTimer1Regs.TCR.bit.TIF = 1;
+}
+
+/**
+ * @brief Start CPU Timer1 as the free-running timebase
+ *        It keeps counting while the debugger halts the CPU, so the wall
+ *        clock stays right across breakpoints
+ */
+void timebase_init(void) {
+    CpuTimer1Regs.TCR.bit.TSS = 1;
+
+    CpuTimer1Regs.PRD.all = 0xFFFFFFFF;
+    CpuTimer1Regs.TPR.bit.TDDR = (TIMEBASE_PRESCALE - 1) & 0xFF;
+    CpuTimer1Regs.TPRH.bit.TDDRH = (TIMEBASE_PRESCALE - 1) >> 8;
+
+    CpuTimer1Regs.TCR.bit.TRB = 1;
+    CpuTimer1Regs.TCR.bit.FREE = 1;
+    CpuTimer1Regs.TCR.bit.TIF = 1;
+    CpuTimer1Regs.TCR.bit.TIE = 1;
+
+    timebase_high = 0;
+
+    CpuTimer1Regs.TCR.bit.TSS = 0;
+
+    return;
+}
+
+/**
+ * @brief Microseconds since timebase_init
+ *        Safe from tasks and ISRs: a wrap timer1_isr has not counted yet
+ *        (interrupts disabled) is taken from the pending TIF
+ * @return uint64_t Timebase (us)
+ */
+uint64_t timebase_now_us(void) {
+    uint32_t high, count;
+    uint16_t pending;
+
+    do {
+        high = timebase_high;
+        count = CpuTimer1Regs.TIM.all;
+        pending = CpuTimer1Regs.TCR.bit.TIF;
+    } while (high != timebase_high);
+
+    // Wrapped after the counter was read only if it was read near zero
+    if (pending && (count > 0x80000000UL))
+        high++;
+
+    return ((uint64_t)high << 32) | (0xFFFFFFFFUL - count);
+}
+
+/**
+ * @brief FreeRTOS run time statistics clock (FreeRTOSConfig.h)
+ * @return uint32_t Low 32 bits of the timebase (us)
+ */
+uint32_t timebase_run_time(void) {
+    return timebase_now_us32();
+}
+
+/**
+ * @brief Wall clock at a timebase instant
+ * @param now_us Timebase (us)
+ * @return uint64_t Microseconds since midnight, not reduced to one day
+ */
+static uint64_t wall_clock_at(uint64_t now_us) {
+    int64_t elapsed = (int64_t)(now_us - wall_clock.anchor_us);
+
+    elapsed -= elapsed * wall_clock.drift_ppb / 1000000000LL;
+
+    return (uint64_t)wall_clock.anchor_seconds * TIMEBASE_FREQ + elapsed;
+}
+
+/**
+ * @brief Resync the wall clock on a DS3231 second edge
+ * @param rtc_seconds RTC time of day the edge started (s)
+ * @param edge_us Timebase at the edge
+ * @return void
+ */
+void wall_clock_sync(uint32_t rtc_seconds, uint64_t edge_us) {
+    const int64_t day_us = (int64_t)TIME_DAY_SECONDS * TIMEBASE_FREQ;
+    int64_t error, local_us, rtc_us;
+
+    if (wall_clock.synced) {
+        // Error of the free-running clock, wrapped to +- half a day
+        error = (int64_t)(wall_clock_at(edge_us) % day_us) - (int64_t)rtc_seconds * TIMEBASE_FREQ;
+        if (error > day_us / 2)
+            error -= day_us;
+        else if (error < -day_us / 2)
+            error += day_us;
+
+        if (error > 0x7FFFFFFFLL)
+            error = 0x7FFFFFFFLL;
+        else if (error < -0x7FFFFFFFLL)
+            error = -0x7FFFFFFFLL;
+        wall_clock.error_us = (int32_t)error;
+
+        wall_clock.reference_seconds += (rtc_seconds + TIME_DAY_SECONDS - wall_clock.anchor_seconds) % TIME_DAY_SECONDS;
+
+        local_us = (int64_t)(edge_us - wall_clock.reference_us);
+        rtc_us = (int64_t)wall_clock.reference_seconds * TIMEBASE_FREQ;
+
+        error = (rtc_us > 0) ? (local_us - rtc_us) * 1000000000LL / rtc_us : 0;
+
+        if ((error > TIME_DRIFT_LIMIT) || (error < -TIME_DRIFT_LIMIT)) {
+            wall_clock.reference_us = edge_us;
+            wall_clock.reference_seconds = 0;
+        }
+        else
+            wall_clock.drift_ppb = (int32_t)error;
+    }
+    else {
+        wall_clock.reference_us = edge_us;
+        wall_clock.reference_seconds = 0;
+    }
+
+    wall_clock.anchor_us = edge_us;
+    wall_clock.anchor_seconds = rtc_seconds;
+    wall_clock.synced = 1;
+    wall_clock.syncs++;
+
+    return;
+}
+
+/**
+ * @brief Current wall clock
+ *        Counts from 00:00:00 at start-up until the first resync
+ * @return uint64_t Microseconds since midnight
+ */
+uint64_t wall_clock_now_us(void) {
+    return wall_clock_at(timebase_now_us()) % ((uint64_t)TIME_DAY_SECONDS * TIMEBASE_FREQ);
+}
+
+/**
+ * @brief Current wall clock as hours, minutes and seconds
+ * @param hours Pointer to store hours
+ * @param minutes Pointer to store minutes
+ * @param seconds Pointer to store seconds
+ * @return void
+ */
+void wall_clock_time(uint16_t *hours, uint16_t *minutes, uint16_t *seconds) {
+    uint32_t time = (uint32_t)(wall_clock_now_us() / TIMEBASE_FREQ);
+
+    *hours = time / 3600;
+    *minutes = (time / 60) % 60;
+    *seconds = time % 60;
+
+    return;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file timebase.h
+ * @brief Microsecond timebase on CPU Timer1 and the wall clock derived from it
+ *        The DS3231 is only read to resync the wall clock, every
+ *        TIME_RESYNC_PERIOD seconds (update_time_task)
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+    #include "peripheral_Setup.h"
+
+    /**
+     * @brief Timebase
+     *        CPU Timer1 counts down from 0xFFFFFFFF at TIMEBASE_FREQ;
+     *        timer1_isr (INT13) counts the wraps, every ~71.6 minutes, into
+     *        the upper 32 bits. Timer2 is the FreeRTOS tick, Timer0 may
+     *        trigger the ADC.
+     */
+    #define TIMEBASE_FREQ           1000000UL
+    #define TIMEBASE_PRESCALE       ((uint16_t)(CPU_FREQ / TIMEBASE_FREQ))
+
+    /**
+     * @brief Wall clock
+     *        Time of day = RTC time at the last second edge found by a
+     *        resync + timebase elapsed since, corrected by the drift of
+     *        Timer1 against the DS3231. The drift is measured over all the
+     *        edges since the first one, so the error of each edge (half the
+     *        update_time_task period) is spread over an ever longer interval.
+     */
+    #define TIME_RESYNC_PERIOD      60          // s between DS3231 reads
+    #define TIME_DAY_SECONDS        86400UL
+    #define TIME_DRIFT_LIMIT        500000L     // ppb; beyond it the RTC was set, the estimate restarts
+
+    /**
+     * @brief Wall clock state
+     *        Written by wall_clock_sync, read by wall_clock_now_us; both run
+     *        in update_time_task
+     */
+    typedef struct {
+        uint64_t anchor_us;                 // Timebase at the last RTC second edge
+        uint64_t reference_us;              // Timebase at the first edge of the drift estimate
+        uint32_t anchor_seconds;            // RTC time of day at anchor_us (s)
+        uint32_t reference_seconds;         // RTC seconds from reference_us to anchor_us
+        int32_t drift_ppb;                  // Timer1 rate error, positive when Timer1 runs fast
+        int32_t error_us;                   // Wall clock error found by the last resync
+        uint32_t syncs;
+        uint16_t synced;
+    } WallClock;
+
+    extern volatile uint32_t timebase_high;
+    extern WallClock wall_clock;
+
+    /**
+     * @brief Low 32 bits of the timebase, one register read (ISRs)
+     * @return uint32_t Microseconds, wraps every ~71.6 minutes
+     */
+    static inline uint32_t timebase_now_us32(void) {
+        return 0xFFFFFFFFUL - CpuTimer1Regs.TIM.all;
+    }
+
+    // Timebase functions
+    interrupt void timer1_isr(void);
+    void timebase_init(void);
+    uint64_t timebase_now_us(void);
+    uint32_t timebase_run_time(void);
+
+    // Wall clock functions
+    void wall_clock_sync(uint32_t rtc_seconds, uint64_t edge_us);
+    uint64_t wall_clock_now_us(void);
+    void wall_clock_time(uint16_t *hours, uint16_t *minutes, uint16_t *seconds);
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,282 @@
+/**
+ * @file uart_link.c
+ * @brief Implementation of the SCI-C baud rate negotiation
+ *        Frames from the monitor are short and rare, so the receive FIFO
+ *        is polled by uart_link_task instead of raising an interrupt.
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "uart_link.h"
+#include "profile.h"
+
+UartLinkStatus uart_link_status = {0};
+
+// Received bytes of the current frame, COBS encoded
+static uint16_t rx_buffer[UART_LINK_RX_SIZE];
+static uint16_t rx_length = 0;
+static uint16_t rx_overflow = 0;
+static uint16_t rx_error = 0;           // Receiver stopped, reset pending
+
+static inline void uart_link_set_state(uint16_t state) {
+    uart_link_status.state = state;
+    uart_link_status.timer = 0;
+
+    return;
+}
+
+/**
+ * @brief Nothing queued or being shifted out, the rate can change
+ */
+static inline uint16_t uart_link_tx_idle(void) {
+    return (uart_tx_ring.head == uart_tx_ring.tail) &&
+           (ScicRegs.SCIFFTX.bit.TXFFST == 0) &&
+           ScicRegs.SCICTL2.bit.TXEMPTY;
+}
+
+/**
+ * @brief Drop what was received at the previous rate
+ */
+static inline void uart_link_flush_rx(void) {
+    ScicRegs.SCIFFRX.bit.RXFIFORESET = 0;
+    ScicRegs.SCIFFRX.bit.RXFIFORESET = 1;
+
+    rx_length = 0;
+    rx_overflow = 0;
+
+    return;
+}
+
+static void uart_link_send_ack(uint32_t baud, uint16_t accepted) {
+    uint16_t payload[5];
+
+    telemetry_put_u32(payload, baud);
+    payload[4] = accepted;
+
+    telemetry_send_frame(TELEMETRY_FRAME_LINK_ACK, payload, 5);
+
+    return;
+}
+
+/**
+ * @brief Handle a valid frame from the monitor
+ * @param type Frame type
+ * @param payload Payload bytes
+ * @param length Payload length
+ * @return void
+ */
+static void uart_link_frame(uint16_t type, const uint16_t *payload, uint16_t length) {
+    uint32_t baud;
+
+    switch (type) {
+        case TELEMETRY_FRAME_LINK_REQUEST:
+            if (length < 4)
+                return;
+
+            baud = telemetry_get_u32(payload);
+            uart_link_status.requests++;
+
+            // Already changing rate
+            if ((uart_link_status.state == UART_LINK_SWITCHING) || (uart_link_status.state == UART_LINK_REVERTING))
+                return;
+
+            if (uart_baud_error(baud) == UART_BAUD_INVALID) {
+                uart_link_send_ack(baud, 0);
+                return;
+            }
+
+            uart_link_send_ack(baud, 1);
+
+            uart_link_status.pending_baud = baud;
+            uart_link_set_state(UART_LINK_SWITCHING);
+            break;
+
+        case TELEMETRY_FRAME_LINK_CONFIRM:
+            if ((length < 4) || (telemetry_get_u32(payload) != uart_baud))
+                return;
+
+            if ((uart_link_status.state == UART_LINK_TESTING) && uart_link_status.test_sent) {
+                uart_link_status.switches++;
+                uart_link_set_state(UART_LINK_ACTIVE);
+            }
+            else if (uart_link_status.state == UART_LINK_ACTIVE)
+                uart_link_status.timer = 0;
+            break;
+
+        case TELEMETRY_FRAME_PROFILE_REQUEST:
+            profile_request_dump();
+            break;
+
+        default:
+            break;
+    }
+
+    return;
+}
+
+/**
+ * @brief Feed one received byte, a 0x00 ends the frame
+ *        The frame is COBS decoded and CRC checked like the telemetry
+ *        frames; anything else is counted in rx_errors and dropped
+ * @param byte Received byte
+ * @return void
+ */
+void uart_link_receive(uint16_t byte) {
+    static uint16_t frame[UART_LINK_RX_SIZE];
+    uint16_t index = 0, length = 0, valid, code, x;
+
+    byte &= 0xFF;
+
+    if (byte != 0) {
+        if (rx_length < UART_LINK_RX_SIZE)
+            rx_buffer[rx_length++] = byte;
+        else
+            rx_overflow = 1;
+
+        return;
+    }
+
+    if (rx_length == 0)
+        return;
+
+    // COBS decode, no code byte can be 0 here
+    valid = !rx_overflow;
+    while (valid && (index < rx_length)) {
+        code = rx_buffer[index];
+
+        if (index + code > rx_length) {
+            valid = 0;
+            break;
+        }
+
+        for (x = index + 1; x < index + code; x++)
+            frame[length++] = rx_buffer[x];
+
+        index += code;
+        if ((code < 0xFF) && (index < rx_length))
+            frame[length++] = 0;
+    }
+
+    rx_length = 0;
+    rx_overflow = 0;
+
+    if (valid && (length >= TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE)) {
+        length -= TELEMETRY_CRC_SIZE;
+
+        valid = (telemetry_crc16(frame, length, 0xFFFF) == (frame[length] | (frame[length + 1] << 8))) &&
+                ((frame[0] >> 4) == TELEMETRY_VERSION);
+    }
+    else
+        valid = 0;
+
+    if (!valid) {
+        uart_link_status.rx_errors++;
+        return;
+    }
+
+    uart_link_frame(frame[0] & 0x0F, frame + TELEMETRY_HEADER_SIZE, length - TELEMETRY_HEADER_SIZE);
+
+    return;
+}
+
+/**
+ * @brief Poll the receiver and advance the negotiation
+ *        Called every UART_LINK_PERIOD by uart_link_task with
+ *        communication_semaphore held
+ * @return uint16_t 1 while the line must stay reserved (rate change or
+ *         receiver reset in progress), 0 when communication_semaphore can
+ *         be released
+ */
+uint16_t uart_link_service(void) {
+    static uint16_t pattern[UART_LINK_PATTERN_SIZE];
+    uint16_t x;
+
+    // A full receive FIFO only needs the FIFO reset
+    if (ScicRegs.SCIFFRX.bit.RXFFOVF) {
+        uart_link_status.rx_errors++;
+
+        ScicRegs.SCIFFRX.bit.RXFFOVRCLR = 1;
+        uart_link_flush_rx();
+    }
+
+    // A receiver error (break, framing, overrun) stops the receiver until a
+    // software reset, which would also cut the character being sent: keep
+    // the line reserved until the transmitter is idle
+    if (ScicRegs.SCIRXST.bit.RXERROR) {
+        if (!rx_error) {
+            uart_link_status.rx_errors++;
+            rx_error = 1;
+        }
+
+        if (!uart_link_tx_idle())
+            return 1;
+
+        ScicRegs.SCICTL1.bit.SWRESET = 0;
+        ScicRegs.SCICTL1.bit.SWRESET = 1;
+
+        uart_link_flush_rx();
+        rx_error = 0;
+    }
+
+    while (ScicRegs.SCIFFRX.bit.RXFFST > 0)
+        uart_link_receive(ScicRegs.SCIRXBUF.all);
+
+    if (uart_link_status.timer < 60000)
+        uart_link_status.timer += UART_LINK_PERIOD;
+
+    switch (uart_link_status.state) {
+        case UART_LINK_SWITCHING:
+            // The ACK leaves at the old rate
+            if (!uart_link_tx_idle())
+                return 1;
+
+            uart_set_baud(uart_link_status.pending_baud);
+            uart_link_flush_rx();
+
+            uart_link_status.test_sent = 0;
+            uart_link_set_state(UART_LINK_TESTING);
+            return 1;
+
+        case UART_LINK_TESTING:
+            if (!uart_link_status.test_sent) {
+                // Give the monitor time to switch
+                if (uart_link_status.timer < UART_LINK_SETTLE)
+                    return 1;
+
+                for (x = 0; x < UART_LINK_PATTERN_SIZE; x++)
+                    pattern[x] = uart_link_pattern(x);
+
+                telemetry_send_frame(TELEMETRY_FRAME_LINK_TEST, pattern, UART_LINK_PATTERN_SIZE);
+                uart_link_status.test_sent = 1;
+                return 0;
+            }
+
+            if (uart_link_status.timer >= UART_LINK_CONFIRM_TIMEOUT) {
+                uart_link_status.fallbacks++;
+                uart_link_set_state(UART_LINK_REVERTING);
+                return 1;
+            }
+            return 0;
+
+        case UART_LINK_ACTIVE:
+            if (uart_link_status.timer >= UART_LINK_KEEPALIVE_TIMEOUT) {
+                uart_link_status.fallbacks++;
+                uart_link_set_state(UART_LINK_REVERTING);
+                return 1;
+            }
+            return 0;
+
+        case UART_LINK_REVERTING:
+            if (!uart_link_tx_idle())
+                return 1;
+
+            uart_set_baud(SCI_FREQ);
+            uart_link_flush_rx();
+
+            uart_link_set_state(UART_LINK_IDLE);
+            return 0;
+
+        default:
+            return 0;
+    }
+}
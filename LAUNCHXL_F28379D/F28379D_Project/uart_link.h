@@ -0,0 +1,75 @@
+/**
+ * @file uart_link.h
+ * @brief SCI-C baud rate negotiation with the BeagleBone monitor
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+    #include "peripheral_Setup.h"
+    #include "telemetry.h"
+
+    /**
+     * @brief Handshake, telemetry frames in both directions
+     *        1. The monitor sends LINK_REQUEST (u32 baud) at the current rate
+     *        2. The board answers LINK_ACK (u32 baud, u8 accepted) at the
+     *           current rate; a rate above SCI_BAUD_MAX or more than
+     *           SCI_BAUD_TOLERANCE off is refused
+     *        3. Both switch; after UART_LINK_SETTLE the board sends
+     *           LINK_TEST, UART_LINK_PATTERN_SIZE bytes of uart_link_pattern()
+     *        4. The monitor checks the CRC and the pattern and answers
+     *           LINK_CONFIRM (u32 baud) at the new rate
+     *        Without LINK_CONFIRM within UART_LINK_CONFIRM_TIMEOUT the board
+     *        returns to SCI_FREQ, and so does the monitor without a valid
+     *        LINK_TEST. Once negotiated, the monitor repeats LINK_CONFIRM every
+     *        second; after UART_LINK_KEEPALIVE_TIMEOUT without it the board
+     *        returns to SCI_FREQ, so a restarted monitor finds it again.
+     */
+    #define UART_LINK_PERIOD                10      // ms, uart_link_task
+    #define UART_LINK_SETTLE                50      // ms
+    #define UART_LINK_CONFIRM_TIMEOUT       500     // ms
+    #define UART_LINK_KEEPALIVE_TIMEOUT     3000    // ms
+
+    #define UART_LINK_PATTERN_SIZE          48
+    #define UART_LINK_RX_SIZE               24      // Largest frame from the monitor, COBS encoded
+
+    // Link states
+    #define UART_LINK_IDLE                  0       // At SCI_FREQ
+    #define UART_LINK_SWITCHING             1       // Waiting for the transmitter to switch
+    #define UART_LINK_TESTING               2       // At the new rate, waiting for LINK_CONFIRM
+    #define UART_LINK_ACTIVE                3       // At the negotiated rate
+    #define UART_LINK_REVERTING             4       // Waiting for the transmitter to fall back
+
+    /**
+     * @brief Link status
+     */
+    typedef struct {
+        uint16_t state;
+        uint16_t timer;                     // ms in the current state
+        uint16_t test_sent;
+        uint32_t pending_baud;
+        uint32_t requests;
+        uint32_t switches;                  // Rates confirmed by the monitor
+        uint32_t fallbacks;
+        uint32_t rx_errors;                 // Bad frames and receiver errors
+    } UartLinkStatus;
+
+    extern UartLinkStatus uart_link_status;
+
+    /**
+     * @brief Test pattern byte: 0x00, 0xFF, 0x55, 0xAA, then a sequence
+     *        stepping through all byte values
+     */
+    static inline uint16_t uart_link_pattern(uint16_t index) {
+        static const uint16_t head[4] = {0x00, 0xFF, 0x55, 0xAA};
+
+        return (index < 4) ? head[index] : ((index * 167 + 13) & 0xFF);
+    }
+
+    // Link functions
+    void uart_link_receive(uint16_t byte);
+    uint16_t uart_link_service(void);
+
+#endif /* UART_LINK_H */
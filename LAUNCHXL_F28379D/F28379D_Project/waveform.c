@@ -0,0 +1,206 @@
+/**
+ * @file waveform.c
+ * @brief Implementation of the waveform streaming
+ *        adcc1_isr fills the sample ring, waveform_task empties it in
+ *        delta encoded, bit packed blocks sent as telemetry frames.
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "waveform.h"
+
+WaveformRing waveform_ring = {0};
+WaveformStats waveform_stats = {0};
+
+// Index of the sample after the last one sent
+static uint32_t waveform_index = 0;
+
+/**
+ * @brief Bit stream writer, LSB first, one byte per word
+ */
+typedef struct {
+    uint16_t *buffer;
+    uint16_t length;                // Complete bytes written
+    uint32_t accumulator;
+    uint16_t bits;                  // Bits held in the accumulator
+} BitWriter;
+
+static inline void bit_writer_put(BitWriter *writer, uint16_t value, uint16_t width) {
+    writer->accumulator |= (uint32_t)value << writer->bits;
+    writer->bits += width;
+
+    while (writer->bits >= 8) {
+        writer->buffer[writer->length++] = (uint16_t)writer->accumulator & 0xFF;
+        writer->accumulator >>= 8;
+        writer->bits -= 8;
+    }
+
+    return;
+}
+
+static inline void bit_writer_flush(BitWriter *writer) {
+    if (writer->bits > 0)
+        writer->buffer[writer->length++] = (uint16_t)writer->accumulator & 0xFF;
+
+    writer->accumulator = 0;
+    writer->bits = 0;
+
+    return;
+}
+
+/**
+ * @brief Zigzag encoded difference of two codes: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+ */
+static inline uint16_t waveform_delta(uint16_t current, uint16_t previous) {
+    int16_t delta = (int16_t)(current - previous);
+
+    return (delta >= 0) ? (uint16_t)(2 * delta) : (uint16_t)(-2 * delta - 1);
+}
+
+/**
+ * @brief Bits needed to hold a value
+ */
+static inline uint16_t waveform_width(uint16_t value) {
+    uint16_t width = 0;
+
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+
+    return width;
+}
+
+/**
+ * @brief Record the latest conversion, called by adcc1_isr
+ *        once adc_channels_sample has run. Keeps one conversion out of
+ *        WAVEFORM_DECIMATION. A full ring drops the sample; the next
+ *        recorded one carries the gap. The codes are those the channel
+ *        table writes to MEDIDA, so the voltage is the DMA or burst average
+ *        when enabled.
+ * @return void
+ */
+void waveform_capture(void) {
+    WaveformSample *sample;
+    uint16_t next;
+
+    if (waveform_stats.decimation > 0) {
+        waveform_stats.decimation--;
+        return;
+    }
+    waveform_stats.decimation = WAVEFORM_DECIMATION - 1;
+
+    next = (waveform_ring.head + 1) & (WAVEFORM_BUFFER_SIZE - 1);
+
+    if (next == waveform_ring.tail) {
+        waveform_stats.dropped++;
+        waveform_stats.pending_skip++;
+        return;
+    }
+
+    sample = &waveform_ring.samples[waveform_ring.head];
+    sample->code[0] = medidasADC.leituras_dig[Tensao_DC] & 0x0FFF;
+    sample->code[1] = medidasADC.leituras_dig[Corrente_carga] & 0x0FFF;
+    sample->code[2] = EPWM1_Modulante_CMPA & 0x0FFF;
+    sample->skipped = waveform_stats.pending_skip;
+
+    waveform_stats.pending_skip = 0;
+    waveform_stats.captured++;
+
+    waveform_ring.head = next;
+
+    return;
+}
+
+/**
+ * @brief Samples waiting in the ring
+ * @return uint16_t Number of samples
+ */
+uint16_t waveform_available(void) {
+    return (waveform_ring.head - waveform_ring.tail) & (WAVEFORM_BUFFER_SIZE - 1);
+}
+
+/**
+ * @brief Send the oldest samples as one waveform block
+ *        Up to WAVEFORM_BLOCK_SAMPLES consecutive samples, fewer when the
+ *        deltas are too wide for the payload. Not reentrant, the caller
+ *        holds communication_semaphore.
+ * @return uint16_t Samples sent
+ */
+uint16_t waveform_send_block(void) {
+    static uint16_t payload[TELEMETRY_MAX_PAYLOAD];
+    const WaveformSample *sample, *previous;
+    BitWriter writer = {0};
+    uint16_t width[WAVEFORM_CHANNELS] = {0};
+    uint16_t tail = waveform_ring.tail;
+    uint16_t available, count, fit, bits, channel, x;
+    uint32_t first_index;
+
+    available = waveform_available();
+    if (available == 0)
+        return 0;
+
+    if (available > WAVEFORM_BLOCK_SAMPLES)
+        available = WAVEFORM_BLOCK_SAMPLES;
+
+    // Delta widths, the block ends before the next gap
+    previous = &waveform_ring.samples[tail];
+    for (count = 1; count < available; count++) {
+        sample = &waveform_ring.samples[(tail + count) & (WAVEFORM_BUFFER_SIZE - 1)];
+        if (sample->skipped)
+            break;
+
+        for (channel = 0; channel < WAVEFORM_CHANNELS; channel++) {
+            bits = waveform_width(waveform_delta(sample->code[channel], previous->code[channel]));
+            if (bits > width[channel])
+                width[channel] = bits;
+        }
+
+        previous = sample;
+    }
+
+    bits = width[0] + width[1] + width[2];
+    if (bits > 0) {
+        fit = 1 + (WAVEFORM_BLOCK_BITS - WAVEFORM_CHANNELS * (WAVEFORM_WIDTH_BITS + WAVEFORM_CODE_BITS)) / bits;
+        if (count > fit)
+            count = fit;
+    }
+
+    // Header
+    sample = &waveform_ring.samples[tail];
+    first_index = waveform_index + sample->skipped;
+
+    telemetry_put_u32(payload + 0, first_index);
+    telemetry_put_u32(payload + 4, waveform_stats.dropped);
+    telemetry_put_u16(payload + 8, WAVEFORM_SAMPLE_PERIOD);
+    payload[10] = count;
+
+    // Bit stream
+    writer.buffer = payload + WAVEFORM_HEADER_SIZE;
+
+    for (channel = 0; channel < WAVEFORM_CHANNELS; channel++)
+        bit_writer_put(&writer, width[channel], WAVEFORM_WIDTH_BITS);
+
+    for (channel = 0; channel < WAVEFORM_CHANNELS; channel++)
+        bit_writer_put(&writer, sample->code[channel], WAVEFORM_CODE_BITS);
+
+    for (x = 1; x < count; x++) {
+        previous = sample;
+        sample = &waveform_ring.samples[(tail + x) & (WAVEFORM_BUFFER_SIZE - 1)];
+
+        for (channel = 0; channel < WAVEFORM_CHANNELS; channel++)
+            bit_writer_put(&writer, waveform_delta(sample->code[channel], previous->code[channel]), width[channel]);
+    }
+
+    bit_writer_flush(&writer);
+
+    telemetry_send_frame(TELEMETRY_FRAME_WAVEFORM, payload, WAVEFORM_HEADER_SIZE + writer.length);
+
+    waveform_ring.tail = (tail + count) & (WAVEFORM_BUFFER_SIZE - 1);
+    waveform_index = first_index + count;
+
+    waveform_stats.sent += count;
+    waveform_stats.blocks++;
+
+    return count;
+}
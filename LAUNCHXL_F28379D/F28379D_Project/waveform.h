@@ -0,0 +1,95 @@
+/**
+ * @file waveform.h
+ * @brief Waveform streaming of the control loop samples over SCI-C
+ *        Enabled with WAVEFORM_STREAM_MODE in peripheral_Setup.h
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+    #include "peripheral_Setup.h"
+    #include "telemetry.h"
+
+    #if (WAVEFORM_STREAM_MODE == WAVEFORM_STREAM_ENABLED) && (TELEMETRY_FORMAT != TELEMETRY_BINARY)
+        #error "Waveform streaming needs TELEMETRY_FORMAT == TELEMETRY_BINARY"
+    #endif
+
+    /**
+     * @brief Capture
+     *        adcc1_isr records every WAVEFORM_DECIMATION-th conversion
+     *        (output voltage code, load current code, CMPA) into the
+     *        sample ring. A full ring drops the sample and counts it, so
+     *        the control loop never waits for the link.
+     */
+    #define WAVEFORM_ADC_RATE       20000   // Conversions per second (EPWM1 SOCA or Timer0, 50 us)
+    #define WAVEFORM_DECIMATION     4       // 5 kHz sample rate
+    #define WAVEFORM_BUFFER_SIZE    256     // Samples, power of two
+
+    // Sample period in units of 100 ns, sent in every block
+    #define WAVEFORM_SAMPLE_PERIOD  ((uint16_t)(10000000UL * WAVEFORM_DECIMATION / WAVEFORM_ADC_RATE))
+
+    /**
+     * @brief Block payload of a TELEMETRY_FRAME_WAVEFORM frame, bytes
+     *        [0..3]   index of the first sample (samples since start)
+     *        [4..7]   samples dropped on the ring since start
+     *        [8..9]   sample period (100 ns)
+     *        [10]     number of samples in the block
+     *        [11..]   bit stream, LSB first:
+     *                   3 x 4 bits  delta widths of voltage, current, CMPA
+     *                   3 x 12 bits first sample
+     *                   per further sample, the zigzag encoded difference
+     *                   to the previous one in the width of each channel
+     *        A block never spans a drop, so the samples of a block are
+     *        consecutive
+     */
+    #define WAVEFORM_HEADER_SIZE    11
+    #define WAVEFORM_BLOCK_SAMPLES  32
+    #define WAVEFORM_BLOCK_BITS     ((TELEMETRY_MAX_PAYLOAD - WAVEFORM_HEADER_SIZE) * 8)
+    #define WAVEFORM_CODE_BITS      12
+    #define WAVEFORM_WIDTH_BITS     4
+
+    #define WAVEFORM_TASK_PERIOD    5       // ms
+
+    #define WAVEFORM_CHANNELS       3
+
+    /**
+     * @brief Recorded sample
+     */
+    typedef struct {
+        uint16_t code[WAVEFORM_CHANNELS];   // Output voltage, load current, CMPA
+        uint16_t skipped;                   // Samples dropped just before this one
+    } WaveformSample;
+
+    /**
+     * @brief Sample ring buffer
+     *        Single producer (adcc1_isr), single consumer (waveform_task)
+     */
+    typedef struct {
+        WaveformSample samples[WAVEFORM_BUFFER_SIZE];
+        volatile uint16_t head;             // Next free slot, written by adcc1_isr
+        volatile uint16_t tail;             // Next sample to send, written by waveform_task
+    } WaveformRing;
+
+    /**
+     * @brief Streaming statistics
+     */
+    typedef struct {
+        uint32_t captured;
+        uint32_t dropped;                   // Samples lost to a full ring
+        uint32_t sent;
+        uint32_t blocks;
+        uint16_t decimation;                // Conversions left before the next sample
+        uint16_t pending_skip;              // Drops since the last recorded sample
+    } WaveformStats;
+
+    extern WaveformRing waveform_ring;
+    extern WaveformStats waveform_stats;
+
+    // Waveform functions
+    void waveform_capture(void);
+    uint16_t waveform_available(void);
+    uint16_t waveform_send_block(void);
+
+#endif /* WAVEFORM_H */
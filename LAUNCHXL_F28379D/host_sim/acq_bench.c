@@ -0,0 +1,193 @@
+/**
+ * @file acq_bench.c
+ * @brief Host benchmark of the table-driven ADC acquisition
+ *
+ * Times the acquisition part of adcc1_isr two ways on the same ADC result
+ * registers: adc_channels_sample, which writes every channel to its
+ * destination, and the hand-written per-channel reads and scaling it
+ * replaced (single-conversion mode). Both are checked to give the same
+ * codes and values. The host compiler and CPU are not the C28x: the ratio
+ * is the figure to compare, adcc1_isr on the target keeps its own count in
+ * acquisition_stats.isr_cycles.
+ *
+ * Usage: acq_bench [SAMPLES]
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+#include "adc_channels.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if (ADC_ACQUISITION_MODE != ADC_ACQUISITION_SINGLE)
+    #error "acq_bench compares the single-conversion acquisition"
+#endif
+
+// Benchmark parameters
+#define BENCH_SAMPLES           20000000    // Default samples per variant
+#define BENCH_TOLERANCE         1e-6f       // Relative difference of the values
+
+/**
+ * @brief Outputs of one acquisition, as acquisition_step leaves them
+ */
+typedef struct {
+    uint16_t code[4];                   // Voltage, current, input, setpoint
+    float value[4];
+} BenchResult;
+
+static BenchResult hand_written, table;
+
+/**
+ * @brief Wall-clock time
+ * @return double Seconds
+ */
+static double bench_wall_time(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Results of one conversion, different on every sample
+ * @param n Sample
+ * @return void
+ */
+static inline void bench_results(uint32_t n) {
+    AdcbResultRegs.ADCRESULT0 = n & 0x0FFF;
+    AdccResultRegs.ADCRESULT0 = (n * 3) & 0x0FFF;
+    (&AdcbResultRegs.ADCRESULT0)[ADC_INPUT_SOC] = (n * 5) & 0x0FFF;
+    AdcaResultRegs.ADCRESULT0 = (n * 7) & 0x0FFF;
+
+    return;
+}
+
+/**
+ * @brief Loop and register writes only, subtracted from both variants
+ */
+static __attribute__((noinline)) void bench_empty(uint32_t n) {
+    bench_results(n);
+
+    return;
+}
+
+/**
+ * @brief Per-channel reads and scaling before the channel table
+ */
+static __attribute__((noinline)) void bench_hand_written(uint32_t n) {
+    bench_results(n);
+
+    medidasADC.leituras_dig[Tensao_DC] = AdcbResultRegs.ADCRESULT0;
+    medidasADC.leituras_dig[Corrente_carga] = AdccResultRegs.ADCRESULT0;
+    medidasADC.valor_real[Tensao_DC] = medidasADC.leituras_dig[Tensao_DC] * VOLTAGE_CONVERSION_FACTOR;
+    medidasADC.valor_real[Corrente_carga] = medidasADC.leituras_dig[Corrente_carga] * CURRENT_CONVERSION_FACTOR;
+
+    input_monitor.raw = (&AdcbResultRegs.ADCRESULT0)[ADC_INPUT_SOC];
+    input_monitor.voltage = (input_monitor.raw * input_monitor.conv_factor);
+
+    hand_written.value[3] = (AdcaResultRegs.ADCRESULT0 / MAX_ADC) * MAX_VOLTAGE;
+    hand_written.code[3] = AdcaResultRegs.ADCRESULT0;
+
+    return;
+}
+
+/**
+ * @brief adc_channels_sample, the rows write MEDIDA, input_monitor and
+ *        the setpoint sample
+ */
+static __attribute__((noinline)) void bench_table(uint32_t n) {
+    bench_results(n);
+
+    adc_channels_sample();
+
+    return;
+}
+
+/**
+ * @brief Keep the outputs of the last call
+ * @param result Destination
+ * @return void
+ */
+static void bench_store(BenchResult *result) {
+    result->code[0] = medidasADC.leituras_dig[Tensao_DC];
+    result->code[1] = medidasADC.leituras_dig[Corrente_carga];
+    result->code[2] = input_monitor.raw;
+    result->value[0] = medidasADC.valor_real[Tensao_DC];
+    result->value[1] = medidasADC.valor_real[Corrente_carga];
+    result->value[2] = input_monitor.voltage;
+
+    return;
+}
+
+/**
+ * @brief Time one variant
+ * @param variant Acquisition to run
+ * @param samples Calls
+ * @return double Seconds
+ */
+static double bench_time(void (*variant)(uint32_t), uint32_t samples) {
+    double start = bench_wall_time();
+    uint32_t n;
+
+    for (n = 0; n < samples; n++)
+        variant(n);
+
+    return bench_wall_time() - start;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t samples = BENCH_SAMPLES, n;
+    uint16_t mismatches = 0;
+    double empty, hand_time, table_time;
+    int x;
+
+    if (argc > 1)
+        samples = strtoul(argv[1], NULL, 10);
+
+    if (samples == 0) {
+        fprintf(stderr, "usage: %s [SAMPLES]\n", argv[0]);
+        return 1;
+    }
+
+    // Same outputs over every code
+    for (n = 0; n < 4096; n++) {
+        bench_hand_written(n);
+        bench_store(&hand_written);
+        bench_table(n);
+        bench_store(&table);
+        table.code[3] = setpoint_filter.raw;
+        table.value[3] = setpoint_filter.sample;
+
+        for (x = 0; x < 4; x++) {
+            if ((hand_written.code[x] != table.code[x]) ||
+                (fabsf(hand_written.value[x] - table.value[x]) > BENCH_TOLERANCE * (fabsf(hand_written.value[x]) + 1.0f)))
+                mismatches++;
+        }
+    }
+
+    // Warm up, then the best of five runs of each
+    bench_time(bench_table, samples / 10);
+    empty = hand_time = table_time = 1e9;
+    for (x = 0; x < 5; x++) {
+        empty = fmin(empty, bench_time(bench_empty, samples));
+        hand_time = fmin(hand_time, bench_time(bench_hand_written, samples));
+        table_time = fmin(table_time, bench_time(bench_table, samples));
+    }
+
+    hand_time = (hand_time - empty) / samples * 1e9;
+    table_time = (table_time - empty) / samples * 1e9;
+
+    printf("Acquisition of %d channels, %u samples (host ns per sample, loop subtracted)\n",
+           ADC_CHANNELS, (unsigned)samples);
+    printf("hand-written per channel    %6.2f\n", hand_time);
+    printf("channel table               %6.2f  (%.2fx)\n", table_time, table_time / hand_time);
+    printf("Outputs over 4096 codes: %s\n", mismatches ? "MISMATCH" : "identical");
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file buck_plant.c
+ * @brief Implementation of the averaged buck converter model
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "buck_plant.h"
+
+/**
+ * @brief Load the default power stage, discharged
+ * @param plant The plant to initialize
+ * @return void
+ */
+void buck_plant_init(BuckPlant *plant) {
+    plant->vin = BUCK_VIN;
+    plant->l = BUCK_L;
+    plant->r_l = BUCK_R_L;
+    plant->c = BUCK_C;
+    plant->r_load = BUCK_R_LOAD;
+
+    plant->i_l = 0.0;
+    plant->v_out = 0.0;
+
+    return;
+}
+
+/**
+ * @brief Integrate the plant over dt with a constant duty cycle
+ *        Semi-implicit Euler: the capacitor uses the updated inductor
+ *        current, which keeps the lightly damped LC stage stable for
+ *        dt well below its resonance period
+ * @param plant The plant to advance
+ * @param duty Switch duty cycle, [0, 1]
+ * @param dt Timestep (s)
+ * @return void
+ */
+void buck_plant_step(BuckPlant *plant, double duty, double dt) {
+    double v_l;
+
+    if (duty < 0.0)
+        duty = 0.0;
+    if (duty > 1.0)
+        duty = 1.0;
+
+    v_l = duty * plant->vin - plant->v_out - plant->r_l * plant->i_l;
+
+    plant->i_l += v_l / plant->l * dt;
+    if (plant->i_l < 0.0)
+        plant->i_l = 0.0;
+
+    plant->v_out += (plant->i_l - plant->v_out / plant->r_load) / plant->c * dt;
+
+    return;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file buck_plant.h
+ * @brief Averaged model of the buck converter power stage
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef BUCK_PLANT_H
+#define BUCK_PLANT_H
+
+    // Default power stage, set to the values of the actual board
+    #define BUCK_VIN            12.0        // Input voltage (V)
+    #define BUCK_L              1.0e-3      // Inductance (H)
+    #define BUCK_R_L            0.10        // Inductor series resistance (ohm)
+    #define BUCK_C              10.0e-6     // Output capacitance (F)
+    #define BUCK_R_LOAD         10.0        // Load resistance (ohm)
+
+    /**
+     * @brief Power stage parameters and state
+     *        The switch is averaged over the PWM period. The freewheeling
+     *        diode blocks a negative inductor current (discontinuous mode).
+     */
+    typedef struct {
+        double vin;
+        double l;
+        double r_l;
+        double c;
+        double r_load;
+
+        double i_l;                     // Inductor current (A)
+        double v_out;                   // Capacitor voltage (V)
+    } BuckPlant;
+
+    void buck_plant_init(BuckPlant *plant);
+    void buck_plant_step(BuckPlant *plant, double duty, double dt);
+
+#endif /* BUCK_PLANT_H */
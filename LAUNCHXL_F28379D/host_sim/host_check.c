@@ -0,0 +1,75 @@
+/**
+ * @file host_check.c
+ * @brief Host run of the firmware verification routines
+ *
+ * Built with the verification defines of the firmware (CHECK_FLAGS in
+ * the Makefile), so controller_init runs the same checks it runs on the
+ * target. Each check is reported and the exit status is non-zero when
+ * any of them fails. Cycle counts are those of the host counter mock.
+ *
+ * Usage: host_check
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+#include "controllers.h"
+#include "controllers_fixed.h"
+#include "cla_control.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Report one check
+ * @param name Check
+ * @param pass Check result
+ * @return uint16_t 1 if the check failed
+ */
+static uint16_t check_report(const char *name, uint16_t pass) {
+    printf("%-40s %s\n", name, pass ? "pass" : "FAIL");
+
+    return pass ? 0 : 1;
+}
+
+int main(void) {
+    uint16_t failed = 0;
+    char name[64];
+    int t;
+
+    controller_init(PI_CONTROLLER);
+
+#ifdef NN_BENCHMARK
+    // Fused training path against the recomputing reference
+    failed += check_report("NN fused vs recomputing training", nn_benchmark.bit_exact);
+
+    // Generated kernels against the loop kernels
+    for (t = 0; t < NN_KERNEL_BENCHMARK_TOPOLOGIES; t++) {
+        snprintf(name, sizeof(name), "NN unrolled vs loop kernel %u-%u-%u-1", nn_kernel_benchmark[t].inputs,
+                 nn_kernel_benchmark[t].hidden1, nn_kernel_benchmark[t].hidden2);
+        failed += check_report(name, nn_kernel_benchmark[t].bit_exact);
+    }
+#endif
+
+#ifdef FIXED_ERROR_CHECK
+    // Q24/Q15 controllers against the float controllers
+    printf("Fixed point: PI %.2e, NN %.2e over %lu points (bound %.0e)\n", fixed_error_check.pi_max_error,
+           fixed_error_check.nn_max_error, (unsigned long)fixed_error_check.points, FIXED_ERROR_BOUND);
+    failed += check_report("Fixed vs float controllers", fixed_error_check.pass);
+#endif
+
+#ifdef CLA_ERROR_CHECK
+    // CLA control law against the C28x controller, run by peripheral_Setup
+    // after pwm_init on the target
+    pwm_init();
+    controller_cla_error_check();
+
+    printf("CLA control law: duty %.2e, CMPA %u over %lu points (bound %.0e)\n", cla_error_check.duty_max_error,
+           cla_error_check.cmpa_max_error, (unsigned long)cla_error_check.points, CLA_ERROR_BOUND);
+    failed += check_report("CLA vs C28x control law", cla_error_check.pass);
+#endif
+
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+
+    return failed ? 1 : 0;
+}
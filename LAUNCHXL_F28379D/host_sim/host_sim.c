@@ -0,0 +1,286 @@
+/**
+ * @file host_sim.c
+ * @brief Closed-loop host simulation of the buck converter control stack
+ *
+ * Every PWM period the plant is sampled into the ADC result registers,
+ * adcc1_isr runs the firmware acquisition step and controller, and the
+ * duty cycle loaded in EPWM1 drives the averaged buck model for
+ * SIM_SUBSTEPS sub-periods. Each registered controller is run in turn
+ * from a discharged output to the setpoint, and its settling time,
+ * overshoot, steady-state error and simulation throughput are reported.
+ *
+ * Usage: host_sim [SETPOINT_V [DURATION_S]]
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+#include "controllers.h"
+#include "cla_control.h"
+#include "nn_ipc.h"
+#include "adc_dma.h"
+#include "adc_burst.h"
+#include "measurement_stats.h"
+#include "buck_plant.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Simulation parameters
+#define SIM_PWM_FREQ            20000.0                         // adcc1_isr rate (Hz)
+#define SIM_SUBSTEPS            50                              // Plant steps per PWM period
+#define SIM_SETPOINT            5.0f                            // Default setpoint (V)
+#define SIM_DURATION            0.2                             // Default run per controller (s)
+#define SIM_STEADY_FRACTION     0.1                             // Final part of the run for the steady-state error
+#define SIM_OFF_PERIODS         (2 * SIZE_ADC_READINGS)         // Converter off between runs
+#define SIM_TICK_PERIODS        ((uint32_t)(SIM_PWM_FREQ / 1000.0)) // PWM periods per FreeRTOS tick
+#define SIM_CYCLES_PER_PERIOD   ((uint32_t)(CPU_FREQ / SIM_PWM_FREQ))
+
+/**
+ * @brief Step response of one controller
+ */
+typedef struct {
+    const char *name;
+    double settling_time;       // Time to stay within SETTLE_BAND (s), < 0 if never
+    double overshoot;           // Peak above the setpoint (%)
+    double steady_state_error;  // Mean setpoint minus output over the final part (V)
+    double throughput;          // Simulated seconds per wall-clock second
+} SimResult;
+
+static BuckPlant plant;
+static uint32_t sim_periods = 0;
+
+#if (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+static NeuralNetwork cpu2_network;  // main_cpu2.c network
+#endif
+
+/**
+ * @brief Quantize a value to a 12-bit ADC result
+ * @param value Measured value
+ * @param conv_factor Firmware conversion factor (value per count)
+ * @return Uint16 The ADC result
+ */
+static Uint16 sim_adc_counts(double value, double conv_factor) {
+    double counts = value / conv_factor + 0.5;
+
+    if (counts < 0.0)
+        return 0;
+    if (counts > MAX_ADC)
+        return (Uint16)MAX_ADC;
+
+    return (Uint16)counts;
+}
+
+/**
+ * @brief Sample the plant into the ADC result registers, as SOCA at
+ *        CTR = 0 does on the target (see adc_init)
+ *        Every SOC of a Tensao_DC or Corrente_carga burst takes the same
+ *        sample: the burst is short against the plant dynamics
+ * @param setpoint Setpoint potentiometer voltage (V)
+ * @return void
+ */
+static void sim_adc_convert(float setpoint) {
+    int x;
+
+    AdcaResultRegs.ADCRESULT0 = sim_adc_counts(setpoint, MAX_VOLTAGE / MAX_ADC);
+
+    for (x = 0; x < ADC_BURST_SIZE; x++) {
+        (&AdcbResultRegs.ADCRESULT0)[x] = sim_adc_counts(plant.v_out, VOLTAGE_CONVERSION_FACTOR);
+        (&AdccResultRegs.ADCRESULT0)[x] = sim_adc_counts(plant.i_l * 1000.0, CURRENT_CONVERSION_FACTOR);
+    }
+
+    (&AdcbResultRegs.ADCRESULT0)[ADC_INPUT_SOC] = sim_adc_counts(plant.vin, INPUT_CONVERSION_FACTOR);
+
+    return;
+}
+
+/**
+ * @brief Press (0) or release (1) the start and stop buttons
+ */
+static void sim_buttons(Uint16 start, Uint16 stop) {
+    GpioDataRegs.GPCDAT.bit.GPIO67 = start;
+    GpioDataRegs.GPDDAT.bit.GPIO111 = stop;
+
+    return;
+}
+
+/**
+ * @brief Simulate one PWM period
+ *        CMPA is shadow-loaded at CTR = 0, so the value written by this
+ *        period's ISR drives the plant from the next period on
+ *        With ADC_ACQUISITION_DMA, Tensao_DC is also sampled into the DMA
+ *        buffer half of the running transfer at the middle of every slot
+ * @param setpoint Setpoint potentiometer voltage (V)
+ * @return void
+ */
+static void sim_period(float setpoint) {
+    const double dt = 1.0 / (SIM_PWM_FREQ * SIM_SUBSTEPS);
+    double duty;
+    int x;
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+    int sample = 0;
+#endif
+
+    duty = (double)EPwm1Regs.CMPA.bit.CMPA / EPwm1Regs.TBPRD;
+
+    sim_adc_convert(setpoint);
+    IpcRegs.IPCCOUNTERL += SIM_CYCLES_PER_PERIOD;
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    Cla1Task1();
+#endif
+    adcc1_isr();
+
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_TASK)
+    controller_step();
+#endif
+
+    // nn_training_task, woken every NN_TRAINING_PERIOD ticks
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FLOAT) && (NN_TRAINING_MODE != NN_TRAINING_INLINE)
+    if (++sim_periods % (NN_TRAINING_PERIOD * SIM_TICK_PERIODS) == 0)
+        neural_network_training_service();
+#endif
+
+    // CPU2 training loop, emptying the ring every period
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FLOAT) && (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+    nn_ipc_train(&cpu2_network);
+#endif
+
+    for (x = 0; x < SIM_SUBSTEPS; x++) {
+#if (ADC_ACQUISITION_MODE == ADC_ACQUISITION_DMA)
+        // EPWM2 SOCA at the middle of every slot, DMA CH1 into the half
+        // of the running transfer
+        if ((sample < ADC_DMA_OVERSAMPLING) &&
+            (x == (2 * sample + 1) * SIM_SUBSTEPS / (2 * ADC_DMA_OVERSAMPLING))) {
+            AdcbResultRegs.ADCRESULT0 = sim_adc_counts(plant.v_out, VOLTAGE_CONVERSION_FACTOR);
+            adc_dma_buffer[adc_dma.half ^ 1][sample++] = AdcbResultRegs.ADCRESULT0;
+        }
+#endif
+        buck_plant_step(&plant, duty, dt);
+    }
+
+    return;
+}
+
+/**
+ * @brief Wall-clock time
+ * @return double Seconds
+ */
+static double sim_wall_time(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Step response of a controller from a discharged output
+ * @param controller_type Registry index of the controller
+ * @param setpoint Setpoint (V)
+ * @param duration Simulated time (s)
+ * @param result Step response
+ * @return void
+ */
+static void sim_run(uint8_t controller_type, float setpoint, double duration, SimResult *result) {
+    const uint32_t periods = (uint32_t)(duration * SIM_PWM_FREQ);
+    const uint32_t steady_start = periods - (uint32_t)(periods * SIM_STEADY_FRACTION);
+    double reference, band, v_max, error_sum, last_outside, start;
+    uint32_t n;
+
+    // Stop the converter: the controller is reset and the output discharged
+    controller_select(controller_type);
+    buck_plant_init(&plant);
+
+    sim_buttons(1, 0);
+    for (n = 0; n < SIM_OFF_PERIODS; n++)
+        sim_period(0.0f);
+    sim_buttons(1, 1);
+
+    // Setpoint as quantized by the ADC
+    reference = sim_adc_counts(setpoint, MAX_VOLTAGE / MAX_ADC) * (MAX_VOLTAGE / MAX_ADC);
+    band = SETTLE_BAND * reference;
+    v_max = 0.0;
+    error_sum = 0.0;
+    last_outside = 0.0;
+
+    // Start and step the setpoint
+    sim_buttons(0, 1);
+    sim_period(setpoint);
+    sim_buttons(1, 1);
+
+    start = sim_wall_time();
+
+    for (n = 1; n < periods; n++) {
+        sim_period(setpoint);
+
+        if (plant.v_out > v_max)
+            v_max = plant.v_out;
+
+        if (fabs(plant.v_out - reference) > band)
+            last_outside = (n + 1) / SIM_PWM_FREQ;
+
+        if (n >= steady_start)
+            error_sum += reference - plant.v_out;
+    }
+
+    result->throughput = duration / (sim_wall_time() - start);
+
+    result->name = controller_registry[controller_type].name;
+    result->settling_time = (last_outside < duration) ? last_outside : -1.0;
+    result->overshoot = (v_max > reference) ? 100.0 * (v_max - reference) / reference : 0.0;
+    result->steady_state_error = error_sum / (periods - steady_start);
+
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    SimResult result;
+    float setpoint = SIM_SETPOINT;
+    double duration = SIM_DURATION;
+    uint8_t x;
+
+    if (argc > 1)
+        setpoint = strtof(argv[1], NULL);
+    if (argc > 2)
+        duration = strtod(argv[2], NULL);
+
+    if (setpoint <= 0.0f || setpoint >= 0.95f * BUCK_VIN || duration * SIM_PWM_FREQ < 1.0 / SIM_STEADY_FRACTION) {
+        fprintf(stderr, "usage: %s [SETPOINT_V (0, %.1f) [DURATION_S]]\n", argv[0], 0.95 * BUCK_VIN);
+        return 1;
+    }
+
+    // Firmware initialization against the register mocks. adc_init is
+    // not run: InitADC reads the calibration from the device OTP
+    controller_init(PI_CONTROLLER);
+    pwm_init();
+    measurement_stats_init();
+#if (CONTROL_LOOP_MODE == CONTROL_LOOP_CLA)
+    cla_control_load();
+#endif
+#if (CONTROLLER_ARITHMETIC == CONTROLLER_FLOAT) && (NN_TRAINING_MODE == NN_TRAINING_CPU2)
+    nn_ipc_cpu2_init();
+#endif
+
+    buck_plant_init(&plant);
+
+    printf("Buck plant: Vin %.1f V, L %.0f uH, C %.0f uF, R %.1f ohm, %.0f kHz PWM, %d substeps\n",
+           plant.vin, plant.l * 1e6, plant.c * 1e6, plant.r_load, SIM_PWM_FREQ / 1000.0, SIM_SUBSTEPS);
+    printf("Setpoint %.2f V, %.3f s per controller\n\n", setpoint, duration);
+    printf("%-12s %14s %14s %14s %14s\n", "controller", "settling (ms)", "overshoot (%)", "ss error (V)", "sim/wall");
+
+    for (x = 0; x < CONTROLLER_COUNT; x++) {
+        sim_run(x, setpoint, duration, &result);
+
+        if (result.settling_time >= 0.0)
+            printf("%-12s %14.2f", result.name, result.settling_time * 1000.0);
+        else
+            printf("%-12s %14s", result.name, "-");
+
+        printf(" %14.2f %14.4f %13.0fx\n", result.overshoot, result.steady_state_error, result.throughput);
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file host_target.c
+ * @brief Host definitions of the C28x core registers, intrinsics and
+ *        assembly routines the firmware links against
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+#include "nn_snapshot.h"
+#include "cla_control.h"
+
+// Core registers (cregister on the C28x)
+volatile unsigned int IFR = 0;
+volatile unsigned int IER = 0;
+
+NNSnapshotStatus nn_snapshot_status = {0};
+
+void (*host_delay_hook)(uint32_t cycles) = NULL;
+
+// External definitions of the C99 inline functions of peripheral_Setup.h,
+// called when gcc does not inline them (e.g. at -O0)
+extern inline uint32_t read_cycle_counter(void);
+extern inline Uint16 bcd_to_decimal(Uint16 bcd);
+extern inline int int_to_char(int value, char* buffer);
+extern inline void measurement_read(Measurements *measurements);
+extern inline uint16_t uart_tx_free(void);
+extern inline void uart_send_char(char data);
+extern inline void uart_send_string(const char *str);
+extern inline void uart_send_int(int data);
+extern inline Uint16 i2c_wait_bus_ready(void);
+extern inline Uint16 ds3231_write_register(Uint16 reg_addr, Uint16 data);
+extern inline Uint16 ds3231_read_register(Uint16 reg_addr, Uint16* data);
+extern inline Uint16 ds3231_set_time_zero(void);
+extern inline Uint16 ds3231_init_and_set_zero(void);
+extern inline Uint16 ds3231_read_time(Uint16* hours, Uint16* minutes, Uint16* seconds);
+
+/**
+ * @brief Disable interrupts, return the previous ST1 state
+ * @return uint16_t The previous state, interrupts are never enabled on the host
+ */
+uint16_t __disable_interrupts(void) {
+    return 0;
+}
+
+/**
+ * @brief CLA Task 1 (cla_control.cla) built for the host, run by host_sim
+ *        before adcc1_isr as the CLA runs before its end of task interrupt
+ * @return void
+ */
+__interrupt void Cla1Task1(void) {
+    cla_control_task();
+
+    return;
+}
+
+/**
+ * @brief F2837xD_usDelay.asm busy loop, no simulated time elapses unless
+ *        a bench has set host_delay_hook
+ * @param LoopCount Loop iterations, 5 cycles each plus 9 of call overhead
+ * @return void
+ */
+void F28x_usDelay(long LoopCount) {
+    if (host_delay_hook)
+        host_delay_hook((uint32_t)(LoopCount * 5 + 9));
+
+    return;
+}
+
+/**
+ * @brief Flash is not modelled: no snapshot is ever found or written
+ */
+void nn_snapshot_init(void) {
+    return;
+}
+
+uint16_t nn_snapshot_load(NeuralNetwork *network) {
+    (void)network;
+
+    return 0;
+}
+
+uint16_t nn_snapshot_save(const NeuralNetwork *network) {
+    (void)network;
+
+    return 0;
+}
+
+void nn_snapshot_periodic(uint32_t elapsed_ms) {
+    (void)elapsed_ms;
+
+    return;
+}
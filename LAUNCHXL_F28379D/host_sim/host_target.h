@@ -0,0 +1,66 @@
+/**
+ * @file host_target.h
+ * @brief C28x compatibility layer for the host build of the firmware
+ *        Force-included in every translation unit (gcc -include). The TI
+ *        device headers are then compiled unchanged, so the register
+ *        structures of firmware_GlobalVariableDefs.c become plain host
+ *        variables: the register-mock layer the simulator writes ADC
+ *        results into and reads EPWM1 compare values from.
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#ifndef HOST_TARGET_H
+#define HOST_TARGET_H
+
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <stdint.h>
+
+    /**
+     * @brief Data types of F2837xD_device.h with host widths
+     *        int is 32-bit on the host: code depending on the 16-bit C28x
+     *        int or on sizeof counting 16-bit words behaves differently
+     */
+    #define DSP28_DATA_TYPES
+    #define F28_DATA_TYPES
+
+    typedef int16_t     int16;
+    typedef int32_t     int32;
+    typedef int64_t     int64;
+    typedef uint16_t    Uint16;
+    typedef uint32_t    Uint32;
+    typedef uint64_t    Uint64;
+    typedef float       float32;
+    typedef double      float64;
+
+    // C28x keywords
+    #define interrupt
+    #define __interrupt
+    #define cregister
+    #define __cregister
+
+    // Inline assembly (EALLOW, EDIS, EINT, DINT, ESTOP0...) has no effect,
+    // but stays a statement: "if (error) asm(" ESTOP0");" keeps a body
+    #define __asm(x)    ((void)0)
+    #define asm(x)      ((void)0)
+
+    // Driverlib headers pulled by peripheral_Setup.h but not used by the host build
+    #define SCI_H
+    #define DRIVER_INCLUSIVE_TERMINOLOGY_MAPPING_H_
+
+    // FreeRTOS is not built: the task-context critical sections of the
+    // firmware sources have nothing to mask on the single host thread
+    #define INC_FREERTOS_H
+    #define INC_TASK_H
+    #define taskENTER_CRITICAL()
+    #define taskEXIT_CRITICAL()
+
+    // C28x intrinsics
+    uint16_t __disable_interrupts(void);
+
+    // Called by DELAY_US with the SYSCLK cycles of the delay when set, so a
+    // bench can advance IPCCOUNTERL and its peripheral models (rtc_bench.c)
+    extern void (*host_delay_hook)(uint32_t cycles);
+
+#endif /* HOST_TARGET_H */
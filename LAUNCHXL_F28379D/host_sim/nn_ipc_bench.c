@@ -0,0 +1,107 @@
+/**
+ * @file nn_ipc_bench.c
+ * @brief Host benchmark of the CPU2 Neural Network training link
+ *
+ * Fills the CPU1 to CPU2 ring with swept samples (nn_ipc_push), empties it
+ * with the CPU2 training loop (nn_ipc_train) and reports the training
+ * throughput against the adcc1_isr sample rate, then takes the posted
+ * weights back on the CPU1 side (nn_ipc_fetch). Both sides run on the
+ * host thread, so the figures are those of the host, not of CPU2.
+ *
+ * Usage: nn_ipc_bench [ROUNDS]
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+#include "controllers.h"
+#include "nn_ipc.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Benchmark parameters
+#define BENCH_SAMPLE_RATE       20000.0     // adcc1_isr rate (Hz)
+#define BENCH_ROUNDS            20000       // Default ring fills
+
+static NeuralNetwork cpu2_network;  // main_cpu2.c network
+
+/**
+ * @brief Wall-clock time
+ * @return double Seconds
+ */
+static double bench_wall_time(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Fill the ring with samples swept over the input range
+ * @param index Index of the first sample
+ * @return void
+ */
+static void bench_fill(uint32_t index) {
+    float inputs[INPUT_SIZE];
+    float phase;
+    int x, n;
+
+    for (n = 0; n < NN_IPC_RING_SIZE; n++) {
+        phase = 0.001f * (float)(index + n);
+
+        for (x = 0; x < INPUT_SIZE; x++)
+            inputs[x] = sinf(phase * (x + 1));
+
+        nn_ipc_push(inputs, 0.01f * cosf(phase));
+    }
+
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t rounds = BENCH_ROUNDS;
+    uint32_t trained = 0, n;
+    double start, elapsed, rate;
+
+    if (argc > 1)
+        rounds = strtoul(argv[1], NULL, 10);
+
+    if (rounds == 0) {
+        fprintf(stderr, "usage: %s [ROUNDS]\n", argv[0]);
+        return 1;
+    }
+
+    // CPU1 posts the initial weights, CPU2 takes them before the first
+    // samples are queued (a load drops the samples queued before it)
+    controller_init(NNA_CONTROLLER);
+    nn_ipc_init(&neural_network);
+    nn_ipc_cpu2_init();
+    nn_ipc_train(&cpu2_network);
+
+    start = bench_wall_time();
+
+    for (n = 0; n < rounds; n++) {
+        bench_fill(n * NN_IPC_RING_SIZE);
+        trained += nn_ipc_train(&cpu2_network);
+    }
+
+    elapsed = bench_wall_time() - start;
+    rate = trained / elapsed;
+
+    printf("CPU2 training: %lu samples in %.3f s, %.0f samples/s (%.2fx the %.0f kHz sample rate)\n",
+           (unsigned long)trained, elapsed, rate, rate / BENCH_SAMPLE_RATE, BENCH_SAMPLE_RATE / 1000.0);
+
+    nn_ipc_fetch(&neural_network);
+
+    printf("CPU1 link: %lu updates, generation %lu, %lu retries, %lu dropped, %lu trained by CPU2\n",
+           (unsigned long)nn_ipc_stats.updates, (unsigned long)nn_ipc_stats.generation,
+           (unsigned long)nn_ipc_stats.retries, (unsigned long)nn_ipc_stats.dropped,
+           (unsigned long)nn_ipc_status.trained);
+
+    return (trained == rounds * NN_IPC_RING_SIZE) && (nn_ipc_stats.updates == 1) && (nn_ipc_stats.dropped == 0) ? 0 : 1;
+}
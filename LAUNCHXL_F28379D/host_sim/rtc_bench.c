@@ -0,0 +1,220 @@
+/**
+ * @file rtc_bench.c
+ * @brief Host benchmark of the DS3231 time read, polled against interrupt
+ *
+ * Runs the firmware I2C-B code (i2c_init, ds3231_read_time,
+ * ds3231_read_time_start, i2cb_isr) against a model of the I2C-B module
+ * and the DS3231. The model owns the status register and advances the bus
+ * on IPCCOUNTERL at the SCL rate set by i2c_init: DELAY_US moves the
+ * counter through host_delay_hook, so the polled read spins for the real
+ * bus time. Code between the status checks takes no simulated time: the
+ * figures are the cycles the CPU waits on the bus, the code itself is
+ * measured on the target (rtc_stats).
+ *
+ * Usage: rtc_bench [READS]
+ *
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include "peripheral_Setup.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Benchmark parameters
+#define BENCH_READS             1000        // Default reads per mode
+#define BENCH_CPU_FREQ          200e6       // SYSCLK (Hz)
+#define BENCH_SECONDS           0x42        // DS3231 register value returned (BCD)
+
+/**
+ * @brief I2C-B and DS3231 model
+ *        One transfer at a time, from a start to ARDY (no stop) or SCD
+ */
+typedef struct {
+    uint32_t bit_cycles;                // SYSCLK cycles per SCL period
+    uint16_t busy;                      // Transfer on the bus
+    uint16_t bus_busy;                  // BB, from a start to the stop
+    uint16_t stop;                      // Transfer ends with a stop
+    uint16_t receive;
+    uint16_t count;                     // Data bytes
+    uint32_t done;                      // IPCCOUNTERL at the end of the transfer
+    uint16_t flags;                     // ARDY and SCD, as I2CSTR bits
+    uint32_t transfers;
+    uint32_t interrupts;                // i2cb_isr entries
+} BenchBus;
+
+static BenchBus bus;
+static volatile uint16_t bench_complete;
+
+/**
+ * @brief Rewrite the status register with the model state
+ *        The firmware clears flags by writing ones, which sets them in a
+ *        plain host variable: the model state replaces whatever was written
+ */
+static void bench_bus_status(void) {
+    I2cbRegs.I2CSTR.all = bus.flags;
+    I2cbRegs.I2CSTR.bit.BB = bus.bus_busy;
+
+    return;
+}
+
+/**
+ * @brief Advance the model to the current IPCCOUNTERL
+ *        A start written to I2CMDR begins a transfer of start, address
+ *        byte and CNT data bytes (9 SCL periods each with the acknowledge)
+ *        and the stop if requested. Its end sets ARDY or SCD and enters
+ *        i2cb_isr when that interrupt is enabled
+ * @return void
+ */
+static void bench_bus_step(void) {
+    uint16_t event, mask;
+
+    if (!bus.busy && I2cbRegs.I2CMDR.bit.STT) {
+        I2cbRegs.I2CMDR.bit.STT = 0;
+
+        bus.stop = I2cbRegs.I2CMDR.bit.STP;
+        bus.receive = !I2cbRegs.I2CMDR.bit.TRX;
+        bus.count = I2cbRegs.I2CCNT;
+        bus.done = IpcRegs.IPCCOUNTERL + (1 + 9 * (1 + bus.count) + bus.stop) * bus.bit_cycles;
+        bus.flags = 0;
+        bus.busy = 1;
+        bus.bus_busy = 1;
+        bus.transfers++;
+    }
+
+    if (bus.busy && ((int32_t)(IpcRegs.IPCCOUNTERL - bus.done) >= 0)) {
+        bus.busy = 0;
+
+        if (bus.receive) {
+            I2cbRegs.I2CFFRX.bit.RXFFST = bus.count;
+            I2cbRegs.I2CDRR.all = BENCH_SECONDS;
+        }
+
+        if (bus.stop) {
+            I2cbRegs.I2CMDR.bit.STP = 0;
+            bus.bus_busy = 0;
+            bus.flags = 0x0020;                 // SCD
+            event = I2C_SCD_ISRC;
+        }
+        else {
+            bus.flags = 0x0004;                 // ARDY
+            event = I2C_ARDY_ISRC;
+        }
+
+        mask = bus.flags;
+        bench_bus_status();
+
+        if (I2cbRegs.I2CIER.all & mask) {
+            I2cbRegs.I2CISRC.bit.INTCODE = event;
+            bus.interrupts++;
+            i2cb_isr();
+
+            // Acknowledged by i2cb_isr, which may have started the next transfer
+            bus.flags &= ~mask;
+            bench_bus_step();
+        }
+    }
+
+    bench_bus_status();
+
+    return;
+}
+
+/**
+ * @brief host_delay_hook: DELAY_US spins, the bus runs meanwhile
+ * @param cycles SYSCLK cycles of the delay
+ * @return void
+ */
+static void bench_delay(uint32_t cycles) {
+    // A start written before the delay goes on the bus when written
+    bench_bus_step();
+
+    IpcRegs.IPCCOUNTERL += cycles;
+    bench_bus_step();
+
+    return;
+}
+
+/**
+ * @brief Completion callback of the burst read, as update_time_notify
+ */
+static void bench_notify(void) {
+    bench_complete = 1;
+
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t reads = BENCH_READS, n;
+    uint32_t start, polled_cycles = 0, polled_transfers, irq_bus_cycles = 0;
+    uint16_t hours, minutes, seconds, errors = 0;
+    double scl;
+
+    if (argc > 1)
+        reads = strtoul(argv[1], NULL, 10);
+
+    if (reads == 0) {
+        fprintf(stderr, "usage: %s [READS]\n", argv[0]);
+        return 1;
+    }
+
+    host_delay_hook = bench_delay;
+
+    // Module clock and SCL of the firmware (d = 5 with a prescaler above 1)
+    i2c_init();
+    bus.bit_cycles = (I2cbRegs.I2CPSC.all + 1) * (I2cbRegs.I2CCLKL + 5 + I2cbRegs.I2CCLKH + 5);
+    scl = BENCH_CPU_FREQ / bus.bit_cycles;
+
+    printf("I2C-B: module clock %.1f MHz, SCL %.0f kHz (i2c_init), %u reads per mode\n",
+           BENCH_CPU_FREQ / (I2cbRegs.I2CPSC.all + 1) * 1e-6, scl * 1e-3, (unsigned)reads);
+
+    // I2C_READ_POLLED: three single-register reads, the CPU spins throughout
+    bus.transfers = 0;
+    for (n = 0; n < reads; n++) {
+        start = IpcRegs.IPCCOUNTERL;
+        if (ds3231_read_time(&hours, &minutes, &seconds) != I2C_SUCCESS)
+            errors++;
+        polled_cycles += IpcRegs.IPCCOUNTERL - start;
+    }
+    polled_transfers = bus.transfers;
+
+    // I2C_READ_INTERRUPT: one burst, the task sleeps until i2cb_isr completes it
+    bus.transfers = 0;
+    bus.interrupts = 0;
+    for (n = 0; n < reads; n++) {
+        bench_complete = 0;
+
+        if (ds3231_read_time_start(bench_notify) != I2C_SUCCESS) {
+            errors++;
+            continue;
+        }
+
+        start = IpcRegs.IPCCOUNTERL;
+        bench_bus_step();
+
+        while (!bench_complete) {
+            IpcRegs.IPCCOUNTERL += bus.bit_cycles;
+            bench_bus_step();
+        }
+        irq_bus_cycles += IpcRegs.IPCCOUNTERL - start;
+
+        if (ds3231_read_time_result(&hours, &minutes, &seconds) != I2C_SUCCESS)
+            errors++;
+    }
+
+    printf("\nmode          transfers/read  bus (us/read)  CPU waiting (cycles/read)\n");
+    printf("polled        %14.1f  %13.1f  %25.0f\n", (double)polled_transfers / reads,
+           polled_cycles / (double)reads / BENCH_CPU_FREQ * 1e6, polled_cycles / (double)reads);
+    printf("interrupt     %14.1f  %13.1f  %25d\n", (double)bus.transfers / reads,
+           irq_bus_cycles / (double)reads / BENCH_CPU_FREQ * 1e6, 0);
+    printf("\ni2cb_isr entries per read: %.1f. The code of both modes is not timed on the\n"
+           "host; rtc_stats.cycles gives it on the target.\n", (double)bus.interrupts / reads);
+
+    if (errors) {
+        printf("%u reads failed\n", errors);
+        return 1;
+    }
+
+    return 0;
+}
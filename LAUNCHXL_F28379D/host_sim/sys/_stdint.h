@@ -0,0 +1,9 @@
+/**
+ * @file _stdint.h
+ * @brief Stand-in for the TI run-time library header included by
+ *        peripheral_Setup.h
+ * @author Gabriel Del Monte
+ * @date 2025
+ */
+
+#include <stdint.h>
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+@file nn_codegen.py
+@brief Generates F28379D_Project/nn_kernels.h, the fully unrolled forward
+       and training kernels of the Neural Network Approximator
+@author Gabriel Del Monte
+@date 2025
+
+Usage:
+    python3 nn_codegen.py [INPUT-HIDDEN1-HIDDEN2 ...] [-o OUTPUT]
+
+Each topology INPUT-HIDDEN1-HIDDEN2 (single output) produces
+nn_forward_I_H1_H2() and nn_train_I_H1_H2(). The topology configured in
+controllers.h must be in the list; the others are used by the kernel
+benchmark. Re-run after changing INPUT_SIZE, HIDDEN1_SIZE or HIDDEN2_SIZE.
+
+Weights are read from a flat array, layer by layer and neuron by neuron,
+each neuron storing its bias followed by its input weights:
+
+    [b1_0 w1_0_0 .. w1_0_I-1] .. [b2_0 w2_0_0 .. w2_0_H1-1] .. [bo wo_0 ..]
+
+which is the order the forward pass reads them. The generated code keeps
+the operation order of the loop kernels in controllers.c, so both give
+bit-identical results.
+"""
+
+import argparse
+import os
+import sys
+
+DEFAULT_TOPOLOGIES = ["3-3-2", "3-6-4", "3-12-8"]
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "F28379D_Project", "nn_kernels.h")
+
+
+def offsets(n_in, n_h1, n_h2):
+    h1 = lambda x: x * (n_in + 1)
+    h2 = lambda x: n_h1 * (n_in + 1) + x * (n_h1 + 1)
+    out = n_h1 * (n_in + 1) + n_h2 * (n_h1 + 1)
+    return h1, h2, out
+
+
+def forward(n_in, n_h1, n_h2):
+    h1, h2, out = offsets(n_in, n_h1, n_h2)
+    name = "nn_forward_%d_%d_%d" % (n_in, n_h1, n_h2)
+    lines = [
+        "    /**",
+        "     * @brief Forward pass, %d-%d-%d-1 topology" % (n_in, n_h1, n_h2),
+        "     * @param w Flat weight array",
+        "     * @param in The input values",
+        "     * @param h1 Hidden layer 1 activations (output)",
+        "     * @param h2 Hidden layer 2 activations (output)",
+        "     * @return float The output layer pre-activation",
+        "     */",
+        "    static inline float %s(const float *w, const float *in, float *h1, float *h2) {" % name,
+        "        float output;",
+        "",
+        "        // Hidden layer 1",
+    ]
+    for x in range(n_h1):
+        lines.append("        h1[%d] = w[%d];" % (x, h1(x)))
+        for y in range(n_in):
+            lines.append("        h1[%d] += in[%d] * w[%d];" % (x, y, h1(x) + 1 + y))
+        lines.append("        h1[%d] = (h1[%d] > 0.0f) ? h1[%d] : 0.0f;" % (x, x, x))
+    lines += ["", "        // Hidden layer 2"]
+    for x in range(n_h2):
+        lines.append("        h2[%d] = w[%d];" % (x, h2(x)))
+        for y in range(n_h1):
+            lines.append("        h2[%d] += h1[%d] * w[%d];" % (x, y, h2(x) + 1 + y))
+        lines.append("        h2[%d] = (h2[%d] > 0.0f) ? h2[%d] : 0.0f;" % (x, x, x))
+    lines += ["", "        // Output layer", "        output = w[%d];" % out]
+    for x in range(n_h2):
+        lines.append("        output += h2[%d] * w[%d];" % (x, out + 1 + x))
+    lines += ["", "        return output;", "    }"]
+    return lines
+
+
+def train(n_in, n_h1, n_h2):
+    h1, h2, out = offsets(n_in, n_h1, n_h2)
+    name = "nn_train_%d_%d_%d" % (n_in, n_h1, n_h2)
+    lines = [
+        "    /**",
+        "     * @brief Gradient step, %d-%d-%d-1 topology" % (n_in, n_h1, n_h2),
+        "     * @param w Flat weight array",
+        "     * @param in The input values of the forward pass",
+        "     * @param h1 Hidden layer 1 activations of the forward pass",
+        "     * @param h2 Hidden layer 2 activations of the forward pass",
+        "     * @param output The output layer pre-activation",
+        "     * @param error The error value",
+        "     * @return void",
+        "     */",
+        "    static inline void %s(float *w, const float *in, const float *h1, const float *h2, float output, float error) {" % name,
+        "        float delta_h2[%d];" % n_h2,
+        "        float delta_h1, delta_output, sum;",
+        "",
+        "        delta_output = error * (((output > 0.0f) ? output : 0.0f) > 0.0f ? 1.0f : 0.0f);",
+        "",
+        "        // Update output layer",
+    ]
+    for x in range(n_h2):
+        lines.append("        w[%d] += ETA * delta_output * h2[%d];" % (out + 1 + x, x))
+    lines.append("        w[%d] += ETA * delta_output;" % out)
+    lines += ["", "        // Update hidden layer 2"]
+    for x in range(n_h2):
+        lines.append("        delta_h2[%d] = delta_output * w[%d] * (h2[%d] > 0.0f ? 1.0f : 0.0f);"
+                     % (x, out + 1 + x, x))
+        for y in range(n_h1):
+            lines.append("        w[%d] += ETA * delta_h2[%d] * h1[%d];" % (h2(x) + 1 + y, x, y))
+        lines.append("        w[%d] += ETA * delta_h2[%d];" % (h2(x), x))
+    lines += ["", "        // Update hidden layer 1"]
+    for y in range(n_h1):
+        lines.append("        sum = 0.0f;")
+        for x in range(n_h2):
+            lines.append("        sum += delta_h2[%d] * w[%d];" % (x, h2(x) + 1 + y))
+        lines.append("        delta_h1 = sum * (h1[%d] > 0.0f ? 1.0f : 0.0f);" % y)
+        for x in range(n_in):
+            lines.append("        w[%d] += ETA * delta_h1 * in[%d];" % (h1(y) + 1 + x, x))
+        lines.append("        w[%d] += ETA * delta_h1;" % h1(y))
+    lines += ["", "        return;", "    }"]
+    return lines
+
+
+def parse_topology(text):
+    try:
+        sizes = tuple(int(v) for v in text.split("-"))
+    except ValueError:
+        sizes = ()
+    if len(sizes) != 3 or min(sizes) < 1:
+        sys.exit("invalid topology '%s', expected INPUT-HIDDEN1-HIDDEN2" % text)
+    return sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("topologies", nargs="*", default=DEFAULT_TOPOLOGIES)
+    parser.add_argument("-o", "--output", default=DEFAULT_OUTPUT)
+    args = parser.parse_args()
+
+    topologies = []
+    for text in args.topologies:
+        sizes = parse_topology(text)
+        if sizes not in topologies:
+            topologies.append(sizes)
+
+    lines = [
+        "/**",
+        " * @file nn_kernels.h",
+        " * @brief Fully unrolled Neural Network kernels",
+        " *        Generated by tools/nn_codegen.py, do not edit",
+        " *        Topologies: %s" % ", ".join("%d-%d-%d-1" % t for t in topologies),
+        " * @author Gabriel Del Monte",
+        " * @date 2025",
+        " */",
+        "",
+        "#ifndef NN_KERNELS_H",
+        "#define NN_KERNELS_H",
+        "",
+        "    #include \"controllers.h\"",
+        "",
+    ]
+    for n_in, n_h1, n_h2 in topologies:
+        lines += forward(n_in, n_h1, n_h2) + [""] + train(n_in, n_h1, n_h2) + [""]
+
+    lines.append("    // Kernels of the topology configured in controllers.h")
+    for i, (n_in, n_h1, n_h2) in enumerate(topologies):
+        lines += [
+            "    #%s (INPUT_SIZE == %d) && (HIDDEN1_SIZE == %d) && (HIDDEN2_SIZE == %d)"
+            % ("if" if i == 0 else "elif", n_in, n_h1, n_h2),
+            "        #define nn_forward_unrolled nn_forward_%d_%d_%d" % (n_in, n_h1, n_h2),
+            "        #define nn_train_unrolled   nn_train_%d_%d_%d" % (n_in, n_h1, n_h2),
+        ]
+    lines += [
+        "    #else",
+        "        #error \"No unrolled kernel for the configured topology, run tools/nn_codegen.py\"",
+        "    #endif",
+        "",
+        "#endif /* NN_KERNELS_H */",
+        "",
+    ]
+
+    with open(args.output, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+@file profile_dump.py
+@brief Requests and prints the task timing profile of the F28379D
+       (profile.h)
+@author Gabriel Del Monte
+@date 2025
+
+Usage:
+    python3 profile_dump.py --port /dev/ttyUSB0 [--baud 9600] [--timeout SECONDS]
+
+Sends a PROFILE_REQUEST frame and prints the PROFILE and TASK_STATS
+frames of the answer:
+
+    - adcc1_isr and every task loop: runs, deadline misses, last and
+      worst execution time, worst release jitter and both histograms
+    - every FreeRTOS task: state, priority, share of the CPU since the
+      last timebase wrap and free stack
+
+Needs pyserial and the port to itself, so stop the BeagleBone monitor
+first. The board answers at its current rate: SCI_FREQ unless the
+monitor negotiated a faster one (uart_link.h).
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from waveform_decode import HEADER_SIZE, CRC_SIZE, VERSION, crc16, cobs_decode
+
+FRAME_PROFILE_REQUEST = 7
+FRAME_PROFILE = 8
+FRAME_TASK_STATS = 9
+
+PROFILE_SIZE = 60
+TASK_STATS_SIZE = 21
+CPU_FREQ = 200e6
+QUIET = 0.5
+
+SLOTS = ("adcc1_isr", "control", "communication", "update_time",
+         "nn_training", "uart_link", "waveform")
+STATES = ("running", "ready", "blocked", "suspended", "deleted")
+
+
+def cobs_encode(data):
+    output = bytearray()
+    for block in data.split(b"\x00"):
+        for start in range(0, len(block), 254):
+            chunk = block[start:start + 254]
+            output.append(len(chunk) + 1)
+            output += chunk
+        if len(block) % 254 == 0:
+            output.append(1)
+    return bytes(output)
+
+
+def request_frame():
+    body = struct.pack("<BB", (VERSION << 4) | FRAME_PROFILE_REQUEST, 0)
+    body += struct.pack("<H", crc16(body))
+    # Leading delimiter: ends whatever the board received before
+    return b"\x00" + cobs_encode(body) + b"\x00"
+
+
+def us(cycles):
+    return cycles * 1e6 / CPU_FREQ
+
+
+def histogram(counts, shift):
+    width = us(1 << shift)
+    total = sum(counts) or 1
+    rows = []
+    for index, count in enumerate(counts):
+        upper = "+inf" if index == len(counts) - 1 else "%.1f" % (width * (index + 1))
+        rows.append("      %9.1f .. %-9s us %6d %5.1f %%" % (width * index, upper, count, 100.0 * count / total))
+    return "\n".join(rows)
+
+
+def print_profile(payload):
+    slot, buckets, exec_shift, jitter_shift = payload[0:4]
+    period, runs, misses, exec_last, exec_max, jitter_max = struct.unpack_from("<6I", payload, 4)
+    exec_hist = struct.unpack_from("<%dH" % buckets, payload, 28)
+    jitter_hist = struct.unpack_from("<%dH" % buckets, payload, 28 + 2 * buckets)
+
+    name = SLOTS[slot] if slot < len(SLOTS) else "slot %d" % slot
+    print("%s: period %.1f us, %d runs, %d deadline misses" % (name, us(period), runs, misses))
+    if not runs:
+        return
+    print("    execution: last %.2f us, max %.2f us" % (us(exec_last), us(exec_max)))
+    print(histogram(exec_hist, exec_shift))
+    print("    jitter: max %.2f us" % us(jitter_max))
+    print(histogram(jitter_hist, jitter_shift))
+
+
+def print_task(payload):
+    number, state, priority = payload[0:3]
+    name = payload[3:11].rstrip(b"\x00").decode("ascii", "replace")
+    run_time, total, stack = struct.unpack_from("<IIH", payload, 11)
+    share = 100.0 * run_time / total if total else 0.0
+    print("    %2d %-8s %-9s %d %10d us %5.1f %% %5d" % (
+        number, name, STATES[state] if state < len(STATES) else state, priority, run_time, share, stack))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=5.0,
+                        help="seconds to wait for the whole dump")
+    args = parser.parse_args()
+
+    import serial
+
+    slots, tasks = [], []
+    buffer = bytearray()
+    with serial.Serial(args.port, args.baud, timeout=0.1) as line:
+        line.reset_input_buffer()
+        line.write(request_frame())
+
+        # The dump ends when the line stays quiet after the slots
+        end = time.monotonic() + args.timeout
+        last_frame = None
+        while time.monotonic() < end:
+            if len(slots) == len(SLOTS) and time.monotonic() - last_frame > QUIET:
+                break
+            for byte in line.read(4096):
+                if byte:
+                    buffer.append(byte)
+                    continue
+                frame = cobs_decode(bytes(buffer)) if buffer else None
+                buffer.clear()
+                if frame is None or len(frame) < HEADER_SIZE + CRC_SIZE:
+                    continue
+                body, crc = frame[:-CRC_SIZE], frame[-CRC_SIZE:]
+                if crc16(body) != struct.unpack("<H", crc)[0] or body[0] >> 4 != VERSION:
+                    continue
+
+                frame_type, payload = body[0] & 0x0F, body[HEADER_SIZE:]
+                if frame_type == FRAME_PROFILE and len(payload) == PROFILE_SIZE:
+                    slots.append(payload)
+                elif frame_type == FRAME_TASK_STATS and len(payload) == TASK_STATS_SIZE:
+                    tasks.append(payload)
+                else:
+                    continue
+                last_frame = time.monotonic()
+
+    if not slots:
+        sys.exit("no answer from %s at %d baud" % (args.port, args.baud))
+
+    for payload in slots:
+        print_profile(payload)
+    print("tasks:\n    no name     state     p   run time      CPU   stack")
+    for payload in tasks:
+        print_task(payload)
+
+
+if __name__ == "__main__":
+    main()
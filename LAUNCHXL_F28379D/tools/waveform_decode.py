@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""
+@file waveform_decode.py
+@brief Reconstructs the waveforms streamed by the F28379D
+       (WAVEFORM_STREAM_ENABLED) to CSV or binary
+@author Gabriel Del Monte
+@date 2025
+
+Usage:
+    python3 waveform_decode.py CAPTURE [-o OUTPUT] [--format csv|bin]
+    python3 waveform_decode.py --port /dev/ttyUSB0 [--baud 230400]
+                               [--duration SECONDS] [-o OUTPUT]
+
+CAPTURE is a raw recording of the SCI-C line, e.g.
+    stty -F /dev/ttyUSB0 230400 raw && cat /dev/ttyUSB0 > capture.bin
+Reading --port directly needs pyserial.
+
+Frames are the telemetry frames of telemetry.h: COBS encoded, 0x00
+terminated, CRC16-CCITT checked. Waveform blocks (waveform.h) are
+expanded to one row per sample:
+
+    index, time_s, voltage_code, current_code, cmpa, voltage, current, duty
+
+Codes are scaled with the factors of the last INFO frame (the firmware
+constants until one arrives). --format bin writes the rows as
+little-endian float64, 8 per sample (numpy.fromfile(path, "<f8")
+.reshape(-1, 8)).
+
+Missing sample indices are reported on stderr, split into samples the
+firmware dropped because the link could not keep up and samples lost
+with corrupted frames.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+FRAME_INFO = 0
+FRAME_STATUS = 1
+FRAME_WAVEFORM = 2
+
+VERSION = 2
+HEADER_SIZE = 2
+CRC_SIZE = 2
+WAVEFORM_HEADER_SIZE = 11
+CODE_BITS = 12
+WIDTH_BITS = 4
+CHANNELS = 3
+
+# Firmware constants (peripheral_Setup.h), replaced by INFO frames
+DEFAULT_SCALES = {"voltage": 0.0060, "current": 0.6300, "pwm_period": 2500}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    output = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        output += data[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(data):
+            output.append(0)
+    return bytes(output)
+
+
+class BitReader:
+    """LSB first bit stream, the order waveform.c writes it"""
+
+    def __init__(self, data):
+        self.value = int.from_bytes(data, "little")
+        self.position = 0
+        self.size = len(data) * 8
+
+    def get(self, width):
+        if self.position + width > self.size:
+            raise ValueError("bit stream too short")
+        value = (self.value >> self.position) & ((1 << width) - 1)
+        self.position += width
+        return value
+
+
+def unzigzag(value):
+    return (value >> 1) if not value & 1 else -((value + 1) >> 1)
+
+
+def decode_block(payload):
+    """Returns (first index, dropped total, period in s, [(v, i, cmpa), ...])"""
+    if len(payload) < WAVEFORM_HEADER_SIZE:
+        raise ValueError("short waveform header")
+    first, dropped, period, count = struct.unpack_from("<IIHB", payload)
+    reader = BitReader(payload[WAVEFORM_HEADER_SIZE:])
+
+    widths = [reader.get(WIDTH_BITS) for _ in range(CHANNELS)]
+    sample = [reader.get(CODE_BITS) for _ in range(CHANNELS)]
+    samples = [tuple(sample)]
+    for _ in range(count - 1):
+        sample = [(code + unzigzag(reader.get(width))) & 0xFFFF
+                  for code, width in zip(sample, widths)]
+        samples.append(tuple(sample))
+
+    return first, dropped, period * 100e-9, samples
+
+
+class Decoder:
+    def __init__(self, writer):
+        self.writer = writer
+        self.buffer = bytearray()
+        self.scales = dict(DEFAULT_SCALES)
+        self.last_sequence = None
+        self.next_index = None
+        self.first_dropped = None
+        self.stats = {"frames": 0, "crc_errors": 0, "framing_errors": 0,
+                      "lost_frames": 0, "samples": 0, "missing": 0,
+                      "dropped": 0}
+
+    def feed(self, data):
+        for byte in data:
+            if byte:
+                self.buffer.append(byte)
+            elif self.buffer:
+                self.frame(bytes(self.buffer))
+                self.buffer.clear()
+
+    def frame(self, encoded):
+        frame = cobs_decode(encoded)
+        if frame is None or len(frame) < HEADER_SIZE + CRC_SIZE:
+            self.stats["framing_errors"] += 1
+            return
+        body, crc = frame[:-CRC_SIZE], frame[-CRC_SIZE:]
+        if crc16(body) != struct.unpack("<H", crc)[0]:
+            self.stats["crc_errors"] += 1
+            return
+        if body[0] >> 4 != VERSION:
+            self.stats["framing_errors"] += 1
+            return
+
+        sequence = body[1]
+        if self.last_sequence is not None:
+            self.stats["lost_frames"] += (sequence - self.last_sequence - 1) & 0xFF
+        self.last_sequence = sequence
+        self.stats["frames"] += 1
+
+        frame_type, payload = body[0] & 0x0F, body[HEADER_SIZE:]
+        if frame_type == FRAME_INFO and len(payload) == 18:
+            _, voltage, current, _, pwm_period = struct.unpack("<ffffH", payload)
+            self.scales = {"voltage": voltage, "current": current, "pwm_period": pwm_period}
+        elif frame_type == FRAME_WAVEFORM:
+            try:
+                self.block(*decode_block(payload))
+            except ValueError:
+                self.stats["framing_errors"] += 1
+
+    def block(self, first, dropped, period, samples):
+        if self.next_index is not None and first > self.next_index:
+            self.stats["missing"] += first - self.next_index
+        self.next_index = first + len(samples)
+        if self.first_dropped is None:
+            self.first_dropped = dropped
+        self.stats["dropped"] = dropped - self.first_dropped
+        self.stats["samples"] += len(samples)
+
+        pwm_period = self.scales["pwm_period"] or 1
+        for offset, (voltage, current, cmpa) in enumerate(samples):
+            index = first + offset
+            self.writer.write(index, index * period, voltage, current, cmpa,
+                              voltage * self.scales["voltage"],
+                              current * self.scales["current"],
+                              cmpa / pwm_period)
+
+
+class CsvWriter:
+    def __init__(self, stream):
+        self.stream = stream
+        stream.write("index,time_s,voltage_code,current_code,cmpa,voltage,current,duty\n")
+
+    def write(self, index, t, voltage_code, current_code, cmpa, voltage, current, duty):
+        self.stream.write("%d,%.7f,%d,%d,%d,%.4f,%.4f,%.5f\n"
+                          % (index, t, voltage_code, current_code, cmpa, voltage, current, duty))
+
+
+class BinaryWriter:
+    def __init__(self, stream):
+        self.stream = stream
+
+    def write(self, *row):
+        self.stream.write(struct.pack("<8d", *row))
+
+
+def read_port(port, baud, duration):
+    import serial
+
+    with serial.Serial(port, baud, timeout=0.1) as line:
+        end = time.monotonic() + duration if duration else None
+        while end is None or time.monotonic() < end:
+            data = line.read(4096)
+            if data:
+                yield data
+
+
+def read_file(path):
+    with open(path, "rb") as capture:
+        while True:
+            data = capture.read(65536)
+            if not data:
+                return
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("capture", nargs="?", help="raw capture of the line")
+    parser.add_argument("--port", help="serial port to read instead of a capture")
+    parser.add_argument("--baud", type=int, default=230400)
+    parser.add_argument("--duration", type=float, default=0.0,
+                        help="seconds to read from --port, 0 until Ctrl+C")
+    parser.add_argument("-o", "--output", default="-")
+    parser.add_argument("--format", choices=("csv", "bin"), default="csv")
+    args = parser.parse_args()
+
+    if (args.capture is None) == (args.port is None):
+        parser.error("give either CAPTURE or --port")
+
+    binary = args.format == "bin"
+    if args.output == "-":
+        stream = sys.stdout.buffer if binary else sys.stdout
+    else:
+        stream = open(args.output, "wb" if binary else "w")
+
+    decoder = Decoder(BinaryWriter(stream) if binary else CsvWriter(stream))
+    source = read_port(args.port, args.baud, args.duration) if args.port else read_file(args.capture)
+    try:
+        for data in source:
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if stream not in (sys.stdout, sys.stdout.buffer):
+            stream.close()
+
+    stats = decoder.stats
+    sys.stderr.write(
+        "%d frames, %d samples; %d CRC errors, %d framing errors, %d frames lost\n"
+        "%d samples missing: %d dropped by the firmware (link too slow), %d lost on the line\n"
+        % (stats["frames"], stats["samples"], stats["crc_errors"], stats["framing_errors"],
+           stats["lost_frames"], stats["missing"], stats["dropped"],
+           max(stats["missing"] - stats["dropped"], 0)))
+
+
+if __name__ == "__main__":
+    main()